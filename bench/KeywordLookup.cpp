@@ -0,0 +1,53 @@
+/**
+ * Keyword lookup microbenchmark: linear scan of `keywords` and `operators` (old lexer)
+ * against perfect hash lookup of `find_word`.
+ *
+ * Build: g++ -std=c++20 -O2 -Isrc bench/KeywordLookup.cpp -o keyword_lookup
+ */
+
+#include "Token.h"
+
+#include <chrono>
+#include <iostream>
+
+int main(){
+	const std::vector <std::string> pool {
+		"value", "x", "counter", "if", "return", "index", "foo_bar", "while",
+		"is", "total", "func", "$tmp", "elif", "result", "true"
+	};
+	std::vector <std::string> ids;
+	for(uint32_t i = 0; i < 2000000; i++){
+		ids.push_back(pool[(i * 7) % pool.size()]);
+	}
+
+	// Note: Results are accumulated so loops are not optimized away
+	uint64_t acc = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+	for(const auto & id : ids){
+		acc += std::distance(keywords.begin(), std::find(keywords.begin(), keywords.end(), id));
+		acc += std::distance(operators.begin(), std::find(operators.begin(), operators.end(), id));
+	}
+	const auto linear_end = std::chrono::steady_clock::now();
+	for(const auto & id : ids){
+		const Word * word = find_word(id);
+		acc += word ? word->val : 1;
+	}
+	const auto hash_end = std::chrono::steady_clock::now();
+
+	const std::chrono::duration <double, std::milli> linear = linear_end - start;
+	const std::chrono::duration <double, std::milli> hash = hash_end - linear_end;
+	std::cout << ids.size() << " lookups\n"
+			  << "Linear scan: " << linear.count() << "ms\n"
+			  << "Perfect hash: " << hash.count() << "ms\n"
+			  << "(checksum " << acc % 7 << ")\n";
+
+	// Keywords that are lexed as other tokens must still be keywords
+	for(const auto & kw : keywords){
+		if(!is_kw(kw)){
+			std::cout << "is_kw(\"" << kw << "\") is false\n";
+			return 1;
+		}
+	}
+	return 0;
+}
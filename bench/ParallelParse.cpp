@@ -0,0 +1,99 @@
+/**
+ * Parallel parsing benchmark: sequential `Parser::parse` against `ParallelParser::parse` with given count of threads
+ * on the same tokens (best of several runs), trees are compared so speedup is not measured on a different result.
+ *
+ * Usage: parallel_parse <threads> [file], without file the code is generated (functions with loops and expressions).
+ * Build: g++ -std=c++20 -O2 -Isrc bench/ParallelParse.cpp src/ParallelParser.cpp src/StatementSplit.cpp src/Parser.cpp \
+ *        src/Lexer.cpp src/Node.cpp src/Object.cpp src/Heap.cpp src/Source.cpp src/Interner.cpp src/LineIndex.cpp \
+ *        src/Trace.cpp src/Arena.cpp src/HashCons.cpp src/FlatTree.cpp -pthread -o parallel_parse
+ */
+
+#include "Lexer.h"
+#include "Parser.h"
+#include "ParallelParser.h"
+#include "Source.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+static const int RUNS = 5;
+
+static std::string generate_code(){
+	std::string code;
+	for(uint32_t i = 0; i < 20000; i++){
+		const std::string n = std::to_string(i);
+		code += "func f" + n + "(a, b){\n"
+				"\tvar s = a * " + n + " + b\n"
+				"\twhile(s < 100){\n"
+				"\t\tif(s % 3 == 0){ s += [1, 2, a][2] }else{ s = s + b * (a - 1) }\n"
+				"\t}\n"
+				"\treturn s\n"
+				"}\n"
+				"val v" + n + " = f" + n + "(" + n + ", 2)\n";
+	}
+	return code;
+}
+
+static std::string dump(const StatementList & tree){
+	std::string str;
+	for(NStatement * statement : tree){
+		str += statement->to_string() + "\n";
+	}
+	return str;
+}
+
+// Best time of `RUNS` runs in milliseconds, `tree` is the result of the last run
+template <class F>
+static double best_time(const F & parse, StatementList & tree){
+	double best = 0;
+	for(int i = 0; i < RUNS; i++){
+		const auto start = std::chrono::steady_clock::now();
+		tree = parse();
+		const std::chrono::duration <double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		if(i == 0 || elapsed.count() < best){
+			best = elapsed.count();
+		}
+	}
+	return best;
+}
+
+int main(int argc, char ** argv){
+	if(argc < 2){
+		std::cout << "Usage: parallel_parse <threads> [file]" << std::endl;
+		return 1;
+	}
+	const uint32_t threads = std::stoul(argv[1]);
+
+	Source source;
+	std::string generated;
+	std::string_view code;
+	if(argc > 2){
+		source.open(argv[2]);
+		code = source.view();
+	}else{
+		generated = generate_code();
+		code = generated;
+	}
+
+	Lexer lexer;
+	const std::vector <Token> tokens = lexer.lex(code);
+
+	Parser parser;
+	ParallelParser parallel_parser(threads);
+	StatementList sequential_tree;
+	StatementList parallel_tree;
+	const double sequential = best_time([&](){ return parser.parse(tokens, code); }, sequential_tree);
+	const double parallel = best_time([&](){ return parallel_parser.parse(tokens, code); }, parallel_tree);
+
+	std::cout << tokens.size() << " tokens, " << threads << " threads (hardware concurrency "
+			  << std::thread::hardware_concurrency() << ")\n"
+			  << "Sequential: " << sequential << "ms\n"
+			  << "Parallel: " << parallel << "ms, speedup " << sequential / parallel << "x\n";
+
+	if(dump(sequential_tree) != dump(parallel_tree)){
+		std::cout << "Trees differ" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * Heap allocations per token of lexing, token lookahead and parsing, each stage counted separately.
+ *
+ * Lookahead stage runs the recognizer pattern of parser (several `peek` checks and one `advance` per token)
+ * over already lexed tokens: with tokens borrowed and returned by reference (as Parser does), returned by value,
+ * and on a copy of token vector with tokens returned by value (old path of Parser).
+ *
+ * Build: g++ -std=c++20 -O2 -Isrc bench/TokenAllocations.cpp src/Parser.cpp src/Lexer.cpp src/Node.cpp \
+ *        src/Object.cpp src/Heap.cpp src/Source.cpp src/Interner.cpp src/LineIndex.cpp src/Trace.cpp \
+ *        src/Arena.cpp src/HashCons.cpp src/FlatTree.cpp -o token_allocations
+ */
+
+#include "Lexer.h"
+#include "Parser.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+static uint64_t allocations = 0;
+
+void * operator new(size_t size){
+	allocations++;
+	void * ptr = std::malloc(size ? size : 1);
+	if(!ptr){
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+void operator delete(void * ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void * ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+const std::string snippet =
+	"val list = [1, 2, 3]\n"
+	"func sum(a, b){\n"
+	"	return a + b * 2\n"
+	"}\n"
+	"var total = 0\n"
+	"for(item in list){\n"
+	"	if(item > 1 && total != 10){\n"
+	"		total += sum(item, total)\n"
+	"	}elif(item == 0){\n"
+	"		print(\"zero\")\n"
+	"	}\n"
+	"}\n";
+
+// Lookahead with recognizers like `Parser::is_op` or `Parser::is_kw`
+template <class PeekResult>
+uint64_t lookahead(std::span <const Token> tokens, std::string_view code){
+	TokenVector source(tokens, code);
+	TokenStream stream;
+	stream.reset(&source);
+	auto peek = [&]() -> PeekResult { return stream.peek(); };
+
+	uint64_t hits = 0;
+	while(peek().type != T_PROG_END){
+		hits += (peek().type == T_ENDL) + (peek().type == T_OP) + (peek().type == T_KW)
+			  + (peek().type == T_OP && peek().op() == OP_ASSIGN) + (peek().type == T_ID);
+		PeekResult token = stream.advance();
+		hits += token.offset & 1;
+	}
+	return hits;
+}
+
+template <class F>
+void measure(const std::string & name, const uint64_t & tokens_count, F && f){
+	const uint64_t before = allocations;
+	const auto start = std::chrono::steady_clock::now();
+	f();
+	const std::chrono::duration <double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	const uint64_t count = allocations - before;
+	std::cout << name << ": " << count << " allocations, "
+			  << static_cast<double>(count) / tokens_count << " per token, " << elapsed.count() << "ms\n";
+}
+
+int main(){
+	std::string code;
+	for(uint32_t i = 0; i < 20000; i++){
+		code += snippet;
+	}
+
+	std::vector <Token> tokens;
+	{
+		// Warm up interner, so measured lexing allocates only for tokens vector
+		Lexer lexer;
+		tokens = lexer.lex(code);
+	}
+	const uint64_t tokens_count = tokens.size();
+	std::cout << code.size() / 1024 << "KB, " << tokens_count << " tokens\n";
+
+	measure("Lexing to vector", tokens_count, [&](){
+		Lexer lexer;
+		tokens = lexer.lex(code);
+	});
+
+	uint64_t hits = 0;
+	// Note: Old path of Parser copied the token vector and returned tokens by value
+	measure("Lookahead by reference on borrowed tokens", tokens_count, [&](){
+		hits += lookahead<const Token &>(tokens, code);
+	});
+	measure("Lookahead by value on borrowed tokens", tokens_count, [&](){
+		hits += lookahead<Token>(tokens, code);
+	});
+	measure("Lookahead by value on copied tokens", tokens_count, [&](){
+		const std::vector <Token> copy = tokens;
+		hits += lookahead<Token>(copy, code);
+	});
+
+	measure("Parsing pulled from lexer (lexing included)", tokens_count, [&](){
+		Lexer lexer;
+		lexer.open(code);
+		Parser parser;
+		hits += parser.parse(lexer).size();
+	});
+
+	std::cout << "(checksum " << hits % 7 << ")\n";
+	return 0;
+}
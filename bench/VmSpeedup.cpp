@@ -0,0 +1,83 @@
+/**
+ * Speedup of VM against tree walker: each program is parsed once and run by both, best of several runs is taken.
+ * Programs are loops on globals, loops on locals of function and calls (they print their result once).
+ *
+ * Build: g++ -std=c++20 -O2 -Isrc bench/VmSpeedup.cpp src/Compiler.cpp src/VM.cpp src/Bytecode.cpp \
+ *        src/Resolver.cpp src/Parser.cpp src/Lexer.cpp src/Node.cpp src/Object.cpp src/Heap.cpp src/Source.cpp \
+ *        src/Interner.cpp src/LineIndex.cpp src/Trace.cpp src/Arena.cpp src/HashCons.cpp src/FlatTree.cpp -o vm_speedup
+ */
+
+#include "Lexer.h"
+#include "Parser.h"
+#include "Resolver.h"
+#include "Compiler.h"
+#include "VM.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+static const int RUNS = 20;
+static const double TARGET_SPEEDUP = 10;
+
+static void run_walker(const StatementList & tree){
+	Resolver resolver;
+	const std::vector <Symbol> global_names = resolver.resolve(tree);
+	Scope * global = heap().make<Scope>(nullptr, global_names.size());
+	heap().add_root(global);
+	const std::vector <NativeFunc*> & builtin_funcs = builtins();
+	for(size_t i = 0; i < builtin_funcs.size(); i++){
+		global->define(i, Value::object(builtin_funcs[i]));
+	}
+	for(NStatement * statement : tree){
+		heap().safepoint();
+		statement->eval(global);
+	}
+	heap().remove_root(global);
+}
+
+static void run_vm(const StatementList & tree){
+	Compiler compiler;
+	Program program = compiler.compile(tree);
+	VM vm;
+	vm.run(program);
+}
+
+// Time of one run in milliseconds
+template <class F>
+static double run_time(const F & run){
+	const auto start = std::chrono::steady_clock::now();
+	run();
+	const std::chrono::duration <double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+int main(){
+	const std::vector <std::pair <std::string, std::string>> programs {
+		{"globals", "var i = 0\nvar s = 0\nwhile(i < 3000000){\n\ts = s + i * 2\n\ti += 1\n}\nprint(s)\n"},
+		{"locals", "func sum(n){\n\tvar i = 0\n\tvar s = 0\n\twhile(i < n){\n\t\tif(i % 3 == 0){\n\t\t\ts = s + i\n\t\t}\n"
+				   "\t\ti += 1\n\t}\n\treturn s\n}\nprint(sum(3000000))\n"},
+		{"calls", "func fib(n){\n\tif(n < 2){\n\t\treturn n\n\t}\n\treturn fib(n - 1) + fib(n - 2)\n}\nprint(fib(27))\n"},
+	};
+
+	for(const auto & [name, code] : programs){
+		Lexer lexer;
+		Parser parser;
+		lexer.open(code);
+		const StatementList tree = parser.parse(lexer);
+
+		// Note: Runs of walker and VM are interleaved, so slowdown of machine in the middle affects both
+		double walker = 0;
+		double vm = 0;
+		for(int i = 0; i < RUNS; i++){
+			const double walker_run = run_time([&](){ run_walker(tree); });
+			const double vm_run = run_time([&](){ run_vm(tree); });
+			walker = i == 0 ? walker_run : std::min(walker, walker_run);
+			vm = i == 0 ? vm_run : std::min(vm, vm_run);
+		}
+		std::cerr << name << ": walker " << walker << "ms, VM " << vm << "ms, speedup " << walker / vm << "x (target "
+				  << TARGET_SPEEDUP << "x)\n";
+	}
+
+	return 0;
+}
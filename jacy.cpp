@@ -1,5 +1,12 @@
 #include "src/Lexer.h"
+#include "src/ParallelLexer.h"
 #include "src/Parser.h"
+#include "src/ParallelParser.h"
+#include "src/Trace.h"
+#include "src/AstCache.h"
+#include "src/Compiler.h"
+#include "src/Resolver.h"
+#include "src/VM.h"
 
 #include <iostream>
 #include <chrono>
@@ -8,36 +15,244 @@
 // TODO: Add special numbers like hex and exp and etc. //
 //////
 
+// Run program with tree walker or VM, returns exit code
+// Note: VM compiles flat tree if it's given (e.g. loaded from AST cache), otherwise pointer tree
+static int run_program(const StatementList & tree, const FlatTree * flat, const bool & use_vm, const LineIndex & lines, const bool & gc_stats){
+	// Note: Program output goes to stdout, so time is written to stderr
+	auto run_start = std::chrono::high_resolution_clock::now();
+	std::string stage = use_vm ? "Compiler" : "Resolver";
+	try{
+		if(use_vm){
+			Compiler compiler;
+			Program program = flat ? compiler.compile(*flat) : compiler.compile(tree);
+			stage = "Runtime";
+			VM vm;
+			vm.run(program);
+		}else{
+			Resolver resolver;
+			const std::vector <Symbol> global_names = resolver.resolve(tree);
+			stage = "Runtime";
+			Scope * global = heap().make<Scope>(nullptr, global_names.size());
+			heap().add_root(global);
+			const std::vector <NativeFunc*> & builtin_funcs = builtins();
+			for(size_t i = 0; i < builtin_funcs.size(); i++){
+				global->define(i, Value::object(builtin_funcs[i]));
+			}
+			for(NStatement * statement : tree){
+				heap().safepoint();
+				statement->eval(global);
+				if(global->is_returned()){
+					break;
+				}
+			}
+		}
+	}catch(const RuntimeError & e){
+		std::cout.flush();
+		const std::string msg = stage + " [ERROR]: " + e.msg;
+		if(e.offset == NO_OFFSET){
+			std::cerr << "\e[0;31m" << msg << std::endl;
+		}else{
+			const Position pos = lines.position(e.offset);
+			std::cerr << error_str(msg, pos.line, pos.column) << std::endl;
+		}
+		return 1;
+	}
+	std::cout.flush();
+	std::chrono::duration<double> run_elapsed = std::chrono::high_resolution_clock::now() - run_start;
+	std::cerr << "Execution was done in: " << static_cast<int>(run_elapsed.count() * 1e3) << "ms" << std::endl;
+	if(gc_stats){
+		std::cerr << heap().get_stats().to_string() << std::endl;
+	}
+	return 0;
+}
+
 int main(int argc, char const * argv[]){
 
-	if(argc < 2){
+	const char * path = nullptr;
+	bool parallel_lex = false;
+	bool parallel_parse = false;
+	bool check = false;
+	bool hash_cons = false;
+	bool use_cache = false;
+	bool run = false;
+	bool use_vm = false;
+	bool gc_stats = false;
+	std::string cache_dir;
+
+	for(int i = 1; i < argc; i++){
+		const std::string arg = argv[i];
+		if(arg == "--parallel-lex"){
+			parallel_lex = true;
+		}else if(arg == "--parallel-parse"){
+			parallel_parse = true;
+		}else if(arg == "--check"){
+			// Note: Report all syntax errors instead of stopping on the first one
+			check = true;
+		}else if(arg == "--hash-cons"){
+			// Note: Share identical literals, types and pure expressions between nodes
+			hash_cons = true;
+		}else if(arg == "--run"){
+			// Note: Run program with tree walker instead of printing tokens and tree
+			run = true;
+		}else if(arg == "--vm"){
+			// Note: Run program compiled to bytecode
+			run = true;
+			use_vm = true;
+		}else if(arg == "--gc-stats"){
+			// Note: Print pauses and heap size of garbage collector after execution
+			gc_stats = true;
+		}else if(arg == "--no-generational"){
+			// Note: Each collection marks and sweeps the whole heap
+			heap().set_generational(false);
+		}else if(arg == "--cache"){
+			use_cache = true;
+		}else if(arg.rfind("--cache-dir=", 0) == 0){
+			use_cache = true;
+			cache_dir = arg.substr(12);
+		}else if(arg == "--trace"){
+			Trace::configure(TL_VERBOSE, TC_ALL);
+		}else if(arg.rfind("--trace=", 0) == 0){
+			// Note: Categories list, e.g. `--trace=lexer,parser`
+			uint32_t categories = 0;
+			const std::string list = arg.substr(8);
+			if(list.find("lexer") != std::string::npos) categories |= TC_LEXER;
+			if(list.find("parser") != std::string::npos) categories |= TC_PARSER;
+			if(list.find("eval") != std::string::npos) categories |= TC_EVAL;
+			if(list.find("gc") != std::string::npos) categories |= TC_GC;
+			Trace::configure(TL_VERBOSE, categories);
+		}else{
+			path = argv[i];
+		}
+	}
+
+	if(!path){
 		std::cout << "Please, specify path to input file" << std::endl;
 		return -1;
 	}
 
+	// Note: ParallelParser has no error recovery and doesn't share nodes, and cached tree is not lexed or parsed,
+	// so these flags fall back to sequential lexing and parsing (with a warning instead of silently)
+	if(parallel_parse && (check || hash_cons)){
+		std::cerr << "Warning: `--parallel-parse` is ignored with `" << (check ? "--check" : "--hash-cons") << "`" << std::endl;
+		parallel_parse = false;
+	}
+	if(use_cache && (parallel_lex || parallel_parse)){
+		std::cerr << "Warning: `" << (parallel_lex ? "--parallel-lex" : "--parallel-parse") << "` is ignored with `--cache`" << std::endl;
+		parallel_lex = false;
+		parallel_parse = false;
+	}
+
 	try{
 		Lexer lexer;
+		ParallelLexer parallel_lexer;
 		Parser parser;
-		
-		
+		ParallelParser parallel_parser;
+		// Note: Programs are never run on shared nodes: Resolver stores slots in identifiers
+		// and shared node has the offset of its first occurrence, so runtime errors would point to it
+		parser.set_hash_consing(hash_cons && !run);
+
+		if(use_cache){
+			// Note: Warm start skips lexing and parsing, tree is loaded from AST cache
+			auto start = std::chrono::high_resolution_clock::now();
+
+			Source source;
+			source.open(path);
+			AstCache cache(cache_dir);
+			FlatTree tree;
+			const bool hit = cache.load(path, source.view(), tree);
+			if(!hit){
+				lexer.open(source.view());
+				tree = parser.parse_flat(lexer);
+				cache.store(path, source.view(), tree);
+			}
+
+			auto finish = std::chrono::high_resolution_clock::now();
+
+			if(run){
+				LineIndex lines;
+				lines.build(source.view());
+				// Note: Tree walker needs pointer tree, VM compiles flat tree as is
+				Arena arena;
+				StatementList nodes;
+				if(!use_vm){
+					nodes = tree.to_nodes(arena);
+				}
+				return run_program(nodes, &tree, use_vm, lines, gc_stats);
+			}
+
+			std::cout << "\nTree:\n";
+			for(const NodeIndex & root : tree.get_roots()){
+				std::cout << tree.to_string(root) << std::endl;
+			}
+
+			std::chrono::duration<double> elapsed = finish - start;
+			std::cout << (hit ? "Loaded from cache in: " : "Parsed and cached in: ")
+					  << static_cast<int>(elapsed.count() * 1e3) << "ms" << std::endl;
+
+			return 0;
+		}
+
 		// Lexing
 		auto lexer_start = std::chrono::high_resolution_clock::now();
-		std::vector <Token> tokens = lexer.lex(argv[1]);
+		std::vector <Token> tokens;
+		std::string_view code;
+		// Note: Tokens are not printed when program is run, so Parser pulls them from Lexer and code is lexed once
+		const bool stream_tokens = run && !parallel_lex && !parallel_parse;
+		if(parallel_lex){
+			tokens = parallel_lexer.lex(path);
+			code = parallel_lexer.get_code();
+		}else if(stream_tokens){
+			lexer.open(path);
+			code = lexer.get_code();
+		}else{
+			tokens = lexer.lex(path);
+			code = lexer.get_code();
+		}
 		auto lexer_finish = std::chrono::high_resolution_clock::now();
 
-		std::cout << "Tokens:\n";
-		for(auto & t : tokens){
-			std::cout << t.to_string(true) << std::endl;
+		LineIndex lines;
+		lines.build(code);
+		if(!run){
+			std::cout << "Tokens:\n";
+			for(auto & t : tokens){
+				std::cout << t.to_string(code, lines) << std::endl;
+			}
 		}
 
 		// Parsing
-		
-		std::cout << "\nParsing...\n";
+		// Note: Parser pulls tokens from Lexer itself, so parsing time includes lexing
+		// (if code was not lexed in parallel and is not parsed in parallel)
+
+		if(!run){
+			std::cout << "\nParsing...\n";
+		}
 
 		auto parser_start = std::chrono::high_resolution_clock::now();
-		StatementList tree = parser.parse(tokens);
+		parser.set_recovery(check);
+		StatementList tree;
+		if(parallel_parse){
+			tree = parallel_parser.parse(tokens, code);
+		}else if(stream_tokens){
+			tree = parser.parse(lexer);
+		}else if(parallel_lex || run){
+			tree = parser.parse(tokens, code);
+		}else{
+			lexer.open(path);
+			tree = parser.parse(lexer);
+		}
 		auto parser_finish = std::chrono::high_resolution_clock::now();
 
+		if(run){
+			if(!parser.get_diagnostics().empty()){
+				for(const Diagnostic & diagnostic : parser.get_diagnostics()){
+					std::cerr << diagnostic.to_string() << std::endl;
+				}
+				return 1;
+			}
+
+			return run_program(tree, nullptr, use_vm, lines, gc_stats);
+		}
+
 		std::cout << "\nTree:\n";
 		for(NStatement * t : tree){
 			std::cout << t->to_string() << std::endl;
@@ -50,6 +265,17 @@ int main(int argc, char const * argv[]){
 		int parser_ms = parser_elapsed.count() * 10e3;
 		std::cout << "Lexing was done in: " << lexer_ms << "ms" << std::endl;
 		std::cout << "Parsing was done in: " << parser_ms << "ms" << std::endl;
+		if(hash_cons){
+			std::cout << "AST memory: " << parser.memory_used() / 1024 << "KB, shared nodes: "
+					  << parser.get_shared_nodes().size() << " (reused " << parser.get_shared_nodes().hits() << " times)" << std::endl;
+		}
+
+		if(!parser.get_diagnostics().empty()){
+			for(const Diagnostic & diagnostic : parser.get_diagnostics()){
+				std::cerr << diagnostic.to_string() << std::endl;
+			}
+			return 1;
+		}
 
 	}catch(const std::invalid_argument & e){
 		std::cerr << "invalid_argument: " << e.what() << std::endl;
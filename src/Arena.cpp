@@ -0,0 +1,57 @@
+#include "Arena.h"
+
+Arena::Arena(){
+	cursor = nullptr;
+	chunk_end = nullptr;
+	used_bytes = 0;
+	finalizers = nullptr;
+}
+
+Arena::~Arena(){
+	run_finalizers();
+}
+
+void * Arena::allocate(const size_t & size, const size_t & align){
+	// Note: `align` is always power of 2
+	uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(align - 1);
+	if(cursor == nullptr || aligned + size > reinterpret_cast<uintptr_t>(chunk_end)){
+		new_chunk(size + align);
+		aligned = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(align - 1);
+	}
+
+	char * ptr = reinterpret_cast<char*>(aligned);
+	used_bytes += ptr + size - cursor;
+	cursor = ptr + size;
+
+	return ptr;
+}
+
+void Arena::new_chunk(const size_t & min_size){
+	// Note: Big objects get their own chunk
+	const size_t size = min_size > CHUNK_SIZE ? min_size : CHUNK_SIZE;
+	chunks.emplace_back(new char[size]);
+	cursor = chunks.back().get();
+	chunk_end = cursor + size;
+}
+
+void Arena::clear(){
+	run_finalizers();
+
+	if(chunks.empty()){
+		return;
+	}
+
+	// Keep the first chunk, so parsing of the next file doesn't start with allocation
+	chunks.resize(1);
+	cursor = chunks[0].get();
+	chunk_end = cursor + CHUNK_SIZE;
+	used_bytes = 0;
+}
+
+void Arena::run_finalizers(){
+	while(finalizers){
+		Finalizer * next = finalizers->next;
+		finalizers->destroy(finalizers->object);
+		finalizers = next;
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+// Arena is a bump allocator, objects are placed contiguously in allocation order
+// and all of them are freed at once by `clear()` or when Arena is destroyed.
+// Note: Destructor is called only for objects that need it (e.g. nodes with lists),
+// trivially destructible objects are just dropped with their chunk
+class Arena {
+	public:
+		Arena();
+		virtual ~Arena();
+
+		Arena(const Arena &) = delete;
+		Arena & operator=(const Arena &) = delete;
+
+		template <class T, class ...Args>
+		T * make(Args && ...args){
+			if constexpr(std::is_trivially_destructible_v<T>){
+				return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			}else{
+				// Note: Finalizer is placed before the object, so it's freed with it
+				Finalizer * finalizer = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+				T * object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+				finalizer->destroy = [](void * ptr){
+					static_cast<T*>(ptr)->~T();
+				};
+				finalizer->object = object;
+				finalizer->next = finalizers;
+				finalizers = finalizer;
+				return object;
+			}
+		}
+
+		void * allocate(const size_t & size, const size_t & align);
+
+		// Free all objects, the first chunk is kept for reuse
+		void clear();
+
+		// Bytes allocated from chunks
+		size_t used() const {
+			return used_bytes;
+		}
+
+	private:
+		static const uint32_t CHUNK_SIZE = 64 * 1024;
+		std::vector <std::unique_ptr<char[]>> chunks;
+		char * cursor;
+		char * chunk_end;
+		size_t used_bytes;
+		void new_chunk(const size_t & min_size);
+
+		struct Finalizer {
+			void (*destroy)(void*);
+			void * object;
+			Finalizer * next;
+		};
+		Finalizer * finalizers;
+		void run_finalizers();
+};
+
+#endif
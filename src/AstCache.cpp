@@ -0,0 +1,216 @@
+#include "AstCache.h"
+#include "Source.h"
+
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+static const char AST_CACHE_MAGIC[4] = {'J', 'A', 'S', 'T'};
+
+AstCache::AstCache(const std::string & dir) : dir(dir) {}
+
+std::string AstCache::cache_path(const char * path){
+	if(dir.empty()){
+		return std::string(path) + ".astc";
+	}
+	// Note: Scripts with the same name in different directories get different cache files
+	const std::string full_path = std::filesystem::absolute(path).string();
+	char hash_str[17];
+	snprintf(hash_str, sizeof(hash_str), "%016llx", static_cast<unsigned long long>(hash(full_path)));
+	return (std::filesystem::path(dir) / (std::filesystem::path(path).filename().string() + "." + hash_str + ".astc")).string();
+}
+
+// Hash 8 bytes per step, code is hashed on every start, so it must be fast
+uint64_t AstCache::hash(std::string_view code){
+	const uint64_t prime = 0x9E3779B97F4A7C15ull;
+	uint64_t h = code.size() * prime;
+
+	size_t i = 0;
+	for(; i + 8 <= code.size(); i += 8){
+		uint64_t word;
+		std::memcpy(&word, code.data() + i, sizeof(word));
+		h = (h ^ word) * prime;
+		h ^= h >> 29;
+	}
+
+	uint64_t tail = 0;
+	std::memcpy(&tail, code.data() + i, code.size() - i);
+	h = (h ^ tail) * prime;
+	h ^= h >> 32;
+
+	return h;
+}
+
+bool AstCache::load(const char * path, std::string_view code, FlatTree & tree){
+	const std::string file = cache_path(path);
+
+	std::error_code ec;
+	if(!std::filesystem::exists(file, ec)){
+		return false;
+	}
+
+	Source source;
+	try{
+		source.open(file.c_str());
+	}catch(const Exception & e){
+		return false;
+	}
+
+	const char * data = source.data();
+	const size_t size = source.size();
+
+	if(size < sizeof(Header)){
+		return false;
+	}
+
+	Header header;
+	std::memcpy(&header, data, sizeof(header));
+
+	if(std::memcmp(header.magic, AST_CACHE_MAGIC, sizeof(header.magic)) != 0
+	|| header.version != AST_CACHE_VERSION
+	|| header.code_size != code.size()
+	|| header.hash != hash(code)){
+		return false;
+	}
+
+	// Check that file is not truncated
+	// Note: Counts are widened before arithmetic, so crafted counts cannot wrap around to the file size
+	const size_t nodes = header.nodes;
+	const size_t nodes_bytes = (nodes * 2 + 3) & ~size_t(3);
+	const size_t expected_size = sizeof(Header) + nodes_bytes
+							   + (nodes * 3 + size_t(header.extra) + size_t(header.roots) + size_t(header.symbols)) * sizeof(uint32_t)
+							   + size_t(header.chars);
+	if(size != expected_size){
+		return false;
+	}
+
+	const char * ptr = data + sizeof(Header);
+	auto read_array = [&ptr](auto & vec, const uint32_t & count){
+		vec.resize(count);
+		std::memcpy(vec.data(), ptr, size_t(count) * sizeof(vec[0]));
+		ptr += size_t(count) * sizeof(vec[0]);
+	};
+
+	tree.clear();
+	read_array(tree.kinds, header.nodes);
+	read_array(tree.flags, header.nodes);
+	ptr = data + sizeof(Header) + nodes_bytes;
+	read_array(tree.offsets, header.nodes);
+	read_array(tree.lhs, header.nodes);
+	read_array(tree.rhs, header.nodes);
+	read_array(tree.extra, header.extra);
+	read_array(tree.roots, header.roots);
+
+	// Note: Passes don't check indices of tree, so corrupted cache must not get to them
+	if(!tree.validate()){
+		tree.clear();
+		return false;
+	}
+
+	// Intern strings of cache, symbols in cache are indices in its strings table
+	const char * ends = ptr;
+	const char * chars = ptr + header.symbols * sizeof(uint32_t);
+	std::vector <Symbol> symbols(header.symbols);
+	uint32_t start = 0;
+	for(uint32_t i = 0; i < header.symbols; i++){
+		uint32_t end;
+		std::memcpy(&end, ends + i * sizeof(uint32_t), sizeof(end));
+		if(end < start || end > header.chars){
+			tree.clear();
+			return false;
+		}
+		symbols[i] = intern(std::string_view(chars + start, end - start));
+		start = end;
+	}
+
+	for(NodeIndex node = 0; node < header.nodes; node++){
+		if(tree.kinds[node] == NK_STRING || tree.kinds[node] == NK_IDENTIFIER){
+			if(tree.lhs[node] >= header.symbols){
+				tree.clear();
+				return false;
+			}
+			tree.lhs[node] = symbols[tree.lhs[node]];
+		}
+	}
+
+	return true;
+}
+
+bool AstCache::store(const char * path, std::string_view code, const FlatTree & tree){
+	// Symbols are process-local, so strings are stored and Symbols are replaced with their indices
+	std::vector <uint32_t> lhs = tree.lhs;
+	std::vector <uint32_t> ends;
+	std::string chars;
+	std::vector <uint32_t> local(interner().size(), UINT32_MAX);
+	for(NodeIndex node = 0; node < tree.size(); node++){
+		if(tree.kinds[node] == NK_STRING || tree.kinds[node] == NK_IDENTIFIER){
+			const Symbol sym = tree.lhs[node];
+			if(local[sym] == UINT32_MAX){
+				local[sym] = ends.size();
+				chars += symbol_str(sym);
+				ends.push_back(chars.size());
+			}
+			lhs[node] = local[sym];
+		}
+	}
+
+	Header header;
+	std::memcpy(header.magic, AST_CACHE_MAGIC, sizeof(header.magic));
+	header.version = AST_CACHE_VERSION;
+	header.hash = hash(code);
+	header.code_size = code.size();
+	header.nodes = tree.size();
+	header.extra = tree.extra.size();
+	header.roots = tree.roots.size();
+	header.symbols = ends.size();
+	header.chars = chars.size();
+
+	const std::string file = cache_path(path);
+	const std::string tmp_file = file + ".tmp";
+
+	std::error_code ec;
+	if(!dir.empty()){
+		std::filesystem::create_directories(dir, ec);
+	}
+
+	{
+		std::ofstream out(tmp_file, std::ios::binary | std::ios::trunc);
+		if(!out){
+			return false;
+		}
+
+		auto write_array = [&out](const auto & vec){
+			out.write(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(vec[0]));
+		};
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		write_array(tree.kinds);
+		write_array(tree.flags);
+		// Align 32-bit arrays
+		const char padding[4] = {};
+		out.write(padding, ((tree.size() * 2 + 3) & ~size_t(3)) - tree.size() * 2);
+		write_array(tree.offsets);
+		write_array(lhs);
+		write_array(tree.rhs);
+		write_array(tree.extra);
+		write_array(tree.roots);
+		write_array(ends);
+		out.write(chars.data(), chars.size());
+
+		if(!out){
+			std::filesystem::remove(tmp_file, ec);
+			return false;
+		}
+	}
+
+	// Note: Cache file is replaced atomically, so concurrent runs never read half-written cache
+	std::filesystem::rename(tmp_file, file, ec);
+	if(ec){
+		std::filesystem::remove(tmp_file, ec);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,52 @@
+#ifndef ASTCACHE_H
+#define ASTCACHE_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+#include "FlatTree.h"
+
+// AstCache stores parsed FlatTree on disk, so unchanged scripts are not lexed and parsed again.
+// Cache file is keyed by hash of source code and is written next to the script
+// (`script.jc` -> `script.jc.astc`) or into the cache directory.
+// On hit the cache file is mapped and arrays are copied into the tree in one pass,
+// only interned strings (identifiers and string literals) are remapped to Symbols of this run.
+// Note: Format is native-endian, cache is not meant to be shared between machines
+
+// Note: Must be changed with any change of FlatTree layout or NodeKind,
+// and when Parser makes different tree for the same code (e.g. node offsets), as cache is keyed by code only
+const uint32_t AST_CACHE_VERSION = 3;
+
+class AstCache {
+	public:
+		// Empty `dir` means cache file next to the script
+		AstCache(const std::string & dir = "");
+		virtual ~AstCache() = default;
+
+		// Returns false on miss (no cache, other version or different code)
+		bool load(const char * path, std::string_view code, FlatTree & tree);
+
+		// Note: Cache is optional, so write failures are ignored (returns false)
+		bool store(const char * path, std::string_view code, const FlatTree & tree);
+
+		static uint64_t hash(std::string_view code);
+
+	private:
+		std::string dir;
+		std::string cache_path(const char * path);
+
+		struct Header {
+			char magic[4];
+			uint32_t version;
+			uint64_t hash;
+			uint32_t code_size;
+			uint32_t nodes;
+			uint32_t extra;
+			uint32_t roots;
+			uint32_t symbols;
+			uint32_t chars;
+		};
+};
+
+#endif
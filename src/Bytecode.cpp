@@ -0,0 +1,125 @@
+#include "Bytecode.h"
+
+std::string opcode_name(const OpCode & op){
+	static const char * const names[] = {
+#define BYTECODE_NAME(name) #name,
+		BYTECODE_OPCODES(BYTECODE_NAME)
+#undef BYTECODE_NAME
+	};
+	return op < BC_COUNT ? names[op] : "[UNKNOWN]";
+}
+
+std::string CompiledFunc::disassemble(){
+	std::string str;
+	for(size_t i = 0; i < chunk.code.size(); i++){
+		const uint32_t instruction = chunk.code[i];
+		const OpCode op = instruction_op(instruction);
+		const uint32_t arg = instruction_arg(instruction);
+
+		str += std::to_string(i) + "\t" + opcode_name(op);
+		switch(op){
+			case BC_CONST:
+			case BC_CLOSURE:
+			case BC_ADD_CONST:
+			case BC_SUB_CONST:
+			case BC_MUL_CONST:
+			case BC_DIV_CONST:
+			case BC_MOD_CONST:
+			case BC_LESS_CONST:
+			case BC_LESS_EQUAL_CONST:
+			case BC_GREATER_CONST:
+			case BC_GREATER_EQUAL_CONST:
+			case BC_EQUAL_CONST:
+			case BC_NOT_EQUAL_CONST:{
+				str += " " + std::to_string(arg) + " (" + chunk.constants[arg].to_string() + ")";
+				break;
+			}
+			case BC_LOAD_LOCAL2:
+			case BC_ADD_LOCAL_LOCAL:
+			case BC_SUB_LOCAL_LOCAL:
+			case BC_MUL_LOCAL_LOCAL:
+			case BC_DIV_LOCAL_LOCAL:
+			case BC_MOD_LOCAL_LOCAL:
+			case BC_LESS_LOCAL_LOCAL:
+			case BC_LESS_EQUAL_LOCAL_LOCAL:
+			case BC_GREATER_LOCAL_LOCAL:
+			case BC_GREATER_EQUAL_LOCAL_LOCAL:
+			case BC_EQUAL_LOCAL_LOCAL:
+			case BC_NOT_EQUAL_LOCAL_LOCAL:{
+				str += " " + std::to_string(pair_first(arg)) + " " + std::to_string(pair_second(arg));
+				break;
+			}
+			case BC_INC_LOCAL:
+			case BC_INC_GLOBAL:
+			case BC_ADD_LOCAL_CONST:
+			case BC_SUB_LOCAL_CONST:
+			case BC_MUL_LOCAL_CONST:
+			case BC_DIV_LOCAL_CONST:
+			case BC_MOD_LOCAL_CONST:
+			case BC_LESS_LOCAL_CONST:
+			case BC_LESS_EQUAL_LOCAL_CONST:
+			case BC_GREATER_LOCAL_CONST:
+			case BC_GREATER_EQUAL_LOCAL_CONST:
+			case BC_EQUAL_LOCAL_CONST:
+			case BC_NOT_EQUAL_LOCAL_CONST:
+			case BC_ADD_GLOBAL_CONST:
+			case BC_SUB_GLOBAL_CONST:
+			case BC_MUL_GLOBAL_CONST:
+			case BC_DIV_GLOBAL_CONST:
+			case BC_MOD_GLOBAL_CONST:
+			case BC_LESS_GLOBAL_CONST:
+			case BC_LESS_EQUAL_GLOBAL_CONST:
+			case BC_GREATER_GLOBAL_CONST:
+			case BC_GREATER_EQUAL_GLOBAL_CONST:
+			case BC_EQUAL_GLOBAL_CONST:
+			case BC_NOT_EQUAL_GLOBAL_CONST:{
+				str += " " + std::to_string(pair_first(arg)) + " " + std::to_string(pair_second(arg))
+					   + " (" + chunk.constants[pair_second(arg)].to_string() + ")";
+				break;
+			}
+			case BC_INFIX:
+			case BC_PREFIX:{
+				str += " " + op_to_str(static_cast<Operator>(arg));
+				break;
+			}
+			case BC_LOAD_LOCAL:
+			case BC_STORE_LOCAL:
+			case BC_SET_LOCAL:
+			case BC_ADD_LOCAL:
+			case BC_SUB_LOCAL:
+			case BC_MUL_LOCAL:
+			case BC_DIV_LOCAL:
+			case BC_MOD_LOCAL:
+			case BC_LESS_LOCAL:
+			case BC_LESS_EQUAL_LOCAL:
+			case BC_GREATER_LOCAL:
+			case BC_GREATER_EQUAL_LOCAL:
+			case BC_EQUAL_LOCAL:
+			case BC_NOT_EQUAL_LOCAL:
+			case BC_LOAD_GLOBAL:
+			case BC_STORE_GLOBAL:
+			case BC_SET_GLOBAL:
+			case BC_DEFINE_GLOBAL:
+			case BC_LOAD_UPVALUE:
+			case BC_STORE_UPVALUE:
+			case BC_SET_UPVALUE:
+			case BC_CLOSE_UPVALUES:
+			case BC_JUMP:
+			case BC_JUMP_IF_FALSE:
+			case BC_JUMP_IF_TRUE:
+			case BC_JUMP_IF_NOT_NULL:
+			case BC_LIST:
+			case BC_ITER:
+			case BC_FOR_NEXT:
+			case BC_CALL:
+			case BC_ARG_DEFAULT:
+			case BC_RETURN_LOCAL:{
+				str += " " + std::to_string(arg);
+				break;
+			}
+			default: break;
+		}
+		str += '\n';
+	}
+	return str;
+}
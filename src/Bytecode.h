@@ -0,0 +1,270 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "Object.h"
+
+// Bytecode is linear code of stack machine (see VM) compiled from AST by Compiler.
+// Instruction is one 32-bit word: opcode in low 8 bits and 24-bit unsigned argument
+// (index of constant, slot of local or global variable, count of items or target of jump).
+// Jump target is the index of instruction in the chunk.
+// Superinstructions with two operands (`a` and `b`) split argument into two 12-bit parts (see `make_pair_arg`).
+// Stack effect is written as `[before] -> [after]`.
+#define BYTECODE_OPCODES(OP) \
+	OP(CONST)            /* [] -> [constants[arg]] */ \
+	OP(LOAD_NULL)        /* [] -> [null] */ \
+	OP(LOAD_TRUE)        /* [] -> [true] */ \
+	OP(LOAD_FALSE)       /* [] -> [false] */ \
+	OP(POP)              /* [a] -> [] */ \
+	OP(DUP)              /* [a] -> [a, a] */ \
+	OP(DUP2)             /* [a, b] -> [a, b, a, b] */ \
+	OP(SWAP)             /* [a, b] -> [b, a] */ \
+	OP(LOAD_LOCAL)       /* [] -> [locals[arg]] */ \
+	OP(LOAD_LOCAL2)      /* [] -> [locals[a], locals[b]] */ \
+	OP(STORE_LOCAL)      /* [a] -> [a], locals[arg] = a */ \
+	OP(SET_LOCAL)        /* [a] -> [], locals[arg] = a */ \
+	OP(LOAD_GLOBAL)      /* [] -> [globals[arg]], error if it's not defined yet */ \
+	OP(STORE_GLOBAL)     /* [a] -> [a], globals[arg] = a, error if it's not defined yet */ \
+	OP(SET_GLOBAL)       /* [a] -> [], globals[arg] = a, error if it's not defined yet */ \
+	OP(INC_LOCAL)        /* [] -> [], locals[a] = locals[a] + constants[b] */ \
+	OP(INC_GLOBAL)       /* [] -> [], globals[a] = globals[a] + constants[b], global is defined (checked by Compiler) */ \
+	OP(DEFINE_GLOBAL)    /* [a] -> [], globals[arg] = a */ \
+	OP(LOAD_UPVALUE)     /* [] -> [upvalues[arg]] */ \
+	OP(STORE_UPVALUE)    /* [a] -> [a], upvalues[arg] = a */ \
+	OP(SET_UPVALUE)      /* [a] -> [], upvalues[arg] = a */ \
+	OP(ADD)              /* [a, b] -> [a + b] */ \
+	OP(SUB) \
+	OP(MUL) \
+	OP(DIV) \
+	OP(MOD) \
+	OP(LESS) \
+	OP(LESS_EQUAL) \
+	OP(GREATER) \
+	OP(GREATER_EQUAL) \
+	OP(EQUAL) \
+	OP(NOT_EQUAL) \
+	OP(ADD_CONST)        /* [a] -> [a + constants[arg]], same order of operators as above */ \
+	OP(SUB_CONST) \
+	OP(MUL_CONST) \
+	OP(DIV_CONST) \
+	OP(MOD_CONST) \
+	OP(LESS_CONST) \
+	OP(LESS_EQUAL_CONST) \
+	OP(GREATER_CONST) \
+	OP(GREATER_EQUAL_CONST) \
+	OP(EQUAL_CONST) \
+	OP(NOT_EQUAL_CONST) \
+	OP(ADD_LOCAL)        /* [a] -> [a + locals[arg]], same order of operators as above */ \
+	OP(SUB_LOCAL) \
+	OP(MUL_LOCAL) \
+	OP(DIV_LOCAL) \
+	OP(MOD_LOCAL) \
+	OP(LESS_LOCAL) \
+	OP(LESS_EQUAL_LOCAL) \
+	OP(GREATER_LOCAL) \
+	OP(GREATER_EQUAL_LOCAL) \
+	OP(EQUAL_LOCAL) \
+	OP(NOT_EQUAL_LOCAL) \
+	OP(ADD_LOCAL_CONST) /* [] -> [locals[a] + constants[b]], same order of operators as above */ \
+	OP(SUB_LOCAL_CONST) \
+	OP(MUL_LOCAL_CONST) \
+	OP(DIV_LOCAL_CONST) \
+	OP(MOD_LOCAL_CONST) \
+	OP(LESS_LOCAL_CONST) \
+	OP(LESS_EQUAL_LOCAL_CONST) \
+	OP(GREATER_LOCAL_CONST) \
+	OP(GREATER_EQUAL_LOCAL_CONST) \
+	OP(EQUAL_LOCAL_CONST) \
+	OP(NOT_EQUAL_LOCAL_CONST) \
+	OP(ADD_LOCAL_LOCAL) /* [] -> [locals[a] + locals[b]], same order of operators as above */ \
+	OP(SUB_LOCAL_LOCAL) \
+	OP(MUL_LOCAL_LOCAL) \
+	OP(DIV_LOCAL_LOCAL) \
+	OP(MOD_LOCAL_LOCAL) \
+	OP(LESS_LOCAL_LOCAL) \
+	OP(LESS_EQUAL_LOCAL_LOCAL) \
+	OP(GREATER_LOCAL_LOCAL) \
+	OP(GREATER_EQUAL_LOCAL_LOCAL) \
+	OP(EQUAL_LOCAL_LOCAL) \
+	OP(NOT_EQUAL_LOCAL_LOCAL) \
+	OP(ADD_GLOBAL_CONST) /* [] -> [globals[a] + constants[b]], global is defined (checked by Compiler), same order of operators as above */ \
+	OP(SUB_GLOBAL_CONST) \
+	OP(MUL_GLOBAL_CONST) \
+	OP(DIV_GLOBAL_CONST) \
+	OP(MOD_GLOBAL_CONST) \
+	OP(LESS_GLOBAL_CONST) \
+	OP(LESS_EQUAL_GLOBAL_CONST) \
+	OP(GREATER_GLOBAL_CONST) \
+	OP(GREATER_EQUAL_GLOBAL_CONST) \
+	OP(EQUAL_GLOBAL_CONST) \
+	OP(NOT_EQUAL_GLOBAL_CONST) \
+	OP(INFIX)            /* [a, b] -> [a op b], arg is Operator */ \
+	OP(PREFIX)           /* [a] -> [op a], arg is Operator */ \
+	OP(JUMP)             /* [] -> [] */ \
+	OP(JUMP_IF_FALSE)    /* [a] -> [] */ \
+	OP(JUMP_IF_TRUE)     /* [a] -> [] */ \
+	OP(JUMP_IF_NOT_NULL) /* [a] -> [a] if a is not null and jumps, otherwise [a] -> [] */ \
+	OP(LIST)             /* [a1, ..., aN] -> [list], arg is N */ \
+	OP(GET_ITEM)         /* [a, i] -> [a[i]] */ \
+	OP(SET_ITEM)         /* [a, i, v] -> [v], a[i] = v */ \
+	OP(ITER)             /* [a] -> [], locals[arg] = a, locals[arg + 1] = int index 0, error if a is not iterable */ \
+	OP(FOR_NEXT)         /* [] -> [item] and skips the next instruction (jump out of loop) if locals[arg] has next item */ \
+	OP(CALL)             /* [f, a1, ..., aN] -> [result], arg is N */ \
+	OP(CLOSURE)          /* [] -> [closure], closure of function constants[arg] captures its upvalues */ \
+	OP(CLOSE_UPVALUES)   /* [] -> [], upvalues of locals[arg] and locals above it are closed */ \
+	OP(ARG_DEFAULT)      /* [] -> [], skips the next instruction (jump over default value) if argument arg was not passed */ \
+	OP(RETURN)           /* [a] -> [], returns a to caller */ \
+	OP(RETURN_LOCAL)     /* [] -> [], returns locals[arg] to caller */
+
+enum OpCode : uint8_t {
+#define BYTECODE_ENUM(name) BC_##name,
+	BYTECODE_OPCODES(BYTECODE_ENUM)
+#undef BYTECODE_ENUM
+	BC_COUNT
+};
+
+static_assert(BC_NOT_EQUAL - BC_ADD == BC_NOT_EQUAL_CONST - BC_ADD_CONST, "Operators with constant operand must match operators");
+static_assert(BC_NOT_EQUAL - BC_ADD == BC_NOT_EQUAL_LOCAL - BC_ADD_LOCAL, "Operators with local operand must match operators");
+static_assert(BC_NOT_EQUAL - BC_ADD == BC_NOT_EQUAL_LOCAL_CONST - BC_ADD_LOCAL_CONST, "Operators with two operands must match operators");
+static_assert(BC_NOT_EQUAL - BC_ADD == BC_NOT_EQUAL_LOCAL_LOCAL - BC_ADD_LOCAL_LOCAL, "Operators with two operands must match operators");
+static_assert(BC_NOT_EQUAL - BC_ADD == BC_NOT_EQUAL_GLOBAL_CONST - BC_ADD_GLOBAL_CONST, "Operators with two operands must match operators");
+
+const uint32_t BYTECODE_ARG_MAX = (1 << 24) - 1;
+
+inline uint32_t make_instruction(const OpCode & op, const uint32_t & arg = 0){
+	return op | arg << 8;
+}
+
+inline OpCode instruction_op(const uint32_t & instruction){
+	return static_cast<OpCode>(instruction & 0xFF);
+}
+
+inline uint32_t instruction_arg(const uint32_t & instruction){
+	return instruction >> 8;
+}
+
+// Max of each operand of superinstruction, bigger operands are not merged
+const uint32_t BYTECODE_PAIR_MAX = (1 << 12) - 1;
+
+inline uint32_t make_pair_arg(const uint32_t & a, const uint32_t & b){
+	return a | b << 12;
+}
+
+inline uint32_t pair_first(const uint32_t & arg){
+	return arg & BYTECODE_PAIR_MAX;
+}
+
+inline uint32_t pair_second(const uint32_t & arg){
+	return arg >> 12;
+}
+
+std::string opcode_name(const OpCode & op);
+
+struct Chunk {
+	std::vector <uint32_t> code;
+	// Offset in source code of each instruction for errors
+	std::vector <uint32_t> offsets;
+	std::vector <Value> constants;
+};
+
+// Variable of enclosing function captured by function,
+// it's local slot of enclosing function if `is_local`, otherwise upvalue of enclosing function
+struct UpvalueDesc {
+	bool is_local;
+	uint32_t index;
+};
+
+// Function compiled to bytecode, arguments are the first locals
+class CompiledFunc : public Object {
+	public:
+		CompiledFunc(const Symbol & name) : Object(OT_COMPILED_FUNC), name(name) {}
+		virtual ~CompiledFunc() = default;
+
+		Symbol name;
+		Chunk chunk;
+
+		std::vector <Symbol> arg_names;
+		// Arguments after required ones have default values
+		uint32_t required_args = 0;
+		// Count of local slots including arguments
+		uint32_t local_count = 0;
+		// Max depth of operand stack above locals
+		uint32_t max_stack = 0;
+		// Function with upvalues is called through Closure made by `CLOSURE`
+		std::vector <UpvalueDesc> upvalues;
+
+		virtual std::string to_string() override {
+			return "<func " + std::string(symbol_str(name)) + ">";
+		}
+
+		// Note: Constants are the only values of function, nested functions are among them
+		virtual void trace(Heap & heap) override {
+			heap.mark(chunk.constants.data(), chunk.constants.data() + chunk.constants.size());
+		}
+
+		// Listing of instructions for debugging
+		std::string disassemble();
+};
+
+// Variable captured by closure, it points to the slot of VM stack while the slot is alive (open upvalue)
+// and holds the value itself after the scope of slot ends (closed upvalue)
+// Note: Closures of the same scope share upvalue, so they see assignments of each other
+class Upvalue : public Cell {
+	public:
+		Upvalue(Value * location) : location(location), next(nullptr) {}
+		virtual ~Upvalue() = default;
+
+		Value * location;
+		Value closed;
+		// Next open upvalue of VM (of lower slot), open upvalues are owned by VM
+		Upvalue * next;
+
+		void set(const Value & value){
+			*location = value;
+			heap().write_barrier(this);
+		}
+		void close(){
+			closed = *location;
+			location = &closed;
+			next = nullptr;
+			heap().write_barrier(this);
+		}
+
+		virtual void trace(Heap & heap) override {
+			heap.mark(closed);
+		}
+};
+
+class Closure : public Object {
+	public:
+		Closure(CompiledFunc * func) : Object(OT_CLOSURE), func(func), upvalues(func->upvalues.size(), nullptr) {}
+		virtual ~Closure() = default;
+
+		CompiledFunc * func;
+		std::vector <Upvalue*> upvalues;
+
+		virtual std::string to_string() override {
+			return func->to_string();
+		}
+
+		virtual void trace(Heap & heap) override {
+			heap.mark(func);
+			for(Upvalue * upvalue : upvalues){
+				if(upvalue != nullptr){
+					heap.mark(upvalue);
+				}
+			}
+		}
+};
+
+// Compiled program, globals are indexed by slot
+// Note: Builtins are the first globals in order of `builtins()`
+struct Program {
+	CompiledFunc * main;
+	std::vector <Symbol> globals;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef CHARCLASS_H
+#define CHARCLASS_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+	#include <emmintrin.h>
+	#define CHARCLASS_SSE2
+#endif
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define CHARCLASS_AVX2
+#endif
+
+// Character classes for Lexer determinators.
+// Every char is classified with one load from 256-entry table instead of comparisons chain.
+
+enum CharClass : uint8_t {
+	CC_SKIPABLE = 1 << 0,
+	CC_ENDL = 1 << 1,
+	CC_DIGIT = 1 << 2,
+	CC_HEX = 1 << 3,
+	CC_ID_FIRST = 1 << 4,
+	CC_ID = 1 << 5,
+	CC_QUOTE = 1 << 6,
+	CC_BIN = 1 << 7
+};
+
+constexpr std::array <uint8_t, 256> make_char_classes(){
+	std::array <uint8_t, 256> classes{};
+
+	for(const unsigned char c : {' ', '\t', '\v', '\f', '\r'}){
+		classes[c] |= CC_SKIPABLE;
+	}
+	classes['\n'] |= CC_ENDL;
+	for(unsigned char c = '0'; c <= '9'; c++){
+		classes[c] |= CC_DIGIT | CC_HEX | CC_ID;
+	}
+	classes['0'] |= CC_BIN;
+	classes['1'] |= CC_BIN;
+	for(unsigned char c = 'a'; c <= 'z'; c++){
+		classes[c] |= CC_ID_FIRST | CC_ID;
+		classes[c - 'a' + 'A'] |= CC_ID_FIRST | CC_ID;
+	}
+	for(unsigned char c = 'a'; c <= 'f'; c++){
+		classes[c] |= CC_HEX;
+		classes[c - 'a' + 'A'] |= CC_HEX;
+	}
+	for(const unsigned char c : {'$', '_'}){
+		classes[c] |= CC_ID_FIRST | CC_ID;
+	}
+	for(const unsigned char c : {'"', '\'', '`'}){
+		classes[c] |= CC_QUOTE;
+	}
+
+	return classes;
+}
+
+constexpr std::array <uint8_t, 256> char_classes = make_char_classes();
+
+inline bool is_char_class(const char & c, const uint8_t & cc){
+	return char_classes[static_cast<unsigned char>(c)] & cc;
+}
+
+////////////////////
+// Runs scanning //
+////////////////////
+
+// Each matcher checks one char (scalar) or block of 16/32 chars (SIMD) for belonging to the run.
+// SIMD `match` returns vector with 0xFF for matching bytes.
+
+#ifdef CHARCLASS_SSE2
+// Unsigned check for `lo <= c <= hi` with signed compare
+inline __m128i sse2_in_range(__m128i v, const char & lo, const char & hi){
+	const __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - lo)));
+	return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(0x80 + (hi - lo + 1))));
+}
+#endif
+#ifdef CHARCLASS_AVX2
+inline __m256i avx2_in_range(__m256i v, const char & lo, const char & hi){
+	const __m256i shifted = _mm256_add_epi8(v, _mm256_set1_epi8(static_cast<char>(0x80 - lo)));
+	return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0x80 + (hi - lo + 1))), shifted);
+}
+#endif
+
+// Space, tab, \v, \f, \r
+struct SkipableMatcher {
+	bool scalar(const char & c) const {
+		return is_char_class(c, CC_SKIPABLE);
+	}
+#ifdef CHARCLASS_SSE2
+	__m128i match(__m128i v) const {
+		// \t, \n, \v, \f, \r are 9..13 but \n is not skipable
+		const __m128i controls = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), sse2_in_range(v, '\t', '\r'));
+		return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), controls);
+	}
+#endif
+#ifdef CHARCLASS_AVX2
+	__m256i match(__m256i v) const {
+		const __m256i controls = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), avx2_in_range(v, '\t', '\r'));
+		return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), controls);
+	}
+#endif
+};
+
+// a-z, A-Z, 0-9, $, _
+struct IdentifierMatcher {
+	bool scalar(const char & c) const {
+		return is_char_class(c, CC_ID);
+	}
+#ifdef CHARCLASS_SSE2
+	__m128i match(__m128i v) const {
+		// Note: Set 0x20 bit to lower case letters
+		const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+		return _mm_or_si128(
+			_mm_or_si128(sse2_in_range(lower, 'a', 'z'), sse2_in_range(v, '0', '9')),
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')), _mm_cmpeq_epi8(v, _mm_set1_epi8('$')))
+		);
+	}
+#endif
+#ifdef CHARCLASS_AVX2
+	__m256i match(__m256i v) const {
+		const __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+		return _mm256_or_si256(
+			_mm256_or_si256(avx2_in_range(lower, 'a', 'z'), avx2_in_range(v, '0', '9')),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('$')))
+		);
+	}
+#endif
+};
+
+struct DigitMatcher {
+	bool scalar(const char & c) const {
+		return is_char_class(c, CC_DIGIT);
+	}
+#ifdef CHARCLASS_SSE2
+	__m128i match(__m128i v) const {
+		return sse2_in_range(v, '0', '9');
+	}
+#endif
+#ifdef CHARCLASS_AVX2
+	__m256i match(__m256i v) const {
+		return avx2_in_range(v, '0', '9');
+	}
+#endif
+};
+
+// String literal body, everything except closing quote and end of line
+struct StringBodyMatcher {
+	char quote;
+
+	bool scalar(const char & c) const {
+		return c != quote && c != '\n';
+	}
+#ifdef CHARCLASS_SSE2
+	__m128i match(__m128i v) const {
+		const __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(quote)), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+		return _mm_xor_si128(stop, _mm_set1_epi8(static_cast<char>(0xFF)));
+	}
+#endif
+#ifdef CHARCLASS_AVX2
+	__m256i match(__m256i v) const {
+		const __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(quote)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+		return _mm256_xor_si256(stop, _mm256_set1_epi8(static_cast<char>(0xFF)));
+	}
+#endif
+};
+
+// Length of the run of matching chars at the start of [data, data + size)
+// Note: Never reads out of [data, data + size), the tail is checked by scalar loop
+template <class Matcher>
+inline uint32_t run_length(const Matcher & matcher, const char * data, const uint32_t & size){
+	uint32_t i = 0;
+
+#ifdef CHARCLASS_AVX2
+	while(i + 32 <= size){
+		const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(matcher.match(block)));
+		if(mask != 0xFFFFFFFFu){
+			return i + std::countr_zero(~mask);
+		}
+		i += 32;
+	}
+#endif
+
+#ifdef CHARCLASS_SSE2
+	while(i + 16 <= size){
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(matcher.match(block)));
+		if(mask != 0xFFFFu){
+			return i + std::countr_zero(~mask);
+		}
+		i += 16;
+	}
+#endif
+
+	while(i < size && matcher.scalar(data[i])){
+		i++;
+	}
+
+	return i;
+}
+
+#endif
@@ -0,0 +1,937 @@
+#include "Compiler.h"
+#include "Trace.h"
+
+// Change of stack depth by instruction
+// Note: Branches that keep value on one path only (JUMP_IF_NOT_NULL, FOR_NEXT) are counted as fallthrough path
+static int32_t stack_effect(const OpCode & op, const uint32_t & arg){
+	switch(op){
+		case BC_CONST:
+		case BC_LOAD_NULL:
+		case BC_LOAD_TRUE:
+		case BC_LOAD_FALSE:
+		case BC_DUP:
+		case BC_LOAD_LOCAL:
+		case BC_LOAD_GLOBAL:
+		case BC_LOAD_UPVALUE:
+		case BC_CLOSURE:
+		case BC_ADD_LOCAL_CONST:
+		case BC_SUB_LOCAL_CONST:
+		case BC_MUL_LOCAL_CONST:
+		case BC_DIV_LOCAL_CONST:
+		case BC_MOD_LOCAL_CONST:
+		case BC_LESS_LOCAL_CONST:
+		case BC_LESS_EQUAL_LOCAL_CONST:
+		case BC_GREATER_LOCAL_CONST:
+		case BC_GREATER_EQUAL_LOCAL_CONST:
+		case BC_EQUAL_LOCAL_CONST:
+		case BC_NOT_EQUAL_LOCAL_CONST:
+		case BC_ADD_LOCAL_LOCAL:
+		case BC_SUB_LOCAL_LOCAL:
+		case BC_MUL_LOCAL_LOCAL:
+		case BC_DIV_LOCAL_LOCAL:
+		case BC_MOD_LOCAL_LOCAL:
+		case BC_LESS_LOCAL_LOCAL:
+		case BC_LESS_EQUAL_LOCAL_LOCAL:
+		case BC_GREATER_LOCAL_LOCAL:
+		case BC_GREATER_EQUAL_LOCAL_LOCAL:
+		case BC_EQUAL_LOCAL_LOCAL:
+		case BC_NOT_EQUAL_LOCAL_LOCAL:
+		case BC_ADD_GLOBAL_CONST:
+		case BC_SUB_GLOBAL_CONST:
+		case BC_MUL_GLOBAL_CONST:
+		case BC_DIV_GLOBAL_CONST:
+		case BC_MOD_GLOBAL_CONST:
+		case BC_LESS_GLOBAL_CONST:
+		case BC_LESS_EQUAL_GLOBAL_CONST:
+		case BC_GREATER_GLOBAL_CONST:
+		case BC_GREATER_EQUAL_GLOBAL_CONST:
+		case BC_EQUAL_GLOBAL_CONST:
+		case BC_NOT_EQUAL_GLOBAL_CONST:
+		case BC_FOR_NEXT: return 1;
+		case BC_DUP2:
+		case BC_LOAD_LOCAL2: return 2;
+		case BC_SWAP:
+		case BC_STORE_LOCAL:
+		case BC_STORE_GLOBAL:
+		case BC_INC_LOCAL:
+		case BC_INC_GLOBAL:
+		case BC_STORE_UPVALUE:
+		case BC_CLOSE_UPVALUES:
+		case BC_ADD_CONST:
+		case BC_SUB_CONST:
+		case BC_MUL_CONST:
+		case BC_DIV_CONST:
+		case BC_MOD_CONST:
+		case BC_LESS_CONST:
+		case BC_LESS_EQUAL_CONST:
+		case BC_GREATER_CONST:
+		case BC_GREATER_EQUAL_CONST:
+		case BC_EQUAL_CONST:
+		case BC_NOT_EQUAL_CONST:
+		case BC_ADD_LOCAL:
+		case BC_SUB_LOCAL:
+		case BC_MUL_LOCAL:
+		case BC_DIV_LOCAL:
+		case BC_MOD_LOCAL:
+		case BC_LESS_LOCAL:
+		case BC_LESS_EQUAL_LOCAL:
+		case BC_GREATER_LOCAL:
+		case BC_GREATER_EQUAL_LOCAL:
+		case BC_EQUAL_LOCAL:
+		case BC_NOT_EQUAL_LOCAL:
+		case BC_PREFIX:
+		case BC_JUMP:
+		case BC_ARG_DEFAULT:
+		case BC_RETURN_LOCAL: return 0;
+		case BC_LIST: return 1 - static_cast<int32_t>(arg);
+		case BC_CALL: return -static_cast<int32_t>(arg);
+		case BC_SET_ITEM: return -2;
+		default: return -1;
+	}
+}
+
+static OpCode infix_opcode(const Operator & op){
+	switch(op){
+		case OP_ADD: return BC_ADD;
+		case OP_SUB: return BC_SUB;
+		case OP_MUL: return BC_MUL;
+		case OP_DIV: return BC_DIV;
+		case OP_MOD: return BC_MOD;
+		case OP_LESS: return BC_LESS;
+		case OP_LESS_EQUAL: return BC_LESS_EQUAL;
+		case OP_GREATER: return BC_GREATER;
+		case OP_GREATER_EQUAL: return BC_GREATER_EQUAL;
+		case OP_EQUAL: return BC_EQUAL;
+		case OP_NOT_EQUAL: return BC_NOT_EQUAL;
+		default: return BC_INFIX;
+	}
+}
+
+Compiler::Compiler(){
+	tree = nullptr;
+	offset = 0;
+}
+
+void Compiler::error(const std::string & msg){
+	throw RuntimeError(msg, offset);
+}
+
+Program Compiler::compile(const StatementList & tree){
+	FlatTree flat;
+	for(NStatement * statement : tree){
+		flat.add_root(statement->flatten(flat));
+	}
+	return compile(flat);
+}
+
+Program Compiler::compile(const FlatTree & tree){
+	this->tree = &tree;
+	funcs.clear();
+	globals.clear();
+	global_names.clear();
+	offset = 0;
+
+	for(NativeFunc * builtin : builtins()){
+		Global & var = global(builtin->name);
+		var.is_val = true;
+		var.defined = true;
+	}
+
+	CompiledFunc * main = heap().make<CompiledFunc>(intern("main"));
+	funcs.push_back(FuncState{.func = main});
+	for(const NodeIndex & statement : tree.get_roots()){
+		compile_statement(statement);
+	}
+	emit(BC_LOAD_NULL);
+	emit(BC_RETURN);
+	main->local_count = std::max<uint32_t>(main->local_count, state().locals.size());
+	funcs.pop_back();
+	this->tree = nullptr;
+
+	TRACE(TL_DEBUG, TC_EVAL, "Compiled main:\n", main->disassemble());
+
+	return Program{main, global_names};
+}
+
+//////////
+// Code //
+//////////
+
+uint32_t Compiler::emit(const OpCode & op, const uint32_t & arg){
+	if(arg > BYTECODE_ARG_MAX){
+		error("Function is too big to compile");
+	}
+
+	FuncState & func = state();
+	Chunk & code = chunk();
+
+	// Note: Value stored by statement is not used, `STORE_LOCAL, POP` is merged into `SET_LOCAL`
+	// (and `STORE_GLOBAL, POP` into `SET_GLOBAL`, `STORE_UPVALUE, POP` into `SET_UPVALUE`).
+	// Increment `x += k` (`ADD_LOCAL_CONST x k, STORE_LOCAL x, POP`) is merged into `INC_LOCAL x k`
+	if(op == BC_POP && code.code.size() > func.jump_target && !code.code.empty()){
+		const OpCode last = instruction_op(code.code.back());
+		if(code.code.size() >= 2 && code.code.size() - 2 >= func.jump_target
+		   && (last == BC_STORE_LOCAL || last == BC_STORE_GLOBAL)){
+			const uint32_t add = code.code[code.code.size() - 2];
+			const OpCode add_op = last == BC_STORE_LOCAL ? BC_ADD_LOCAL_CONST : BC_ADD_GLOBAL_CONST;
+			if(instruction_op(add) == add_op && pair_first(instruction_arg(add)) == instruction_arg(code.code.back())){
+				code.code.pop_back();
+				code.offsets.pop_back();
+				code.code.back() = make_instruction(last == BC_STORE_LOCAL ? BC_INC_LOCAL : BC_INC_GLOBAL, instruction_arg(add));
+				func.stack_depth--;
+				return code.code.size() - 1;
+			}
+		}
+		if(last == BC_STORE_LOCAL || last == BC_STORE_GLOBAL || last == BC_STORE_UPVALUE){
+			const OpCode merged = last == BC_STORE_LOCAL ? BC_SET_LOCAL : last == BC_STORE_GLOBAL ? BC_SET_GLOBAL : BC_SET_UPVALUE;
+			code.code.back() = make_instruction(merged, instruction_arg(code.code.back()));
+			func.stack_depth--;
+			return code.code.size() - 1;
+		}
+	}
+
+	// Note: Constant or local right operand is merged into operator, `CONST k, ADD` is `ADD_CONST k`
+	// and `LOAD_LOCAL x, ADD` is `ADD_LOCAL x`. With local or defined global left operand before it both are merged:
+	// `LOAD_LOCAL x, CONST k, ADD` is `ADD_LOCAL_CONST x k`, `LOAD_GLOBAL x, CONST k, ADD` is `ADD_GLOBAL_CONST x k`
+	// and `LOAD_LOCAL2 x y, ADD` is `ADD_LOCAL_LOCAL x y`
+	if(op >= BC_ADD && op <= BC_NOT_EQUAL && code.code.size() > func.jump_target && !code.code.empty()){
+		const OpCode last = instruction_op(code.code.back());
+		const uint32_t last_arg = instruction_arg(code.code.back());
+		if(last == BC_LOAD_LOCAL2){
+			code.code.back() = make_instruction(static_cast<OpCode>(op - BC_ADD + BC_ADD_LOCAL_LOCAL), last_arg);
+			code.offsets.back() = offset;
+			func.stack_depth--;
+			return code.code.size() - 1;
+		}
+		if(last == BC_CONST && code.code.size() >= 2 && code.code.size() - 2 >= func.jump_target && last_arg <= BYTECODE_PAIR_MAX){
+			const OpCode left = instruction_op(code.code[code.code.size() - 2]);
+			const uint32_t left_arg = instruction_arg(code.code[code.code.size() - 2]);
+			// Note: Global is merged only after its definition was compiled, so it's defined when instruction runs
+			// (functions are made after it too) and VM doesn't check it
+			const bool defined_global = left == BC_LOAD_GLOBAL && globals.at(global_names[left_arg]).defined;
+			if((left == BC_LOAD_LOCAL || defined_global) && left_arg <= BYTECODE_PAIR_MAX){
+				const OpCode first = left == BC_LOAD_LOCAL ? BC_ADD_LOCAL_CONST : BC_ADD_GLOBAL_CONST;
+				code.code.pop_back();
+				code.offsets.pop_back();
+				code.code.back() = make_instruction(static_cast<OpCode>(op - BC_ADD + first), make_pair_arg(left_arg, last_arg));
+				code.offsets.back() = offset;
+				func.stack_depth--;
+				return code.code.size() - 1;
+			}
+		}
+		if(last == BC_CONST || last == BC_LOAD_LOCAL){
+			const OpCode first = last == BC_CONST ? BC_ADD_CONST : BC_ADD_LOCAL;
+			code.code.back() = make_instruction(static_cast<OpCode>(op - BC_ADD + first), last_arg);
+			code.offsets.back() = offset;
+			func.stack_depth--;
+			return code.code.size() - 1;
+		}
+	}
+
+	// Note: Returned local is not pushed, `LOAD_LOCAL x, RETURN` is `RETURN_LOCAL x`
+	if(op == BC_RETURN && code.code.size() > func.jump_target && !code.code.empty()
+	   && instruction_op(code.code.back()) == BC_LOAD_LOCAL){
+		code.code.back() = make_instruction(BC_RETURN_LOCAL, instruction_arg(code.code.back()));
+		func.stack_depth--;
+		return code.code.size() - 1;
+	}
+
+	// Note: Pair of local loads (mostly operands of operator) is one instruction
+	if(op == BC_LOAD_LOCAL && code.code.size() > func.jump_target && !code.code.empty()
+	   && instruction_op(code.code.back()) == BC_LOAD_LOCAL && instruction_arg(code.code.back()) <= BYTECODE_PAIR_MAX
+	   && arg <= BYTECODE_PAIR_MAX){
+		code.code.back() = make_instruction(BC_LOAD_LOCAL2, make_pair_arg(instruction_arg(code.code.back()), arg));
+		func.stack_depth++;
+		func.func->max_stack = std::max(func.func->max_stack, func.stack_depth);
+		return code.code.size() - 1;
+	}
+
+	code.code.push_back(make_instruction(op, arg));
+	code.offsets.push_back(offset);
+
+	func.stack_depth += stack_effect(op, arg);
+	func.func->max_stack = std::max(func.func->max_stack, func.stack_depth);
+
+	return code.code.size() - 1;
+}
+
+uint32_t Compiler::emit_jump(const OpCode & op){
+	return emit(op, 0);
+}
+
+void Compiler::patch_jump(const uint32_t & jump){
+	Chunk & code = chunk();
+	const uint32_t target = code.code.size();
+	code.code[jump] = make_instruction(instruction_op(code.code[jump]), target);
+	state().jump_target = target;
+}
+
+void Compiler::emit_constant(const Value & value){
+	Chunk & code = chunk();
+	code.constants.push_back(value);
+	emit(BC_CONST, code.constants.size() - 1);
+}
+
+///////////////
+// Variables //
+///////////////
+
+bool Compiler::is_global_scope(){
+	return funcs.size() == 1 && state().scope_depth == 0;
+}
+
+void Compiler::begin_scope(){
+	state().scope_depth++;
+}
+
+void Compiler::end_scope(){
+	FuncState & func = state();
+	func.func->local_count = std::max<uint32_t>(func.func->local_count, func.locals.size());
+	func.scope_depth--;
+	uint32_t close = NO_SLOT;
+	while(!func.locals.empty() && func.locals.back().depth > func.scope_depth){
+		if(func.locals.back().captured){
+			close = func.locals.size() - 1;
+		}
+		func.locals.pop_back();
+	}
+	// Note: Upvalues of the scope are closed on each its exit, so closures made in loop iterations don't share locals
+	if(close != NO_SLOT){
+		emit(BC_CLOSE_UPVALUES, close);
+	}
+}
+
+uint32_t Compiler::declare_local(const Symbol & name, const bool & is_val){
+	FuncState & func = state();
+	if(name != NO_NAME){
+		for(auto it = func.locals.rbegin(); it != func.locals.rend() && it->depth == func.scope_depth; it++){
+			if(it->name == name){
+				error("`" + std::string(symbol_str(name)) + "` is already defined");
+			}
+		}
+	}
+	func.locals.push_back(Local{name, is_val, func.scope_depth});
+	func.func->local_count = std::max<uint32_t>(func.func->local_count, func.locals.size());
+	return func.locals.size() - 1;
+}
+
+Compiler::Global & Compiler::global(const Symbol & name){
+	auto [it, inserted] = globals.try_emplace(name, Global{static_cast<uint32_t>(global_names.size()), false, false, NO_OFFSET});
+	if(inserted){
+		global_names.push_back(name);
+	}
+	return it->second;
+}
+
+// Define variable with value on top of stack
+void Compiler::define(const Symbol & name, const bool & is_val){
+	if(is_global_scope()){
+		Global & var = global(name);
+		if(var.defined){
+			error("`" + std::string(symbol_str(name)) + "` is already defined");
+		}
+		if(is_val && var.assigned != NO_OFFSET){
+			offset = var.assigned;
+			error("Cannot reassign val `" + std::string(symbol_str(name)) + "`");
+		}
+		var.defined = true;
+		var.is_val = is_val;
+		emit(BC_DEFINE_GLOBAL, var.slot);
+	}else{
+		emit(BC_SET_LOCAL, declare_local(name, is_val));
+	}
+}
+
+uint32_t Compiler::find_local(const size_t & f, const Symbol & name){
+	const std::vector <Local> & locals = funcs[f].locals;
+	for(size_t slot = locals.size(); slot-- > 0;){
+		if(locals[slot].name == name){
+			return slot;
+		}
+	}
+	return NO_SLOT;
+}
+
+uint32_t Compiler::resolve_upvalue(const size_t & f, const Symbol & name){
+	if(f == 0){
+		return NO_SLOT;
+	}
+	std::vector <Capture> & captures = funcs[f].captures;
+	for(size_t i = 0; i < captures.size(); i++){
+		if(captures[i].name == name){
+			return i;
+		}
+	}
+
+	// Note: Local of enclosing function is captured directly, local of outer ones through upvalues of functions between
+	UpvalueDesc upvalue;
+	bool is_val;
+	const uint32_t slot = find_local(f - 1, name);
+	if(slot != NO_SLOT){
+		Local & local = funcs[f - 1].locals[slot];
+		local.captured = true;
+		upvalue = UpvalueDesc{true, slot};
+		is_val = local.is_val;
+	}else{
+		const uint32_t index = resolve_upvalue(f - 1, name);
+		if(index == NO_SLOT){
+			return NO_SLOT;
+		}
+		upvalue = UpvalueDesc{false, index};
+		is_val = funcs[f - 1].captures[index].is_val;
+	}
+	funcs[f].func->upvalues.push_back(upvalue);
+	captures.push_back(Capture{name, is_val});
+	return captures.size() - 1;
+}
+
+Compiler::VarRef Compiler::resolve(const Symbol & name, const bool & assign){
+	const size_t f = funcs.size() - 1;
+	const uint32_t slot = find_local(f, name);
+	if(slot != NO_SLOT){
+		if(assign && funcs[f].locals[slot].is_val){
+			error("Cannot reassign val `" + std::string(symbol_str(name)) + "`");
+		}
+		return VarRef{VAR_LOCAL, slot};
+	}
+	const uint32_t upvalue = resolve_upvalue(f, name);
+	if(upvalue != NO_SLOT){
+		if(assign && funcs[f].captures[upvalue].is_val){
+			error("Cannot reassign val `" + std::string(symbol_str(name)) + "`");
+		}
+		return VarRef{VAR_UPVALUE, upvalue};
+	}
+
+	// Note: Global may be declared after use, so it's checked by VM on access
+	Global & var = global(name);
+	if(assign){
+		if(var.is_val){
+			error("Cannot reassign val `" + std::string(symbol_str(name)) + "`");
+		}
+		if(var.assigned == NO_OFFSET){
+			var.assigned = offset;
+		}
+	}
+	return VarRef{VAR_GLOBAL, var.slot};
+}
+
+void Compiler::emit_load(const VarRef & var){
+	static const OpCode ops[] = {BC_LOAD_LOCAL, BC_LOAD_UPVALUE, BC_LOAD_GLOBAL};
+	emit(ops[var.kind], var.slot);
+}
+
+void Compiler::emit_store(const VarRef & var){
+	static const OpCode ops[] = {BC_STORE_LOCAL, BC_STORE_UPVALUE, BC_STORE_GLOBAL};
+	emit(ops[var.kind], var.slot);
+}
+
+////////////////
+// Statements //
+////////////////
+
+void Compiler::compile_statement(const NodeIndex & statement){
+	offset = tree->get_offset(statement);
+
+	switch(tree->get_kind(statement)){
+		case NK_EXPR_STMT:{
+			// Note: Value of `if` statement is not used, so branches don't leave it on stack
+			const NodeIndex expression = tree->get_lhs(statement);
+			if(tree->get_kind(expression) == NK_CONDITION){
+				compile_condition(expression, false);
+				return;
+			}
+			compile_expression(expression);
+			emit(BC_POP);
+			break;
+		}
+		case NK_VAR_DECL:{
+			compile_var_decl(statement);
+			break;
+		}
+		case NK_FUNC_DECL:{
+			compile_func_decl(statement);
+			break;
+		}
+		case NK_RETURN:{
+			const NodeIndex right = tree->get_lhs(statement);
+			if(right != NO_NODE){
+				compile_expression(right);
+			}else{
+				emit(BC_LOAD_NULL);
+			}
+			emit(BC_RETURN);
+			break;
+		}
+		case NK_WHILE:{
+			compile_while(statement);
+			break;
+		}
+		case NK_FOR:{
+			compile_for(statement);
+			break;
+		}
+		case NK_MATCH:{
+			compile_match(statement);
+			break;
+		}
+		case NK_TYPE_DECL:{
+			// Note: Types are not checked at runtime yet
+			break;
+		}
+		default:{
+			error("Statement cannot be compiled");
+		}
+	}
+}
+
+void Compiler::compile_block(const NodeIndex & block, const bool & value){
+	// Note: Value of block is the value of its last statement, only expression statements have value
+	begin_scope();
+	const auto statements = tree->get_list(tree->get_lhs(block));
+	const size_t count = statements.size();
+	bool has_value = false;
+	for(size_t i = 0; i < count; i++){
+		const NodeIndex statement = statements[i];
+		if(value && i == count - 1 && tree->get_kind(statement) == NK_EXPR_STMT){
+			offset = tree->get_offset(statement);
+			compile_expression(tree->get_lhs(statement));
+			has_value = true;
+		}else{
+			compile_statement(statement);
+		}
+	}
+	if(value && !has_value){
+		emit(BC_LOAD_NULL);
+	}
+	end_scope();
+}
+
+void Compiler::compile_var_decl(const NodeIndex & var_decl){
+	const uint32_t data = tree->get_rhs(var_decl);
+	const NodeIndex assignment = tree->get_extra(data + 1);
+	if(assignment != NO_NODE){
+		compile_expression(assignment);
+	}else{
+		emit(BC_LOAD_NULL);
+	}
+	offset = tree->get_offset(var_decl);
+	define(tree->get_symbol(tree->get_lhs(var_decl)), tree->get_flags(var_decl));
+}
+
+void Compiler::compile_func_decl(const NodeIndex & func_decl){
+	const Symbol name = tree->get_symbol(tree->get_lhs(func_decl));
+	const uint32_t data = tree->get_rhs(func_decl);
+	const NodeIndex block = tree->get_extra(data + 1);
+	const auto args = tree->get_list(data + 2);
+	CompiledFunc * func = heap().make<CompiledFunc>(name);
+
+	// Note: Function is declared before its body is compiled, so it can call itself
+	const bool global_func = is_global_scope();
+	uint32_t local_slot = 0;
+	if(global_func){
+		Global & var = global(name);
+		if(var.defined){
+			error("`" + std::string(symbol_str(name)) + "` is already defined");
+		}
+		if(var.assigned != NO_OFFSET){
+			offset = var.assigned;
+			error("Cannot reassign val `" + std::string(symbol_str(name)) + "`");
+		}
+		var.defined = true;
+		var.is_val = true;
+	}else{
+		local_slot = declare_local(name, true);
+	}
+
+	funcs.push_back(FuncState{.func = func, .scope_depth = 1});
+
+	// Argument is [type?, default value?]
+	auto default_value = [&](const NodeIndex & arg){
+		return tree->get_extra(tree->get_rhs(arg) + 1);
+	};
+
+	for(size_t i = 0; i < args.size(); i++){
+		offset = tree->get_offset(args[i]);
+		const Symbol arg_name = tree->get_symbol(tree->get_lhs(args[i]));
+		declare_local(arg_name, false);
+		func->arg_names.push_back(arg_name);
+		if(default_value(args[i]) == NO_NODE){
+			func->required_args = i + 1;
+		}
+	}
+
+	// Missing arguments are null, default value is set if argument was not passed
+	for(size_t i = 0; i < args.size(); i++){
+		if(default_value(args[i]) != NO_NODE && i >= func->required_args){
+			offset = tree->get_offset(args[i]);
+			emit(BC_ARG_DEFAULT, i);
+			const uint32_t passed = emit_jump(BC_JUMP);
+			compile_expression(default_value(args[i]));
+			emit(BC_SET_LOCAL, i);
+			patch_jump(passed);
+		}
+	}
+
+	compile_block(block, false);
+	emit(BC_LOAD_NULL);
+	emit(BC_RETURN);
+
+	func->local_count = std::max<uint32_t>(func->local_count, state().locals.size());
+	funcs.pop_back();
+
+	TRACE(TL_DEBUG, TC_EVAL, "Compiled ", symbol_str(name), ":\n", func->disassemble());
+
+	offset = tree->get_offset(func_decl);
+	if(func->upvalues.empty()){
+		emit_constant(Value::object(func));
+	}else{
+		chunk().constants.push_back(Value::object(func));
+		emit(BC_CLOSURE, chunk().constants.size() - 1);
+	}
+	if(global_func){
+		emit(BC_DEFINE_GLOBAL, global(name).slot);
+	}else{
+		emit(BC_SET_LOCAL, local_slot);
+	}
+}
+
+void Compiler::compile_while(const NodeIndex & loop){
+	// Note: Condition is placed after body, so iteration has one jump
+	const uint32_t to_condition = emit_jump(BC_JUMP);
+	const uint32_t body = chunk().code.size();
+	state().jump_target = body;
+	compile_block(tree->get_rhs(loop), false);
+	patch_jump(to_condition);
+	compile_expression(tree->get_lhs(loop));
+	offset = tree->get_offset(loop);
+	emit(BC_JUMP_IF_TRUE, body);
+}
+
+void Compiler::compile_for(const NodeIndex & loop){
+	const uint32_t data = tree->get_rhs(loop);
+	compile_expression(tree->get_extra(data));
+	offset = tree->get_offset(loop);
+
+	begin_scope();
+	const uint32_t iterator = declare_local(NO_NAME, false);
+	declare_local(NO_NAME, false);
+	emit(BC_ITER, iterator);
+
+	const uint32_t next = chunk().code.size();
+	state().jump_target = next;
+	emit(BC_FOR_NEXT, iterator);
+	const uint32_t exit = emit_jump(BC_JUMP);
+
+	begin_scope();
+	emit(BC_SET_LOCAL, declare_local(tree->get_symbol(tree->get_lhs(loop)), false));
+	compile_block(tree->get_extra(data + 1), false);
+	end_scope();
+
+	emit(BC_JUMP, next);
+	patch_jump(exit);
+	end_scope();
+}
+
+void Compiler::compile_match(const NodeIndex & match){
+	const uint32_t match_offset = tree->get_offset(match);
+	compile_expression(tree->get_lhs(match));
+	offset = match_offset;
+
+	begin_scope();
+	const uint32_t value = declare_local(NO_NAME, false);
+	emit(BC_SET_LOCAL, value);
+
+	// Cases are [block, count, patterns...]
+	const uint32_t data = tree->get_rhs(match);
+	const NodeIndex else_block = tree->get_extra(data);
+	const uint32_t cases_count = tree->get_extra(data + 1);
+	uint32_t index = data + 2;
+
+	std::vector <uint32_t> ends;
+	for(uint32_t c = 0; c < cases_count; c++){
+		const NodeIndex block = tree->get_extra(index);
+		const uint32_t patterns_count = tree->get_extra(index + 1);
+		std::vector <uint32_t> matched;
+		for(uint32_t p = 0; p < patterns_count; p++){
+			emit(BC_LOAD_LOCAL, value);
+			compile_expression(tree->get_extra(index + 2 + p));
+			offset = match_offset;
+			emit(BC_EQUAL);
+			matched.push_back(emit_jump(BC_JUMP_IF_TRUE));
+		}
+		index += 2 + patterns_count;
+		const uint32_t next_case = emit_jump(BC_JUMP);
+
+		for(const uint32_t & jump : matched){
+			patch_jump(jump);
+		}
+		compile_block(block, false);
+		ends.push_back(emit_jump(BC_JUMP));
+		patch_jump(next_case);
+	}
+
+	if(else_block != NO_NODE){
+		compile_block(else_block, false);
+	}
+
+	for(const uint32_t & jump : ends){
+		patch_jump(jump);
+	}
+	end_scope();
+}
+
+/////////////////
+// Expressions //
+/////////////////
+
+void Compiler::compile_expression(const NodeIndex & expression){
+	offset = tree->get_offset(expression);
+	const uint32_t lhs = tree->get_lhs(expression);
+	const uint32_t rhs = tree->get_rhs(expression);
+
+	switch(tree->get_kind(expression)){
+		case NK_INT:{
+			emit_constant(Value::integer(tree->get_int(expression)));
+			break;
+		}
+		case NK_FLOAT:{
+			emit_constant(Value::number(tree->get_float(expression)));
+			break;
+		}
+		case NK_BOOL:{
+			emit(tree->get_bool(expression) ? BC_LOAD_TRUE : BC_LOAD_FALSE);
+			break;
+		}
+		case NK_STRING:{
+			// Note: Strings are immutable, so literal is one object
+			emit_constant(Value::object(symbol_string(tree->get_symbol(expression))));
+			break;
+		}
+		case NK_IDENTIFIER:{
+			emit_load(resolve(tree->get_symbol(expression), false));
+			break;
+		}
+		case NK_INFIX:{
+			compile_infix(expression);
+			break;
+		}
+		case NK_PREFIX:{
+			const Operator op = tree->get_op(expression);
+			if(op == OP_INC || op == OP_DEC){
+				compile_assign(lhs, op, NO_NODE);
+			}else{
+				compile_expression(lhs);
+				offset = tree->get_offset(expression);
+				emit(BC_PREFIX, op);
+			}
+			break;
+		}
+		case NK_POSTFIX:{
+			const Operator op = tree->get_op(expression);
+			if(tree->get_kind(lhs) != NK_IDENTIFIER){
+				error("Operator `" + op_to_str(op) + "` can be applied only to variable");
+			}
+			const VarRef var = resolve(tree->get_symbol(lhs), true);
+			emit_load(var);
+			emit(BC_DUP);
+			emit(BC_PREFIX, op);
+			emit_store(var);
+			emit(BC_POP);
+			break;
+		}
+		case NK_FUNC_CALL:{
+			const auto args = tree->get_list(rhs);
+			compile_expression(lhs);
+			for(const NodeIndex & arg : args){
+				compile_expression(arg);
+			}
+			offset = tree->get_offset(expression);
+			emit(BC_CALL, args.size());
+			break;
+		}
+		case NK_LIST_ACCESS:{
+			compile_expression(lhs);
+			compile_expression(rhs);
+			offset = tree->get_offset(expression);
+			emit(BC_GET_ITEM);
+			break;
+		}
+		case NK_LIST:{
+			const auto items = tree->get_list(lhs);
+			for(const NodeIndex & item : items){
+				compile_expression(item);
+			}
+			offset = tree->get_offset(expression);
+			emit(BC_LIST, items.size());
+			break;
+		}
+		case NK_CONDITION:{
+			compile_condition(expression, true);
+			break;
+		}
+		case NK_BLOCK:{
+			compile_block(expression, true);
+			break;
+		}
+		case NK_TYPE:
+		case NK_IDENTIFIER_TYPE:
+		case NK_LIST_TYPE:
+		case NK_TUPLE_TYPE:
+		case NK_ERROR:{
+			// Note: Types are not checked at runtime yet
+			emit(BC_LOAD_NULL);
+			break;
+		}
+		default:{
+			error("Expression cannot be compiled");
+		}
+	}
+}
+
+void Compiler::compile_condition(const NodeIndex & condition, const bool & value){
+	std::vector <uint32_t> ends;
+
+	// Branches are [condition, block] pairs of `if` and `elif`s
+	const auto branches = tree->get_list(tree->get_lhs(condition));
+	const NodeIndex else_block = tree->get_rhs(condition);
+	for(size_t i = 0; i < branches.size(); i += 2){
+		compile_expression(branches[i]);
+		const uint32_t next = emit_jump(BC_JUMP_IF_FALSE);
+		compile_block(branches[i + 1], value);
+		// Note: The last branch without `else` falls through to the end, jump over nothing is not emitted
+		if(i + 2 == branches.size() && else_block == NO_NODE && !value){
+			patch_jump(next);
+			break;
+		}
+		ends.push_back(emit_jump(BC_JUMP));
+		// Note: Only one branch leaves value
+		if(value){
+			state().stack_depth--;
+		}
+		patch_jump(next);
+	}
+
+	if(else_block != NO_NODE){
+		compile_block(else_block, value);
+	}else if(value){
+		emit(BC_LOAD_NULL);
+	}
+
+	for(const uint32_t & jump : ends){
+		patch_jump(jump);
+	}
+}
+
+void Compiler::compile_infix(const NodeIndex & infix){
+	const Operator op = tree->get_op(infix);
+	const NodeIndex left = tree->get_lhs(infix);
+	const NodeIndex right = tree->get_rhs(infix);
+	const uint32_t infix_offset = tree->get_offset(infix);
+
+	if(op == OP_ASSIGN || augmented_operator(op) != op){
+		compile_assign(left, augmented_operator(op), right);
+		return;
+	}
+
+	switch(op){
+		case OP_AND:
+		case OP_OR:{
+			compile_logical(infix);
+			return;
+		}
+		case OP_ELVIS:{
+			compile_expression(left);
+			offset = infix_offset;
+			const uint32_t not_null = emit_jump(BC_JUMP_IF_NOT_NULL);
+			compile_expression(right);
+			patch_jump(not_null);
+			return;
+		}
+		case OP_PIPELINE:{
+			// Note: `a |> f` is `f(a)`, argument is evaluated first
+			compile_expression(left);
+			compile_expression(right);
+			offset = infix_offset;
+			emit(BC_SWAP);
+			emit(BC_CALL, 1);
+			return;
+		}
+		default:{
+			compile_expression(left);
+			compile_expression(right);
+			offset = infix_offset;
+			const OpCode opcode = infix_opcode(op);
+			emit(opcode, opcode == BC_INFIX ? op : 0);
+		}
+	}
+}
+
+// `op` is OP_ASSIGN or operator of augmented assignment or OP_INC/OP_DEC (`right` is NO_NODE)
+void Compiler::compile_assign(const NodeIndex & target, const Operator & op, const NodeIndex & right){
+	const uint32_t target_offset = tree->get_offset(target);
+
+	auto update = [&](){
+		if(right == NO_NODE){
+			offset = target_offset;
+			emit(BC_PREFIX, op);
+			return;
+		}
+		compile_expression(right);
+		offset = target_offset;
+		if(op != OP_ASSIGN){
+			const OpCode opcode = infix_opcode(op);
+			emit(opcode, opcode == BC_INFIX ? op : 0);
+		}
+	};
+
+	switch(tree->get_kind(target)){
+		case NK_IDENTIFIER:{
+			offset = target_offset;
+			const VarRef var = resolve(tree->get_symbol(target), true);
+			if(op != OP_ASSIGN){
+				emit_load(var);
+			}
+			update();
+			emit_store(var);
+			break;
+		}
+		case NK_LIST_ACCESS:{
+			compile_expression(tree->get_lhs(target));
+			compile_expression(tree->get_rhs(target));
+			offset = target_offset;
+			if(op != OP_ASSIGN){
+				emit(BC_DUP2);
+				emit(BC_GET_ITEM);
+			}
+			update();
+			emit(BC_SET_ITEM);
+			break;
+		}
+		default:{
+			error("Invalid left-hand side of assignment");
+		}
+	}
+}
+
+void Compiler::compile_logical(const NodeIndex & infix){
+	// Note: `&&` and `||` are short-circuit and result is bool
+	const bool is_and = tree->get_op(infix) == OP_AND;
+	const OpCode skip = is_and ? BC_JUMP_IF_FALSE : BC_JUMP_IF_TRUE;
+	const uint32_t infix_offset = tree->get_offset(infix);
+
+	compile_expression(tree->get_lhs(infix));
+	offset = infix_offset;
+	const uint32_t left_jump = emit_jump(skip);
+	compile_expression(tree->get_rhs(infix));
+	offset = infix_offset;
+	const uint32_t right_jump = emit_jump(skip);
+
+	emit(is_and ? BC_LOAD_TRUE : BC_LOAD_FALSE);
+	const uint32_t end = emit_jump(BC_JUMP);
+	state().stack_depth--;
+
+	patch_jump(left_jump);
+	patch_jump(right_jump);
+	emit(is_and ? BC_LOAD_FALSE : BC_LOAD_TRUE);
+	patch_jump(end);
+}
@@ -0,0 +1,132 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "Node.h"
+#include "FlatTree.h"
+#include "Bytecode.h"
+
+// Compiler translates flat AST to bytecode of VM (pointer tree is flattened first).
+// Top-level variables and functions are globals, they're resolved to slots
+// (global is created on the first use, so function can use global declared after it).
+// Variables of blocks and functions are locals, slot of local is reused after its block ends.
+// Locals of enclosing functions used by function are its upvalues (see Upvalue),
+// such function is made into Closure when its declaration is executed,
+// and upvalues of captured locals are closed when their block ends.
+// Errors (e.g. assignment to `val`) are thrown as RuntimeError at offset of node
+class Compiler {
+	public:
+		Compiler();
+		virtual ~Compiler() = default;
+
+		Program compile(const FlatTree & tree);
+		Program compile(const StatementList & tree);
+
+	private:
+		// Note: Hidden locals (e.g. list of `for`) have no name
+		static constexpr Symbol NO_NAME = UINT32_MAX;
+
+		static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+		struct Local {
+			Symbol name;
+			bool is_val;
+			uint32_t depth;
+			// Local is upvalue of nested function
+			bool captured = false;
+		};
+
+		struct Capture {
+			Symbol name;
+			bool is_val;
+		};
+
+		struct FuncState {
+			CompiledFunc * func = nullptr;
+			// Slot of local is its index
+			std::vector <Local> locals {};
+			uint32_t scope_depth = 0;
+			uint32_t stack_depth = 0;
+			// Instructions before this one cannot be merged (jump lands here)
+			uint32_t jump_target = 0;
+			// Variables of enclosing functions, index of capture is index of upvalue (see `CompiledFunc::upvalues`)
+			std::vector <Capture> captures {};
+		};
+		std::vector <FuncState> funcs;
+
+		struct Global {
+			uint32_t slot;
+			bool is_val;
+			bool defined;
+			// Offset of the first assignment, to report assignment to `val` declared after it
+			uint32_t assigned;
+		};
+		std::unordered_map <Symbol, Global> globals;
+		std::vector <Symbol> global_names;
+
+		const FlatTree * tree;
+
+		// Offset of node being compiled
+		uint32_t offset;
+
+		FuncState & state(){
+			return funcs.back();
+		}
+		Chunk & chunk(){
+			return funcs.back().func->chunk;
+		}
+
+		// Code
+		uint32_t emit(const OpCode & op, const uint32_t & arg = 0);
+		uint32_t emit_jump(const OpCode & op);
+		void patch_jump(const uint32_t & jump);
+		void emit_constant(const Value & value);
+
+		// Variables
+		enum VarKind {
+			VAR_LOCAL,
+			VAR_UPVALUE,
+			VAR_GLOBAL
+		};
+		struct VarRef {
+			VarKind kind;
+			uint32_t slot;
+		};
+
+		bool is_global_scope();
+		void begin_scope();
+		void end_scope();
+		uint32_t declare_local(const Symbol & name, const bool & is_val);
+		Global & global(const Symbol & name);
+		void define(const Symbol & name, const bool & is_val);
+		VarRef resolve(const Symbol & name, const bool & assign);
+		// Slot of visible local of `funcs[f]` or NO_SLOT
+		uint32_t find_local(const size_t & f, const Symbol & name);
+		// Index of upvalue of `funcs[f]` or NO_SLOT if `name` is not a local of enclosing functions
+		uint32_t resolve_upvalue(const size_t & f, const Symbol & name);
+		void emit_load(const VarRef & var);
+		void emit_store(const VarRef & var);
+
+		// Statements
+		void compile_statement(const NodeIndex & statement);
+		void compile_block(const NodeIndex & block, const bool & value);
+		void compile_var_decl(const NodeIndex & var_decl);
+		void compile_func_decl(const NodeIndex & func_decl);
+		void compile_while(const NodeIndex & loop);
+		void compile_for(const NodeIndex & loop);
+		void compile_match(const NodeIndex & match);
+
+		// Expressions
+		void compile_expression(const NodeIndex & expression);
+		void compile_condition(const NodeIndex & condition, const bool & value);
+		void compile_infix(const NodeIndex & infix);
+		void compile_assign(const NodeIndex & target, const Operator & op, const NodeIndex & right);
+		void compile_logical(const NodeIndex & infix);
+
+		[[noreturn]] void error(const std::string & msg);
+};
+
+#endif
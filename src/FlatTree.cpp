@@ -0,0 +1,699 @@
+#include "FlatTree.h"
+#include "node.h"
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+static_assert(OP_COUNT <= 256, "Operator must fit into node flags");
+
+NodeIndex FlatTree::add(const NodeKind & kind,
+						const uint32_t & offset,
+						const uint32_t & lhs,
+						const uint32_t & rhs,
+						const uint8_t & flags)
+{
+	kinds.push_back(kind);
+	this->flags.push_back(flags);
+	offsets.push_back(offset);
+	this->lhs.push_back(lhs);
+	this->rhs.push_back(rhs);
+	return kinds.size() - 1;
+}
+
+uint32_t FlatTree::add_extra(std::initializer_list <uint32_t> words){
+	const uint32_t start = extra.size();
+	extra.insert(extra.end(), words);
+	return start;
+}
+
+uint32_t FlatTree::add_list(const std::vector <NodeIndex> & items){
+	const uint32_t start = extra.size();
+	extra.push_back(items.size());
+	extra.insert(extra.end(), items.begin(), items.end());
+	return start;
+}
+
+void FlatTree::clear(){
+	kinds.clear();
+	flags.clear();
+	offsets.clear();
+	lhs.clear();
+	rhs.clear();
+	extra.clear();
+	roots.clear();
+}
+
+int64_t FlatTree::get_int(const NodeIndex & node) const {
+	return static_cast<int64_t>(static_cast<uint64_t>(rhs[node]) << 32 | lhs[node]);
+}
+
+double FlatTree::get_float(const NodeIndex & node) const {
+	const uint64_t bits = static_cast<uint64_t>(rhs[node]) << 32 | lhs[node];
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+size_t FlatTree::memory_size() const {
+	return kinds.size() * (sizeof(NodeKind) + sizeof(uint8_t) + 3 * sizeof(uint32_t))
+		 + (extra.size() + roots.size()) * sizeof(uint32_t);
+}
+
+////////////////
+// Flattening //
+////////////////
+
+// Note: Children are flattened before parent, so tree is stored in post-order
+
+static NodeIndex flatten_optional(Node * node, FlatTree & tree){
+	return node ? node->flatten(tree) : NO_NODE;
+}
+
+template <class T>
+static uint32_t flatten_list(const std::vector <T*> & nodes, FlatTree & tree){
+	std::vector <NodeIndex> items;
+	items.reserve(nodes.size());
+	for(T * node : nodes){
+		items.push_back(node->flatten(tree));
+	}
+	return tree.add_list(items);
+}
+
+static void split_u64(const uint64_t & bits, uint32_t & lo, uint32_t & hi){
+	lo = static_cast<uint32_t>(bits);
+	hi = static_cast<uint32_t>(bits >> 32);
+}
+
+NodeIndex Node::flatten(FlatTree & tree){
+	return tree.add(NK_NONE, offset);
+}
+
+NodeIndex NExpressionStatement::flatten(FlatTree & tree){
+	const NodeIndex expr = expression.flatten(tree);
+	return tree.add(NK_EXPR_STMT, offset, expr);
+}
+
+NodeIndex NInt::flatten(FlatTree & tree){
+	uint32_t lo, hi;
+	split_u64(static_cast<uint64_t>(value), lo, hi);
+	return tree.add(NK_INT, offset, lo, hi);
+}
+
+NodeIndex NFloat::flatten(FlatTree & tree){
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	uint32_t lo, hi;
+	split_u64(bits, lo, hi);
+	return tree.add(NK_FLOAT, offset, lo, hi);
+}
+
+NodeIndex NBool::flatten(FlatTree & tree){
+	return tree.add(NK_BOOL, offset, value);
+}
+
+NodeIndex NString::flatten(FlatTree & tree){
+	return tree.add(NK_STRING, offset, value);
+}
+
+NodeIndex NIdentifier::flatten(FlatTree & tree){
+	return tree.add(NK_IDENTIFIER, offset, name);
+}
+
+NodeIndex NBlock::flatten(FlatTree & tree){
+	const uint32_t list = flatten_list(statements, tree);
+	return tree.add(NK_BLOCK, offset, list);
+}
+
+NodeIndex NInfixOp::flatten(FlatTree & tree){
+	const NodeIndex l = left.flatten(tree);
+	const NodeIndex r = right.flatten(tree);
+	return tree.add(NK_INFIX, offset, l, r, op);
+}
+
+NodeIndex NPrefixOp::flatten(FlatTree & tree){
+	const NodeIndex r = right.flatten(tree);
+	return tree.add(NK_PREFIX, offset, r, NO_NODE, op);
+}
+
+NodeIndex NPostfixOp::flatten(FlatTree & tree){
+	const NodeIndex l = left.flatten(tree);
+	return tree.add(NK_POSTFIX, offset, l, NO_NODE, op);
+}
+
+NodeIndex NType::flatten(FlatTree & tree){
+	return tree.add(NK_TYPE, offset, NO_NODE, NO_NODE, nullable);
+}
+
+NodeIndex NIdentifierType::flatten(FlatTree & tree){
+	const NodeIndex id_index = id.flatten(tree);
+	return tree.add(NK_IDENTIFIER_TYPE, offset, id_index, NO_NODE, nullable);
+}
+
+NodeIndex NListType::flatten(FlatTree & tree){
+	const NodeIndex wrapped = wrapped_type.flatten(tree);
+	return tree.add(NK_LIST_TYPE, offset, wrapped, NO_NODE, nullable);
+}
+
+NodeIndex NTupleType::flatten(FlatTree & tree){
+	const uint32_t list = flatten_list(types, tree);
+	return tree.add(NK_TUPLE_TYPE, offset, list, NO_NODE, nullable);
+}
+
+NodeIndex NTypeDecl::flatten(FlatTree & tree){
+	const NodeIndex id_index = id.flatten(tree);
+	const NodeIndex type_index = type.flatten(tree);
+	return tree.add(NK_TYPE_DECL, offset, id_index, type_index);
+}
+
+NodeIndex NVarDecl::flatten(FlatTree & tree){
+	const NodeIndex id_index = id.flatten(tree);
+	const NodeIndex type_index = flatten_optional(type, tree);
+	const NodeIndex assign_index = flatten_optional(assignment_expr, tree);
+	return tree.add(NK_VAR_DECL, offset, id_index, tree.add_extra({type_index, assign_index}), is_val);
+}
+
+NodeIndex NArgDecl::flatten(FlatTree & tree){
+	const NodeIndex id_index = id.flatten(tree);
+	const NodeIndex type_index = flatten_optional(type, tree);
+	const NodeIndex default_index = flatten_optional(default_value, tree);
+	return tree.add(NK_ARG_DECL, offset, id_index, tree.add_extra({type_index, default_index}));
+}
+
+NodeIndex NFuncCall::flatten(FlatTree & tree){
+	const NodeIndex l = left.flatten(tree);
+	const uint32_t list = flatten_list(args, tree);
+	return tree.add(NK_FUNC_CALL, offset, l, list);
+}
+
+NodeIndex NReturn::flatten(FlatTree & tree){
+	const NodeIndex r = flatten_optional(right, tree);
+	return tree.add(NK_RETURN, offset, r);
+}
+
+NodeIndex NFuncDecl::flatten(FlatTree & tree){
+	const NodeIndex id_index = id.flatten(tree);
+	std::vector <NodeIndex> arg_indices;
+	arg_indices.reserve(args.size());
+	for(NArgDecl * arg : args){
+		arg_indices.push_back(arg->flatten(tree));
+	}
+	const NodeIndex return_index = flatten_optional(return_type, tree);
+	const NodeIndex block_index = block.flatten(tree);
+
+	const uint32_t data = tree.add_extra({return_index, block_index});
+	tree.add_list(arg_indices);
+	return tree.add(NK_FUNC_DECL, offset, id_index, data);
+}
+
+NodeIndex NListAccess::flatten(FlatTree & tree){
+	const NodeIndex l = left.flatten(tree);
+	const NodeIndex a = access.flatten(tree);
+	return tree.add(NK_LIST_ACCESS, offset, l, a);
+}
+
+NodeIndex NList::flatten(FlatTree & tree){
+	const uint32_t list = flatten_list(expressions, tree);
+	return tree.add(NK_LIST, offset, list);
+}
+
+NodeIndex NCondition::flatten(FlatTree & tree){
+	std::vector <NodeIndex> pairs;
+	pairs.reserve((Elifs.size() + 1) * 2);
+	pairs.push_back(If.first->flatten(tree));
+	pairs.push_back(If.second->flatten(tree));
+	for(const ConditionBlock & elif : Elifs){
+		pairs.push_back(elif.first->flatten(tree));
+		pairs.push_back(elif.second->flatten(tree));
+	}
+	const NodeIndex else_index = flatten_optional(Else, tree);
+	return tree.add(NK_CONDITION, offset, tree.add_list(pairs), else_index);
+}
+
+NodeIndex NWhile::flatten(FlatTree & tree){
+	const NodeIndex cond = condition.flatten(tree);
+	const NodeIndex block_index = block.flatten(tree);
+	return tree.add(NK_WHILE, offset, cond, block_index);
+}
+
+NodeIndex NFor::flatten(FlatTree & tree){
+	const NodeIndex for_index = For.flatten(tree);
+	const NodeIndex in_index = In.flatten(tree);
+	const NodeIndex block_index = block.flatten(tree);
+	return tree.add(NK_FOR, offset, for_index, tree.add_extra({in_index, block_index}));
+}
+
+NodeIndex NMatch::flatten(FlatTree & tree){
+	const NodeIndex expr = expression.flatten(tree);
+
+	// Note: Cases data is written after all children are flattened
+	std::vector <NodeIndex> cases;
+	for(const MatchCase & match_case : Cases){
+		std::vector <NodeIndex> patterns;
+		patterns.reserve(match_case.first.size());
+		for(NExpression * pattern : match_case.first){
+			patterns.push_back(pattern->flatten(tree));
+		}
+		cases.push_back(match_case.second->flatten(tree));
+		cases.push_back(patterns.size());
+		cases.insert(cases.end(), patterns.begin(), patterns.end());
+	}
+	const NodeIndex else_index = flatten_optional(Else, tree);
+
+	const uint32_t data = tree.add_extra({else_index, static_cast<uint32_t>(Cases.size())});
+	for(const NodeIndex & word : cases){
+		tree.add_extra({word});
+	}
+	return tree.add(NK_MATCH, offset, expr, data);
+}
+
+NodeIndex NError::flatten(FlatTree & tree){
+	return tree.add(NK_ERROR, offset);
+}
+
+////////////////
+// Validation //
+////////////////
+
+static bool is_type_kind(const NodeKind & kind){
+	return kind == NK_TYPE || kind == NK_IDENTIFIER_TYPE || kind == NK_LIST_TYPE || kind == NK_TUPLE_TYPE || kind == NK_ERROR;
+}
+
+static bool is_expression_kind(const NodeKind & kind){
+	switch(kind){
+		case NK_INT:
+		case NK_FLOAT:
+		case NK_BOOL:
+		case NK_STRING:
+		case NK_IDENTIFIER:
+		case NK_BLOCK:
+		case NK_INFIX:
+		case NK_PREFIX:
+		case NK_POSTFIX:
+		case NK_FUNC_CALL:
+		case NK_LIST_ACCESS:
+		case NK_LIST:
+		case NK_CONDITION: return true;
+		default: return is_type_kind(kind);
+	}
+}
+
+static bool is_statement_kind(const NodeKind & kind){
+	switch(kind){
+		case NK_EXPR_STMT:
+		case NK_TYPE_DECL:
+		case NK_VAR_DECL:
+		case NK_RETURN:
+		case NK_FUNC_DECL:
+		case NK_WHILE:
+		case NK_FOR:
+		case NK_MATCH: return true;
+		default: return false;
+	}
+}
+
+bool FlatTree::validate() const {
+	const size_t count = kinds.size();
+	if(flags.size() != count || offsets.size() != count || lhs.size() != count || rhs.size() != count){
+		return false;
+	}
+
+	// Child of `parent` must be before it and must have no other parent
+	NodeIndex parent = 0;
+	std::vector <bool> has_parent(count, false);
+	// Note: Depth of node is known when its parent is checked, as children are before parent
+	std::vector <uint32_t> depths(count, 1);
+	uint32_t depth = 1;
+	auto child = [&](const uint32_t & index, bool (*is_kind)(const NodeKind &)){
+		if(index >= parent || has_parent[index] || !is_kind(kinds[index])){
+			return false;
+		}
+		has_parent[index] = true;
+		depth = std::max(depth, depths[index] + 1);
+		return true;
+	};
+	auto optional = [&](const uint32_t & index, bool (*is_kind)(const NodeKind &)){
+		return index == NO_NODE || child(index, is_kind);
+	};
+	auto is_block = [](const NodeKind & kind){ return kind == NK_BLOCK; };
+	auto is_identifier = [](const NodeKind & kind){ return kind == NK_IDENTIFIER; };
+	auto is_arg = [](const NodeKind & kind){ return kind == NK_ARG_DECL; };
+	// `count` words of `extra` from `start`
+	auto words = [&](const uint32_t & start, const uint64_t & count){
+		return start <= extra.size() && count <= extra.size() - start;
+	};
+	auto list = [&](const uint32_t & start, bool (*is_kind)(const NodeKind &)){
+		if(!words(start, 1) || !words(start + 1, extra[start])){
+			return false;
+		}
+		for(const NodeIndex & item : get_list(start)){
+			if(!child(item, is_kind)){
+				return false;
+			}
+		}
+		return true;
+	};
+
+	for(; parent < count; parent++){
+		const uint32_t l = lhs[parent];
+		const uint32_t r = rhs[parent];
+		bool valid = true;
+		depth = 1;
+		switch(kinds[parent]){
+			case NK_INT:
+			case NK_FLOAT:
+			case NK_BOOL:
+			case NK_STRING:
+			case NK_IDENTIFIER:
+			case NK_TYPE:
+			case NK_ERROR: break;
+			case NK_EXPR_STMT: valid = child(l, is_expression_kind); break;
+			case NK_BLOCK: valid = list(l, is_statement_kind); break;
+			case NK_INFIX: valid = get_op(parent) < OP_COUNT && child(l, is_expression_kind) && child(r, is_expression_kind); break;
+			case NK_PREFIX:
+			case NK_POSTFIX: valid = get_op(parent) < OP_COUNT && child(l, is_expression_kind); break;
+			case NK_IDENTIFIER_TYPE: valid = child(l, is_identifier); break;
+			case NK_LIST_TYPE: valid = child(l, is_type_kind); break;
+			case NK_TUPLE_TYPE: valid = list(l, is_type_kind); break;
+			case NK_TYPE_DECL: valid = child(l, is_identifier) && child(r, is_type_kind); break;
+			case NK_VAR_DECL:
+			case NK_ARG_DECL:{
+				valid = child(l, is_identifier) && words(r, 2)
+					 && optional(extra[r], is_type_kind) && optional(extra[r + 1], is_expression_kind);
+				break;
+			}
+			case NK_FUNC_CALL: valid = child(l, is_expression_kind) && list(r, is_expression_kind); break;
+			case NK_RETURN: valid = optional(l, is_expression_kind); break;
+			case NK_FUNC_DECL:{
+				valid = child(l, is_identifier) && words(r, 2)
+					 && optional(extra[r], is_type_kind) && child(extra[r + 1], is_block) && list(r + 2, is_arg);
+				break;
+			}
+			case NK_LIST_ACCESS: valid = child(l, is_expression_kind) && child(r, is_expression_kind); break;
+			case NK_LIST: valid = list(l, is_expression_kind); break;
+			case NK_CONDITION:{
+				valid = words(l, 1) && extra[l] > 0 && extra[l] % 2 == 0 && words(l + 1, extra[l]) && optional(r, is_block);
+				const auto pairs = valid ? get_list(l) : std::span <const NodeIndex>();
+				for(size_t i = 0; valid && i < pairs.size(); i += 2){
+					valid = child(pairs[i], is_expression_kind) && child(pairs[i + 1], is_block);
+				}
+				break;
+			}
+			case NK_WHILE: valid = child(l, is_expression_kind) && child(r, is_block); break;
+			case NK_FOR: valid = child(l, is_identifier) && words(r, 2) && child(extra[r], is_expression_kind) && child(extra[r + 1], is_block); break;
+			case NK_MATCH:{
+				valid = child(l, is_expression_kind) && words(r, 2) && optional(extra[r], is_block);
+				uint32_t i = r + 2;
+				for(uint32_t c = 0; valid && c < extra[r + 1]; c++){
+					valid = words(i, 2) && child(extra[i], is_block) && words(i + 2, extra[i + 1]);
+					for(uint32_t p = 0; valid && p < extra[i + 1]; p++){
+						valid = child(extra[i + 2 + p], is_expression_kind);
+					}
+					if(valid){
+						i += 2 + extra[i + 1];
+					}
+				}
+				break;
+			}
+			default: valid = false;
+		}
+		if(!valid || depth > MAX_TREE_DEPTH){
+			return false;
+		}
+		depths[parent] = depth;
+	}
+
+	for(const NodeIndex & root : roots){
+		if(root >= count || has_parent[root] || !is_statement_kind(kinds[root])){
+			return false;
+		}
+		has_parent[root] = true;
+	}
+	return true;
+}
+
+/////////////////
+// Rehydration //
+/////////////////
+
+// Note: Nodes are made in post-order, so children are already made when parent is made
+std::vector <NStatement*> FlatTree::to_nodes(Arena & arena) const {
+	std::vector <Node*> nodes(kinds.size(), nullptr);
+
+	auto expression = [&](const NodeIndex & node){
+		return static_cast<NExpression*>(nodes[node]);
+	};
+	auto optional_expression = [&](const NodeIndex & node){
+		return node == NO_NODE ? nullptr : expression(node);
+	};
+	auto type = [&](const NodeIndex & node){
+		return static_cast<NType*>(nodes[node]);
+	};
+	auto optional_type = [&](const NodeIndex & node){
+		return node == NO_NODE ? nullptr : type(node);
+	};
+	auto identifier = [&](const NodeIndex & node){
+		return static_cast<NIdentifier*>(nodes[node]);
+	};
+	auto block = [&](const NodeIndex & node){
+		return static_cast<NBlock*>(nodes[node]);
+	};
+	auto optional_block = [&](const NodeIndex & node){
+		return node == NO_NODE ? nullptr : block(node);
+	};
+	auto expressions = [&](const uint32_t & start){
+		ExpressionList list;
+		for(const NodeIndex & item : get_list(start)){
+			list.push_back(expression(item));
+		}
+		return list;
+	};
+
+	for(NodeIndex node = 0; node < kinds.size(); node++){
+		const uint32_t offset = offsets[node];
+		const uint32_t l = lhs[node];
+		const uint32_t r = rhs[node];
+		Node * made = nullptr;
+
+		switch(kinds[node]){
+			case NK_NONE: break;
+			case NK_EXPR_STMT: made = arena.make<NExpressionStatement>(*expression(l), offset); break;
+			case NK_INT: made = arena.make<NInt>(get_int(node), offset); break;
+			case NK_FLOAT: made = arena.make<NFloat>(get_float(node), offset); break;
+			case NK_BOOL: made = arena.make<NBool>(get_bool(node), offset); break;
+			case NK_STRING: made = arena.make<NString>(get_symbol(node), offset); break;
+			case NK_IDENTIFIER: made = arena.make<NIdentifier>(get_symbol(node), offset); break;
+			case NK_BLOCK:{
+				NBlock * block_node = arena.make<NBlock>(offset);
+				for(const NodeIndex & statement : get_list(l)){
+					block_node->statements.push_back(static_cast<NStatement*>(nodes[statement]));
+				}
+				made = block_node;
+				break;
+			}
+			case NK_INFIX: made = arena.make<NInfixOp>(*expression(l), get_op(node), *expression(r), offset); break;
+			case NK_PREFIX: made = arena.make<NPrefixOp>(get_op(node), *expression(l), offset); break;
+			case NK_POSTFIX: made = arena.make<NPostfixOp>(*expression(l), get_op(node), offset); break;
+			case NK_TYPE:{
+				NType * type_node = arena.make<NType>(offset);
+				type_node->nullable = flags[node];
+				made = type_node;
+				break;
+			}
+			case NK_IDENTIFIER_TYPE:{
+				NIdentifierType * type_node = arena.make<NIdentifierType>(*identifier(l), offset);
+				type_node->nullable = flags[node];
+				made = type_node;
+				break;
+			}
+			case NK_LIST_TYPE:{
+				NListType * type_node = arena.make<NListType>(*type(l), offset);
+				type_node->nullable = flags[node];
+				made = type_node;
+				break;
+			}
+			case NK_TUPLE_TYPE:{
+				std::vector <NType*> types;
+				for(const NodeIndex & item : get_list(l)){
+					types.push_back(type(item));
+				}
+				NTupleType * type_node = arena.make<NTupleType>(types, offset);
+				type_node->nullable = flags[node];
+				made = type_node;
+				break;
+			}
+			case NK_TYPE_DECL: made = arena.make<NTypeDecl>(*identifier(l), *type(r), offset); break;
+			case NK_VAR_DECL:{
+				made = arena.make<NVarDecl>(flags[node] != 0, *identifier(l), optional_type(extra[r]), optional_expression(extra[r + 1]), offset);
+				break;
+			}
+			case NK_ARG_DECL:{
+				made = arena.make<NArgDecl>(*identifier(l), optional_type(extra[r]), optional_expression(extra[r + 1]), offset);
+				break;
+			}
+			case NK_FUNC_CALL: made = arena.make<NFuncCall>(*expression(l), expressions(r), offset); break;
+			case NK_RETURN: made = arena.make<NReturn>(optional_expression(l), offset); break;
+			case NK_FUNC_DECL:{
+				ArgList args;
+				for(const NodeIndex & arg : get_list(r + 2)){
+					args.push_back(static_cast<NArgDecl*>(nodes[arg]));
+				}
+				made = arena.make<NFuncDecl>(*identifier(l), args, optional_type(extra[r]), *block(extra[r + 1]), offset);
+				break;
+			}
+			case NK_LIST_ACCESS: made = arena.make<NListAccess>(*expression(l), *expression(r), offset); break;
+			case NK_LIST: made = arena.make<NList>(expressions(l), offset); break;
+			case NK_CONDITION:{
+				const auto pairs = get_list(l);
+				ConditionBlock If(expression(pairs[0]), block(pairs[1]));
+				std::vector <ConditionBlock> Elifs;
+				for(size_t i = 2; i < pairs.size(); i += 2){
+					Elifs.emplace_back(expression(pairs[i]), block(pairs[i + 1]));
+				}
+				made = arena.make<NCondition>(If, Elifs, optional_block(r), offset);
+				break;
+			}
+			case NK_WHILE: made = arena.make<NWhile>(*expression(l), *block(r), offset); break;
+			case NK_FOR: made = arena.make<NFor>(*identifier(l), *expression(extra[r]), *block(extra[r + 1]), offset); break;
+			case NK_MATCH:{
+				std::vector <MatchCase> cases;
+				uint32_t i = r + 2;
+				for(uint32_t c = 0; c < extra[r + 1]; c++){
+					ExpressionList patterns;
+					for(uint32_t p = 0; p < extra[i + 1]; p++){
+						patterns.push_back(expression(extra[i + 2 + p]));
+					}
+					cases.emplace_back(patterns, block(extra[i]));
+					i += 2 + extra[i + 1];
+				}
+				made = arena.make<NMatch>(*expression(l), cases, optional_block(extra[r]), offset);
+				break;
+			}
+			case NK_ERROR: made = arena.make<NError>(offset); break;
+		}
+		nodes[node] = made;
+	}
+
+	std::vector <NStatement*> statements;
+	statements.reserve(roots.size());
+	for(const NodeIndex & root : roots){
+		statements.push_back(static_cast<NStatement*>(nodes[root]));
+	}
+	return statements;
+}
+
+///////////////
+// Debugging //
+///////////////
+
+std::string FlatTree::list_to_string(const uint32_t & start, const std::string & sep) const {
+	std::string str;
+	const auto items = get_list(start);
+	for(size_t i = 0; i < items.size(); i++){
+		str += to_string(items[i]);
+		if(i != items.size() - 1){
+			str += sep;
+		}
+	}
+	return str;
+}
+
+std::string FlatTree::statements_to_string(const uint32_t & start) const {
+	std::string str;
+	for(const NodeIndex & statement : get_list(start)){
+		str += to_string(statement) + '\n';
+	}
+	return str;
+}
+
+std::string FlatTree::nullable_to_string(const NodeIndex & node) const {
+	return flags[node] ? "?" : "";
+}
+
+std::string FlatTree::to_string(const NodeIndex & node) const {
+	const uint32_t l = lhs[node];
+	const uint32_t r = rhs[node];
+
+	switch(kinds[node]){
+		case NK_NONE: return "[NODE]";
+		case NK_EXPR_STMT: return to_string(l);
+		case NK_INT: return std::to_string(get_int(node));
+		case NK_FLOAT: return std::to_string(get_float(node));
+		case NK_BOOL: return get_bool(node) ? "true" : "false";
+		case NK_STRING: return "'" + std::string(symbol_str(get_symbol(node))) + "'";
+		case NK_IDENTIFIER: return "[NIdentifier] " + std::string(symbol_str(get_symbol(node)));
+		case NK_BLOCK: return "[NBlock] " + statements_to_string(l);
+		case NK_INFIX:{
+			return "[NInfixOp] " + to_string(l) + " " + op_to_str(get_op(node)) + " " + to_string(r);
+		}
+		case NK_PREFIX: return "[NPrefixOp] " + op_to_str(get_op(node)) + " " + to_string(l);
+		case NK_POSTFIX: return "[NPostfixOp] " + to_string(l) + " " + op_to_str(get_op(node));
+		case NK_TYPE: return "[NType]";
+		case NK_IDENTIFIER_TYPE: return to_string(l) + nullable_to_string(node);
+		case NK_LIST_TYPE: return "[" + to_string(l) + "]" + nullable_to_string(node);
+		case NK_TUPLE_TYPE: return "(" + list_to_string(l, ", ") + ")" + nullable_to_string(node);
+		case NK_TYPE_DECL: return "type "+ to_string(l) +" = "+ to_string(r);
+		case NK_VAR_DECL:{
+			const NodeIndex type = extra[r];
+			const NodeIndex assign = extra[r + 1];
+			return std::string(flags[node] ? "val" : "var") + " " + to_string(l) + ": " +
+				   (type != NO_NODE ? to_string(type) : "any") +
+				   (assign != NO_NODE ? " = " + to_string(assign) : "");
+		}
+		case NK_ARG_DECL:{
+			const NodeIndex type = extra[r];
+			const NodeIndex default_value = extra[r + 1];
+			return to_string(l) +
+				   (type != NO_NODE ? ": " + to_string(type) : "") +
+				   (default_value != NO_NODE ? " = " + to_string(default_value) : "");
+		}
+		case NK_FUNC_CALL: return "[NFuncCall] " + to_string(l) + "(" + list_to_string(r, ", ") + ")";
+		case NK_RETURN: return "return " + (l != NO_NODE ? to_string(l) : "");
+		case NK_FUNC_DECL:{
+			const NodeIndex return_type = extra[r];
+			const NodeIndex block = extra[r + 1];
+			std::string args_str;
+			for(const NodeIndex & arg : get_list(r + 2)){
+				args_str += to_string(arg) + ", ";
+			}
+			return "func " + to_string(l) + "(" + args_str + ")" +
+				   (return_type != NO_NODE ? ": " + to_string(return_type) : "") +
+				   "{\n" + to_string(block) + "\n}";
+		}
+		case NK_LIST_ACCESS: return "[NListAccess] " + to_string(l) + "[" + to_string(r) + "]";
+		case NK_LIST: return "[" + list_to_string(l, ", ") + "]";
+		case NK_CONDITION:{
+			const auto pairs = get_list(l);
+			std::string str;
+			for(size_t i = 0; i < pairs.size(); i += 2){
+				str += std::string(i == 0 ? "if" : "elif") +"("+ to_string(pairs[i]) +"){\n"+ to_string(pairs[i + 1]) + "\n}";
+				str += '\n';
+			}
+			return str + "else{" + (r != NO_NODE ? to_string(r) : "") + "}";
+		}
+		case NK_WHILE: return "while("+ to_string(l) +"){\n"+ to_string(r) +"\n}";
+		case NK_FOR: return "for("+ to_string(l) +" in "+ to_string(extra[r]) +"){\n"+ to_string(extra[r + 1]) +"\n}";
+		case NK_MATCH:{
+			const NodeIndex else_block = extra[r];
+			const uint32_t count = extra[r + 1];
+			std::string cases_string;
+			uint32_t i = r + 2;
+			for(uint32_t c = 0; c < count; c++){
+				const NodeIndex block = extra[i];
+				const uint32_t patterns_count = extra[i + 1];
+				for(uint32_t p = 0; p < patterns_count; p++){
+					cases_string += to_string(extra[i + 2 + p]);
+					if(p != patterns_count - 1){
+						cases_string += ", ";
+					}
+				}
+				cases_string += " => " + to_string(block);
+				i += 2 + patterns_count;
+			}
+			return "match("+ to_string(l) +"){\n" + cases_string + "else => " + (else_block != NO_NODE ? to_string(else_block) : "") +"}";
+		}
+		case NK_ERROR: return "[NError]";
+	}
+
+	return "[NODE]";
+}
@@ -0,0 +1,185 @@
+#ifndef FLATTREE_H
+#define FLATTREE_H
+
+#include <vector>
+#include <span>
+#include <string>
+#include <cstdint>
+
+#include "Token.h"
+#include "Interner.h"
+
+// FlatTree is compact encoding of AST: node kinds, flags, offsets and two data words
+// are stored in parallel arrays, children are referenced by 32-bit NodeIndex.
+// Node is 14 bytes and nodes are laid out in post-order (children before parent),
+// so passes over the tree read memory sequentially.
+// Variable-length data (lists, more than two children) is stored in `extra`,
+// list is stored as `[count, items...]` and referenced by its start in `extra`.
+// Compiler works on FlatTree, so programs loaded from AstCache are compiled without pointer tree.
+
+typedef uint32_t NodeIndex;
+
+struct NStatement;
+class Arena;
+
+// Note: Used for optional children (e.g. `NReturn` without expression)
+const NodeIndex NO_NODE = UINT32_MAX;
+
+// Trees deeper than this are rejected by Parser and `validate`,
+// because walks of tree (to_string, flatten, Resolver, Compiler, tree walker) are recursive
+const uint32_t MAX_TREE_DEPTH = 4096;
+
+// Layout of node data by kind:
+// NK_NONE
+// NK_EXPR_STMT        lhs: expression
+// NK_INT              lhs: low 32 bits, rhs: high 32 bits
+// NK_FLOAT            lhs: low 32 bits, rhs: high 32 bits of double
+// NK_BOOL             lhs: value
+// NK_STRING           lhs: Symbol
+// NK_IDENTIFIER       lhs: Symbol
+// NK_BLOCK            lhs: list of statements
+// NK_INFIX            flags: Operator, lhs: left, rhs: right
+// NK_PREFIX           flags: Operator, lhs: right
+// NK_POSTFIX          flags: Operator, lhs: left
+// NK_TYPE             flags: nullable
+// NK_IDENTIFIER_TYPE  flags: nullable, lhs: identifier
+// NK_LIST_TYPE        flags: nullable, lhs: wrapped type
+// NK_TUPLE_TYPE       flags: nullable, lhs: list of types
+// NK_TYPE_DECL        lhs: identifier, rhs: type
+// NK_VAR_DECL         flags: is_val, lhs: identifier, rhs: extra [type?, assignment?]
+// NK_ARG_DECL         lhs: identifier, rhs: extra [type?, default value?]
+// NK_FUNC_CALL        lhs: left, rhs: list of arguments
+// NK_RETURN           lhs: expression?
+// NK_FUNC_DECL        lhs: identifier, rhs: extra [return type?, block, count, args...]
+// NK_LIST_ACCESS      lhs: left, rhs: access
+// NK_LIST             lhs: list of expressions
+// NK_CONDITION        lhs: list of [condition, block] pairs (`if` and `elif`s), rhs: else block?
+// NK_WHILE            lhs: condition, rhs: block
+// NK_FOR              lhs: identifier, rhs: extra [in, block]
+// NK_MATCH            lhs: expression, rhs: extra [else?, count, cases...],
+//                     case is [block, count, patterns...]
+// NK_ERROR
+enum NodeKind : uint8_t {
+	NK_NONE,
+	NK_EXPR_STMT,
+	NK_INT, NK_FLOAT, NK_BOOL, NK_STRING,
+	NK_IDENTIFIER,
+	NK_BLOCK,
+	NK_INFIX, NK_PREFIX, NK_POSTFIX,
+	NK_TYPE, NK_IDENTIFIER_TYPE, NK_LIST_TYPE, NK_TUPLE_TYPE,
+	NK_TYPE_DECL,
+	NK_VAR_DECL,
+	NK_ARG_DECL,
+	NK_FUNC_CALL,
+	NK_RETURN,
+	NK_FUNC_DECL,
+	NK_LIST_ACCESS,
+	NK_LIST,
+	NK_CONDITION,
+	NK_WHILE,
+	NK_FOR,
+	NK_MATCH,
+	NK_ERROR
+};
+
+class FlatTree {
+	public:
+		FlatTree() = default;
+		virtual ~FlatTree() = default;
+
+		// Building
+		NodeIndex add(const NodeKind & kind,
+					  const uint32_t & offset,
+					  const uint32_t & lhs = NO_NODE,
+					  const uint32_t & rhs = NO_NODE,
+					  const uint8_t & flags = 0);
+
+		// Append words to `extra`, returns start of them
+		uint32_t add_extra(std::initializer_list <uint32_t> words);
+		uint32_t add_list(const std::vector <NodeIndex> & items);
+
+		void add_root(const NodeIndex & node){
+			roots.push_back(node);
+		}
+
+		void clear();
+
+		// Reading
+		uint32_t size() const {
+			return kinds.size();
+		}
+
+		NodeKind get_kind(const NodeIndex & node) const {
+			return kinds[node];
+		}
+		uint8_t get_flags(const NodeIndex & node) const {
+			return flags[node];
+		}
+		uint32_t get_offset(const NodeIndex & node) const {
+			return offsets[node];
+		}
+		uint32_t get_lhs(const NodeIndex & node) const {
+			return lhs[node];
+		}
+		uint32_t get_rhs(const NodeIndex & node) const {
+			return rhs[node];
+		}
+		uint32_t get_extra(const uint32_t & index) const {
+			return extra[index];
+		}
+
+		// Items of list stored at `start` of `extra`
+		std::span <const NodeIndex> get_list(const uint32_t & start) const {
+			return std::span <const NodeIndex>(extra.data() + start + 1, extra[start]);
+		}
+
+		std::span <const NodeIndex> get_roots() const {
+			return roots;
+		}
+
+		// Payloads
+		int64_t get_int(const NodeIndex & node) const;
+		double get_float(const NodeIndex & node) const;
+		bool get_bool(const NodeIndex & node) const {
+			return lhs[node] != 0;
+		}
+		Symbol get_symbol(const NodeIndex & node) const {
+			return lhs[node];
+		}
+		Operator get_op(const NodeIndex & node) const {
+			return static_cast<Operator>(flags[node]);
+		}
+
+		// Bytes used by arrays
+		size_t memory_size() const;
+
+		// Check that tree is well-formed (e.g. loaded from file): every child index is less than
+		// its parent index (so tree has no cycles), has kind expected in its place and lists are inside `extra`,
+		// tree is not deeper than MAX_TREE_DEPTH
+		bool validate() const;
+
+		// Build pointer tree of roots, nodes are allocated in arena
+		// Note: Tree must be valid (see `validate`)
+		std::vector <NStatement*> to_nodes(Arena & arena) const;
+
+		// Note: Output is the same as `to_string` of pointer nodes
+		std::string to_string(const NodeIndex & node) const;
+
+	private:
+		// Note: AstCache reads and writes arrays directly
+		friend class AstCache;
+
+		std::vector <NodeKind> kinds;
+		std::vector <uint8_t> flags;
+		std::vector <uint32_t> offsets;
+		std::vector <uint32_t> lhs;
+		std::vector <uint32_t> rhs;
+		std::vector <uint32_t> extra;
+		std::vector <NodeIndex> roots;
+
+		std::string list_to_string(const uint32_t & start, const std::string & sep) const;
+		std::string statements_to_string(const uint32_t & start) const;
+		std::string nullable_to_string(const NodeIndex & node) const;
+};
+
+#endif
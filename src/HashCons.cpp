@@ -0,0 +1,82 @@
+#include "HashCons.h"
+
+#include <algorithm>
+
+static const size_t HASH_CONS_MIN_SLOTS = 1024;
+
+HashCons::HashCons(){
+	count = 0;
+	reused = 0;
+}
+
+uint64_t HashCons::hash(const NodeKey & key){
+	const uint64_t prime = 0x9E3779B97F4A7C15ull;
+	auto mix = [&prime](uint64_t h, const uint64_t & word){
+		h = (h ^ word) * prime;
+		return h ^ (h >> 29);
+	};
+
+	uint64_t h = (static_cast<uint64_t>(key.kind) << 8 | key.flags) * prime;
+	h = mix(h, key.value);
+	h = mix(h, reinterpret_cast<uintptr_t>(key.left));
+	h = mix(h, reinterpret_cast<uintptr_t>(key.right));
+
+	return h;
+}
+
+Node *& HashCons::find(const NodeKey & key){
+	// Note: Table is kept at most half full, so probing sequences are short
+	if((count + 1) * 2 > slots.size()){
+		grow();
+	}
+
+	const size_t mask = slots.size() - 1;
+	size_t index = hash(key) & mask;
+	while(slots[index].key.kind != NK_NONE){
+		if(slots[index].key == key){
+			reused++;
+			return slots[index].node;
+		}
+		index = (index + 1) & mask;
+	}
+
+	slots[index].key = key;
+	slots[index].node = nullptr;
+	count++;
+	return slots[index].node;
+}
+
+Node *& HashCons::find(NodeListKey && key){
+	auto [it, inserted] = lists.try_emplace(std::move(key), nullptr);
+	if(!inserted){
+		reused++;
+	}
+	return it->second;
+}
+
+void HashCons::grow(){
+	std::vector <Slot> old_slots(std::max(slots.size() * 2, HASH_CONS_MIN_SLOTS), Slot{NodeKey{NK_NONE}, nullptr});
+	old_slots.swap(slots);
+
+	const size_t mask = slots.size() - 1;
+	for(const Slot & slot : old_slots){
+		if(slot.key.kind == NK_NONE){
+			continue;
+		}
+		size_t index = hash(slot.key) & mask;
+		while(slots[index].key.kind != NK_NONE){
+			index = (index + 1) & mask;
+		}
+		slots[index] = slot;
+	}
+}
+
+void HashCons::clear(){
+	// Note: Memory of table is kept for the next parsing
+	for(Slot & slot : slots){
+		slot.key.kind = NK_NONE;
+	}
+	count = 0;
+	reused = 0;
+	lists.clear();
+}
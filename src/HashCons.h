@@ -0,0 +1,80 @@
+#ifndef HASHCONS_H
+#define HASHCONS_H
+
+#include <vector>
+#include <map>
+#include <compare>
+#include <cstdint>
+
+#include "FlatTree.h"
+
+struct Node;
+
+// HashCons maps contents of immutable node to the single node with this contents,
+// so identical literals, types and pure expressions are allocated once and shared.
+// Contents of node is its kind, flags (operator or nullable) and payload or children.
+// Children must be shared nodes themselves, then equal pointers mean equal subtrees
+// and key of any subtree is compared in constant time.
+
+struct NodeKey {
+	NodeKind kind;
+	uint8_t flags = 0;
+	// Payload of literal or Symbol of identifier
+	uint64_t value = 0;
+	const Node * left = nullptr;
+	const Node * right = nullptr;
+
+	bool operator==(const NodeKey & other) const = default;
+};
+
+// Key of node with variable count of children (e.g. tuple type)
+struct NodeListKey {
+	NodeKind kind;
+	uint8_t flags = 0;
+	std::vector <const Node*> children;
+
+	auto operator<=>(const NodeListKey & other) const = default;
+};
+
+class HashCons {
+	public:
+		HashCons();
+		virtual ~HashCons() = default;
+
+		// Returns slot of node with `key`, it's nullptr if there's no such node yet
+		// Note: Reference is valid until the next `find()`
+		Node *& find(const NodeKey & key);
+
+		// Find node with variable count of children
+		Node *& find(NodeListKey && key);
+
+		void clear();
+
+		// Count of distinct shared nodes
+		size_t size() const {
+			return count + lists.size();
+		}
+
+		// Count of `find()` calls that returned existing node
+		size_t hits() const {
+			return reused;
+		}
+
+	private:
+		// Open addressing with linear probing, slot with `NK_NONE` kind is empty
+		struct Slot {
+			NodeKey key;
+			Node * node;
+		};
+		std::vector <Slot> slots;
+		size_t count;
+		size_t reused;
+
+		static uint64_t hash(const NodeKey & key);
+		void grow();
+
+		// Note: Nodes with children lists are rare, so they're kept in ordered map
+		std::map <NodeListKey, Node*> lists;
+};
+
+#endif
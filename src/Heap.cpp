@@ -0,0 +1,305 @@
+#include "Heap.h"
+#include "Object.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+
+Heap & heap(){
+	static Heap instance;
+	return instance;
+}
+
+Heap::Heap(){
+	cursor = nullptr;
+	end = nullptr;
+	hole_block = nullptr;
+	hole_scan = nullptr;
+	nursery_bytes = 0;
+	generational = true;
+	collection_requested = false;
+	major_threshold = MIN_MAJOR_SIZE;
+	major = false;
+}
+
+// Note: Cells are not destroyed at exit, destructors of runtime objects have no side effects
+Heap::~Heap(){
+	for(std::vector <Block*> * blocks : {&nursery, &old_blocks, &free_blocks}){
+		for(Block * block : *blocks){
+			delete[] block->begin;
+			delete block;
+		}
+	}
+}
+
+////////////
+// Blocks //
+////////////
+
+void Heap::next_range(){
+	close_range();
+	if(!next_hole()){
+		new_block();
+	}
+	nursery_bytes += end - cursor;
+
+	// Note: Without generational mode nursery grows with heap, so collection cost is amortized
+	if(nursery_bytes >= NURSERY_SIZE && (generational || nursery_bytes >= old_blocks.size() * BLOCK_SIZE)){
+		collection_requested = true;
+	}
+}
+
+bool Heap::next_hole(){
+	while(true){
+		if(hole_block != nullptr){
+			while(hole_scan < hole_block->end){
+				Header * header = reinterpret_cast<Header*>(hole_scan);
+				hole_scan += header->size;
+				if(!header->alive && header->size >= MIN_HOLE){
+					cursor = reinterpret_cast<char*>(header);
+					end = hole_scan;
+					return true;
+				}
+			}
+		}
+		if(recyclable.empty()){
+			hole_block = nullptr;
+			return false;
+		}
+		hole_block = recyclable.back();
+		recyclable.pop_back();
+		hole_block->recycled = true;
+		hole_scan = hole_block->begin;
+	}
+}
+
+void Heap::new_block(){
+	Block * block;
+	if(free_blocks.empty()){
+		block = new Block;
+		block->begin = new char[BLOCK_SIZE];
+		block->end = block->begin + BLOCK_SIZE;
+	}else{
+		block = free_blocks.back();
+		free_blocks.pop_back();
+	}
+	block->alive_count = 0;
+	block->hole_bytes = 0;
+	block->recycled = false;
+
+	nursery.push_back(block);
+	cursor = block->begin;
+	end = block->end;
+	update_heap_size();
+}
+
+void Heap::close_range(){
+	if(cursor < end){
+		Header * header = reinterpret_cast<Header*>(cursor);
+		header->size = end - cursor;
+		header->alive = false;
+	}
+	cursor = nullptr;
+	end = nullptr;
+}
+
+void Heap::release_block(Block * block){
+	if(free_blocks.size() * BLOCK_SIZE < NURSERY_SIZE){
+		free_blocks.push_back(block);
+	}else{
+		delete[] block->begin;
+		delete block;
+	}
+}
+
+void Heap::update_heap_size(){
+	stats.heap_bytes = (nursery.size() + old_blocks.size()) * BLOCK_SIZE;
+	stats.peak_heap_bytes = std::max(stats.peak_heap_bytes, stats.heap_bytes);
+}
+
+///////////
+// Roots //
+///////////
+
+void Heap::add_root(Cell * cell){
+	roots.push_back(cell);
+}
+
+void Heap::remove_root(Cell * cell){
+	roots.erase(std::find(roots.begin(), roots.end(), cell));
+}
+
+void Heap::add_roots(RootProvider * provider){
+	providers.push_back(provider);
+}
+
+void Heap::remove_roots(RootProvider * provider){
+	providers.erase(std::find(providers.begin(), providers.end(), provider));
+}
+
+void Heap::mark(const Value & value){
+	if(value.is_object()){
+		mark(value.as_object());
+	}
+}
+
+void Heap::mark_roots(){
+	for(Cell * cell : roots){
+		mark(cell);
+	}
+	for(RootProvider * provider : providers){
+		provider->trace_roots(*this);
+	}
+	for(const StackRoot & root : stack_roots){
+		switch(root.kind){
+			case RK_VALUE:{
+				mark(*static_cast<const Value*>(root.ptr));
+				break;
+			}
+			case RK_VALUES:{
+				const std::vector <Value> & values = *static_cast<const std::vector <Value>*>(root.ptr);
+				mark(values.data(), values.data() + values.size());
+				break;
+			}
+			case RK_CELL:{
+				mark(const_cast<Cell*>(static_cast<const Cell*>(root.ptr)));
+				break;
+			}
+		}
+	}
+	// Note: Remembered cells are old, on minor collection they're roots of their young values
+	if(!major){
+		for(Cell * cell : remembered){
+			cell->trace(*this);
+		}
+	}
+}
+
+void Heap::trace_gray(){
+	while(!gray.empty()){
+		Cell * cell = gray.back();
+		gray.pop_back();
+		cell->trace(*this);
+	}
+}
+
+////////////////
+// Collection //
+////////////////
+
+void Heap::destroy(Header * header, Cell * cell){
+	stats.freed_bytes += header->size;
+	cell->~Cell();
+	header->alive = false;
+}
+
+void Heap::sweep_block(Block * block){
+	block->alive_count = 0;
+	block->hole_bytes = 0;
+	// Dead cells after the last alive one, they're merged into the first of them
+	Header * hole = nullptr;
+	auto end_hole = [&](){
+		if(hole != nullptr && hole->size >= MIN_HOLE){
+			block->hole_bytes += hole->size;
+		}
+		hole = nullptr;
+	};
+	for(char * ptr = block->begin; ptr < block->end;){
+		Header * header = reinterpret_cast<Header*>(ptr);
+		ptr += header->size;
+		if(header->alive){
+			// Note: Cells have single base, so Cell is at the start of object
+			Cell * cell = reinterpret_cast<Cell*>(header + 1);
+			if(cell->marked){
+				cell->marked = false;
+				if(cell->generation == CG_YOUNG && generational){
+					cell->generation = CG_OLD;
+					stats.promoted_bytes += header->size;
+				}
+				stats.live_bytes += header->size;
+			}else if(major || cell->generation == CG_YOUNG){
+				destroy(header, cell);
+			}
+			if(header->alive){
+				block->alive_count++;
+				end_hole();
+				continue;
+			}
+		}
+		if(hole == nullptr){
+			hole = header;
+		}else{
+			hole->size += header->size;
+		}
+	}
+	end_hole();
+}
+
+void Heap::collect(){
+	const auto start = std::chrono::steady_clock::now();
+	const size_t heap_bytes = stats.heap_bytes;
+
+	collection_requested = false;
+	major = !generational || old_blocks.size() * BLOCK_SIZE >= major_threshold;
+	close_range();
+	hole_block = nullptr;
+	hole_scan = nullptr;
+	nursery_bytes = 0;
+
+	mark_roots();
+	trace_gray();
+
+	for(Cell * cell : remembered){
+		cell->remembered = false;
+	}
+	remembered.clear();
+
+	// Note: Minor collection sweeps only old blocks with young cells
+	if(major){
+		stats.live_bytes = 0;
+	}
+	std::vector <Block*> alive_blocks;
+	recyclable.clear();
+	for(std::vector <Block*> * blocks : {&old_blocks, &nursery}){
+		for(Block * block : *blocks){
+			if(major || blocks == &nursery || block->recycled){
+				sweep_block(block);
+				block->recycled = false;
+			}
+			if(block->alive_count){
+				alive_blocks.push_back(block);
+				if(block->hole_bytes){
+					recyclable.push_back(block);
+				}
+			}else{
+				release_block(block);
+			}
+		}
+	}
+	old_blocks = std::move(alive_blocks);
+	nursery.clear();
+
+	if(major){
+		stats.major_collections++;
+		major_threshold = std::max(MIN_MAJOR_SIZE, old_blocks.size() * BLOCK_SIZE * 2);
+	}else{
+		stats.minor_collections++;
+	}
+	update_heap_size();
+
+	const std::chrono::duration <double, std::milli> pause = std::chrono::steady_clock::now() - start;
+	stats.total_pause_ms += pause.count();
+	stats.max_pause_ms = std::max(stats.max_pause_ms, pause.count());
+
+	TRACE(TL_INFO, TC_GC, major ? "Major" : "Minor", " collection: ", heap_bytes / 1024, "KB -> ",
+		  stats.heap_bytes / 1024, "KB, live ", stats.live_bytes / 1024, "KB in ", pause.count(), "ms");
+}
+
+std::string HeapStats::to_string() const {
+	return "Collections: " + std::to_string(minor_collections) + " minor, " + std::to_string(major_collections) + " major\n"
+		 + "Pause: " + std::to_string(total_pause_ms) + "ms total, " + std::to_string(max_pause_ms) + "ms max\n"
+		 + "Allocated: " + std::to_string(allocated_bytes / 1024) + "KB, promoted: " + std::to_string(promoted_bytes / 1024)
+		 + "KB, freed: " + std::to_string(freed_bytes / 1024) + "KB\n"
+		 + "Heap: " + std::to_string(heap_bytes / 1024) + "KB, peak: " + std::to_string(peak_heap_bytes / 1024)
+		 + "KB, live: " + std::to_string(live_bytes / 1024) + "KB";
+}
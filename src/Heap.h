@@ -0,0 +1,285 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <vector>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+#include "Value.h"
+
+/**
+ * Heap is precise tracing garbage collector of runtime cells (objects and scopes of tree walker).
+ *
+ * Cells are bump-allocated in holes of old blocks and in new blocks of nursery. When nursery size
+ * is allocated since the last collection, collection is requested and done at the next safepoint
+ * (between statements of tree walker, on loops and calls of VM), so native code (operators, builtins)
+ * never sees collection and doesn't need to root its values.
+ *
+ * Minor collection marks young cells reachable from roots and from remembered old cells,
+ * survivors are promoted to old generation in place (cells are never moved).
+ * Block without survivors goes back to nursery, block with survivors becomes old block
+ * and is freed when all of its cells are dead.
+ * Sweep merges adjacent dead cells of block into holes, so space of dead cells is reused
+ * (block with one survivor doesn't keep the rest of it), young cells allocated in holes
+ * are swept by the next minor collection together with nursery.
+ * Major collection marks and sweeps all cells, it's done when old blocks grow twice since
+ * the last major collection, or on each collection if generational mode is off.
+ *
+ * Roots are cells added by `add_root`, RootProviders (VM stack and globals)
+ * and values of C++ stack registered by Root guard.
+ * Note: Cells created by plain `new` are permanent, they're never collected and must not
+ * reference collectable cells (e.g. cached strings and builtins)
+ */
+
+class Heap;
+
+enum CellGeneration : uint8_t {
+	CG_YOUNG,
+	CG_OLD,
+	CG_PERMANENT
+};
+
+class Cell {
+	public:
+		Cell() = default;
+		virtual ~Cell() = default;
+
+		Cell(const Cell &) = delete;
+		Cell & operator=(const Cell &) = delete;
+
+		// Mark cells referenced by this one
+		virtual void trace(Heap &) {}
+
+	private:
+		friend class Heap;
+
+		CellGeneration generation = CG_PERMANENT;
+		bool marked = false;
+		bool remembered = false;
+};
+
+// Owner of values outside of heap (e.g. VM stack), it's traced on each collection
+class RootProvider {
+	public:
+		virtual ~RootProvider() = default;
+
+		virtual void trace_roots(Heap & heap) = 0;
+};
+
+struct HeapStats {
+	uint64_t minor_collections = 0;
+	uint64_t major_collections = 0;
+	double total_pause_ms = 0;
+	double max_pause_ms = 0;
+
+	// Bytes of cells allocated, promoted to old generation and freed since start
+	uint64_t allocated_bytes = 0;
+	uint64_t promoted_bytes = 0;
+	uint64_t freed_bytes = 0;
+
+	// Bytes of blocks in use (nursery and old blocks)
+	size_t heap_bytes = 0;
+	size_t peak_heap_bytes = 0;
+	// Bytes of cells alive after the last major collection and promoted since it
+	size_t live_bytes = 0;
+
+	std::string to_string() const;
+};
+
+class Heap {
+	public:
+		Heap();
+		virtual ~Heap();
+
+		Heap(const Heap &) = delete;
+		Heap & operator=(const Heap &) = delete;
+
+		template <class T, class ...Args>
+		T * make(Args && ...args){
+			static_assert(std::is_base_of_v<Cell, T>, "Heap allocates only cells");
+			static_assert(alignof(T) <= CELL_ALIGN, "Cell is over-aligned");
+			static_assert(sizeof(Header) + align(sizeof(T)) <= MIN_HOLE, "Cell doesn't fit into hole");
+			Header * header = allocate(sizeof(Header) + align(sizeof(T)));
+			T * cell = new (header + 1) T(std::forward<Args>(args)...);
+			// Note: Header is alive only after constructor, so cell that failed to construct is skipped by sweep
+			header->alive = true;
+			cell->generation = CG_YOUNG;
+			return cell;
+		}
+
+		// Note: Without generational mode each collection is major
+		void set_generational(const bool & generational){
+			this->generational = generational;
+		}
+
+		// Collect if it's requested, called where all live values are reachable from roots
+		void safepoint(){
+			if(collection_requested){
+				collect();
+			}
+		}
+		bool is_collection_requested() const {
+			return collection_requested;
+		}
+		void collect();
+
+		// Must be called after value of old cell is changed, so young value is marked by minor collection
+		void write_barrier(Cell * cell){
+			if(cell->generation == CG_OLD && !cell->remembered){
+				cell->remembered = true;
+				remembered.push_back(cell);
+			}
+		}
+
+		void add_root(Cell * cell);
+		void remove_root(Cell * cell);
+		void add_roots(RootProvider * provider);
+		void remove_roots(RootProvider * provider);
+
+		// Marking, used by `Cell::trace` and `RootProvider::trace_roots`
+		void mark(Cell * cell){
+			if(cell->generation == CG_YOUNG || (cell->generation == CG_OLD && major)){
+				if(!cell->marked){
+					cell->marked = true;
+					gray.push_back(cell);
+				}
+			}
+		}
+		void mark(const Value & value);
+		void mark(const Value * begin, const Value * end){
+			for(const Value * value = begin; value < end; value++){
+				mark(*value);
+			}
+		}
+
+		const HeapStats & get_stats() const {
+			return stats;
+		}
+
+	private:
+		friend class Root;
+
+		static constexpr size_t BLOCK_SIZE = 32 * 1024;
+		static constexpr size_t NURSERY_SIZE = 1024 * 1024;
+		static constexpr size_t MIN_MAJOR_SIZE = 4 * 1024 * 1024;
+		static constexpr size_t CELL_ALIGN = 8;
+		// Smaller holes are not used for allocation
+		static constexpr size_t MIN_HOLE = 256;
+
+		// Note: Dead header is free space (dead cell, merged dead cells or unused end of range),
+		// so headers cover the whole block
+		struct Header {
+			uint32_t size;
+			uint32_t alive;
+		};
+
+		struct Block {
+			char * begin;
+			char * end;
+			uint32_t alive_count;
+			// Bytes of holes found by the last sweep
+			uint32_t hole_bytes;
+			// Old block has young cells allocated in its holes since the last collection
+			bool recycled;
+		};
+
+		static constexpr size_t align(const size_t & size){
+			return (size + CELL_ALIGN - 1) & ~(CELL_ALIGN - 1);
+		}
+
+		// New blocks filled since the last collection
+		std::vector <Block*> nursery;
+		std::vector <Block*> old_blocks;
+		// Old blocks with holes not used for allocation since the last collection
+		std::vector <Block*> recyclable;
+		// Note: Free blocks are kept for nursery up to its size, others are returned to system
+		std::vector <Block*> free_blocks;
+		// Allocation range (hole or new block), holes of `hole_block` after `hole_scan` are the next ranges
+		char * cursor;
+		char * end;
+		Block * hole_block;
+		char * hole_scan;
+		// Bytes of ranges taken since the last collection
+		size_t nursery_bytes;
+
+		Header * allocate(const size_t & size){
+			stats.allocated_bytes += size;
+			if(static_cast<size_t>(end - cursor) < size){
+				next_range();
+			}
+			Header * header = reinterpret_cast<Header*>(cursor);
+			header->size = size;
+			header->alive = false;
+			cursor += size;
+			return header;
+		}
+		void next_range();
+		bool next_hole();
+		void new_block();
+		// Unused end of range becomes free space
+		void close_range();
+		void release_block(Block * block);
+		void update_heap_size();
+
+		bool generational;
+		bool collection_requested;
+		// Old blocks size that triggers major collection
+		size_t major_threshold;
+
+		// Collection
+		bool major;
+		std::vector <Cell*> gray;
+		std::vector <Cell*> remembered;
+		void mark_roots();
+		void trace_gray();
+		// Sweep cells of block and merge dead cells into holes, survivors of nursery are promoted,
+		// old cells are kept by minor collection
+		void sweep_block(Block * block);
+		void destroy(Header * header, Cell * cell);
+
+		// Roots
+		std::vector <Cell*> roots;
+		std::vector <RootProvider*> providers;
+
+		enum RootKind : uint8_t {
+			RK_VALUE,
+			RK_VALUES,
+			RK_CELL
+		};
+		struct StackRoot {
+			RootKind kind;
+			const void * ptr;
+		};
+		std::vector <StackRoot> stack_roots;
+
+		HeapStats stats;
+};
+
+Heap & heap();
+
+// Root keeps value (or values, or cell) of C++ stack alive while it's in scope,
+// it's needed for values that are used after evaluation that can reach a safepoint
+// Note: Roots must be destroyed in reverse order, so they're only local variables
+class Root {
+	public:
+		Root(const Value & value){
+			heap().stack_roots.push_back(Heap::StackRoot{Heap::RK_VALUE, &value});
+		}
+		Root(const std::vector <Value> & values){
+			heap().stack_roots.push_back(Heap::StackRoot{Heap::RK_VALUES, &values});
+		}
+		Root(Cell * cell){
+			heap().stack_roots.push_back(Heap::StackRoot{Heap::RK_CELL, cell});
+		}
+		~Root(){
+			heap().stack_roots.pop_back();
+		}
+
+		Root(const Root &) = delete;
+		Root & operator=(const Root &) = delete;
+};
+
+#endif
@@ -0,0 +1,740 @@
+#include "IncrementalParser.h"
+#include "StatementSplit.h"
+
+#include <algorithm>
+#include <span>
+
+typedef IncrementalParser::Segment Segment;
+typedef IncrementalParser::Block Block;
+
+IncrementalParser::IncrementalParser(const uint32_t & nested_tokens){
+	this->nested_tokens = nested_tokens;
+	last_relexed = 0;
+	last_reparsed = 0;
+	last_spliced = 0;
+	parsed_tokens = 0;
+	total_tokens = 0;
+}
+
+uint32_t IncrementalParser::lex(const uint32_t & begin, const uint32_t & end, std::vector <Token> & tokens){
+	uint32_t pos = begin;
+	while(true){
+		const size_t first = tokens.size();
+		bool failed = false;
+		try{
+			pos = lexer.lex_range(code, pos, end, tokens, &lines);
+		}catch(const Exception & e){
+			// Note: Rest of the line with lexing error is skipped, so edit can't break lexing of the whole file
+			lex_errors.push_back({lexer.get_index(), e.what()});
+			const size_t endl = code.find('\n', lexer.get_index());
+			pos = endl == std::string::npos ? code.size() : endl;
+			failed = true;
+		}
+
+		// Note: Lexer starts without previous token, so it doesn't know that `T_ENDL` was already added
+		if(first > 0 && tokens.size() > first && tokens[first - 1].type == T_ENDL && tokens[first].type == T_ENDL){
+			tokens.erase(tokens.begin() + first);
+		}
+
+		if(!failed || pos >= end){
+			return pos;
+		}
+	}
+}
+
+void IncrementalParser::parse_segment(Segment & segment){
+	segment.parsed_begin = segment.begin;
+	segment.statements.clear();
+	segment.blocks.clear();
+	segment.error.clear();
+
+	TokenVector source(segment.tokens, code, segment.begin);
+	try{
+		segment.statements = parser.parse_more(source, &lines);
+	}catch(const Exception & e){
+		segment.error = e.what();
+		segment.error_offset = parser.get_diagnostics().back().offset;
+	}
+
+	parsed_tokens += segment.tokens.size();
+	last_reparsed++;
+}
+
+void IncrementalParser::update_error(Segment & segment){
+	const size_t at = segment.error.rfind(" at ");
+	if(at == std::string::npos){
+		return;
+	}
+	const Position pos = lines.position(segment.error_offset + segment.shift());
+	segment.error.replace(at, std::string::npos, " at " + std::to_string(pos.line) + ":" + std::to_string(pos.column));
+}
+
+static bool is_open_bracket(const Token & token){
+	return token.type == T_OP && (token.op() == OP_PAREN_L || token.op() == OP_BRACKET_L || token.op() == OP_BRACE_L);
+}
+
+static bool is_close_bracket(const Token & token){
+	return token.type == T_OP && (token.op() == OP_PAREN_R || token.op() == OP_BRACKET_R || token.op() == OP_BRACE_R);
+}
+
+// Split inside of braces into statements as Parser does in block
+static bool split_block(std::span <const Token> tokens, std::vector <uint32_t> & ends){
+	if(!split_statements(tokens, nullptr, ends)){
+		return false;
+	}
+	// Note: Empty lines of block without statements are split as one statement
+	if(std::all_of(tokens.begin(), tokens.end(), [](const Token & token){ return token.type == T_ENDL; })){
+		ends.clear();
+	}
+	return true;
+}
+
+// Split absolute tokens into segments without statements, `begin` of segments is relative to `base`
+static void split_segments(const std::vector <Token> & tokens,
+						   const std::vector <uint32_t> & ends,
+						   const uint32_t & base,
+						   std::vector <Segment> & result)
+{
+	uint32_t start = 0;
+	for(const uint32_t & end : ends){
+		Segment segment;
+		segment.begin = tokens[start].offset - base;
+		segment.parsed_begin = tokens[start].offset;
+		segment.error_offset = 0;
+		segment.tokens.assign(tokens.begin() + start, tokens.begin() + end);
+		for(Token & token : segment.tokens){
+			token.offset -= tokens[start].offset;
+		}
+		result.push_back(std::move(segment));
+		start = end;
+	}
+}
+
+static uint32_t count_tokens(const Segment & segment){
+	uint32_t count = segment.tokens.size();
+	for(const Block & block : segment.blocks){
+		for(const Segment & nested : block.segments){
+			count += count_tokens(nested);
+		}
+	}
+	return count;
+}
+
+void IncrementalParser::get_tokens(const Segment & segment, const uint32_t & begin, std::vector <Token> & tokens){
+	uint32_t next = 0;
+	auto append = [&](const uint32_t & end){
+		for(; next < end; next++){
+			tokens.push_back(segment.tokens[next]);
+			tokens.back().offset += begin;
+		}
+	};
+	for(const Block & block : segment.blocks){
+		append(block.open + 1);
+		const uint32_t open = begin + segment.tokens[block.open].offset;
+		for(const Segment & nested : block.segments){
+			get_tokens(nested, open + nested.begin, tokens);
+		}
+	}
+	append(segment.tokens.size());
+}
+
+void IncrementalParser::nest(Segment & segment){
+	std::vector <Token> & tokens = segment.tokens;
+	const uint32_t begin = segment.parsed_begin;
+
+	// Braces with enough tokens inside
+	struct Braces {
+		uint32_t open;
+		uint32_t close;
+		NBlock * node;
+		std::vector <uint32_t> ends;
+	};
+	std::vector <Braces> braces;
+	std::vector <uint32_t> opened;
+	for(uint32_t i = 0; i < tokens.size(); i++){
+		if(is_open_bracket(tokens[i])){
+			opened.push_back(i);
+		}else if(is_close_bracket(tokens[i]) && !opened.empty()){
+			const uint32_t open = opened.back();
+			opened.pop_back();
+			if(tokens[open].op() == OP_BRACE_L && tokens[i].op() == OP_BRACE_R && i - open - 1 >= nested_tokens){
+				braces.push_back(Braces{open, i, nullptr, {}});
+			}
+		}
+	}
+	if(braces.empty()){
+		return;
+	}
+	std::sort(braces.begin(), braces.end(), [](const Braces & a, const Braces & b){
+		return a.open < b.open;
+	});
+
+	// Note: Offset of block is offset of `{` or `T_ENDL` before it
+	std::vector <std::pair<uint32_t, size_t>> offsets;
+	for(size_t i = 0; i < braces.size(); i++){
+		const uint32_t open = braces[i].open;
+		offsets.push_back({begin + tokens[open].offset, i});
+		if(open > 0 && tokens[open - 1].type == T_ENDL){
+			offsets.push_back({begin + tokens[open - 1].offset, i});
+		}
+	}
+	std::sort(offsets.begin(), offsets.end());
+
+	// Nodes inside of nested block are not walked, so each node is walked once for all levels of blocks
+	std::vector <Node*> stack(segment.statements.begin(), segment.statements.end());
+	while(!stack.empty()){
+		Node * node = stack.back();
+		stack.pop_back();
+		if(!node){
+			continue;
+		}
+		bool nested = false;
+		auto it = std::lower_bound(offsets.begin(), offsets.end(), std::pair<uint32_t, size_t>(node->offset, 0));
+		for(; it != offsets.end() && it->first == node->offset && !nested; ++it){
+			Braces & found = braces[it->second];
+			NBlock * block = dynamic_cast<NBlock*>(node);
+			if(!block || found.node){
+				continue;
+			}
+			// Other statements of block must be split the same way when some of them are parsed again
+			std::span <const Token> inside = std::span(tokens).subspan(found.open + 1, found.close - found.open - 1);
+			if(split_block(inside, found.ends) && !found.ends.empty() && found.ends.size() == block->statements.size()){
+				found.node = block;
+				nested = true;
+			}else{
+				found.ends.clear();
+			}
+		}
+		if(!nested){
+			node->get_children(stack);
+		}
+	}
+
+	std::vector <Token> own;
+	uint32_t next = 0;
+	for(Braces & found : braces){
+		if(!found.node || found.open < next){
+			continue;
+		}
+		own.insert(own.end(), tokens.begin() + next, tokens.begin() + found.open + 1);
+		Block block;
+		block.node = found.node;
+		block.open = own.size() - 1;
+
+		std::vector <Token> inside(tokens.begin() + found.open + 1, tokens.begin() + found.close);
+		for(Token & token : inside){
+			token.offset += begin;
+		}
+		split_segments(inside, found.ends, begin + tokens[found.open].offset, block.segments);
+		for(size_t i = 0; i < block.segments.size(); i++){
+			block.segments[i].statements.push_back(found.node->statements[i]);
+			nest(block.segments[i]);
+		}
+		segment.blocks.push_back(std::move(block));
+		next = found.close;
+	}
+	own.insert(own.end(), tokens.begin() + next, tokens.end());
+	tokens = std::move(own);
+}
+
+void IncrementalParser::make_segments(const std::vector <Token> & tokens,
+									  const std::vector <uint32_t> & ends,
+									  std::vector <Segment> & result)
+{
+	split_segments(tokens, ends, 0, result);
+
+	// Segments with lexing errors are not parsed, they keep lexing error
+	for(const auto & [offset, msg] : lex_errors){
+		auto it = std::upper_bound(result.begin(), result.end(), offset, [](const uint32_t & off, const Segment & segment){
+			return off < segment.begin;
+		});
+		if(it != result.begin()){
+			--it;
+		}else if(it == result.end()){
+			// Note: Line with error has no tokens, segment without tokens keeps the error
+			Segment segment;
+			segment.begin = offset;
+			segment.parsed_begin = offset;
+			result.push_back(std::move(segment));
+			it = result.end() - 1;
+		}
+		it->error = msg;
+		it->error_offset = offset;
+	}
+	lex_errors.clear();
+
+	for(Segment & segment : result){
+		if(!segment.error.empty()){
+			continue;
+		}
+		parse_segment(segment);
+		if(segment.error.empty()){
+			nest(segment);
+		}
+	}
+}
+
+// Rest of line with lexing error is lost with its brackets, so that line always ends statement,
+// otherwise one broken line would make the rest of code one statement
+static void split_after_errors(StatementSplitter & splitter,
+							   const std::vector <std::pair<uint32_t, std::string>> & errors,
+							   size_t & next_error,
+							   const Token & token)
+{
+	if(token.type == T_ENDL){
+		return;
+	}
+	while(next_error < errors.size() && errors[next_error].first < token.offset){
+		splitter.reset();
+		next_error++;
+	}
+}
+
+void IncrementalParser::parse(std::string_view code){
+	// Note: Copy of large file on the first insert would take more than the rest of edit
+	this->code.reserve(code.size() + code.size() / 8 + 4096);
+	this->code = code;
+	lines.build(this->code);
+	parse_all();
+}
+
+void IncrementalParser::parse_all(){
+	std::vector <Token> tokens;
+	lex(0, code.size(), tokens);
+
+	std::vector <uint32_t> ends;
+	StatementSplitter splitter(ends);
+	size_t next_error = 0;
+	for(const Token & token : tokens){
+		split_after_errors(splitter, lex_errors, next_error, token);
+		splitter.push(token);
+	}
+	if(!splitter.finish(nullptr)){
+		// Note: Unclosed statement at the end, parser will report it
+		ends.push_back(tokens.size());
+	}
+
+	segments.clear();
+	parser.clear();
+	parsed_tokens = 0;
+	last_reparsed = 0;
+	make_segments(tokens, ends, segments);
+
+	total_tokens = tokens.size();
+	last_relexed = tokens.size();
+	last_spliced = 0;
+}
+
+static bool same_token(const Token & a, const Token & b){
+	return a.type == b.type && a.offset == b.offset && a.length == b.length && a.val == b.val;
+}
+
+bool IncrementalParser::relex(const std::vector <Segment> & segments,
+							  const uint32_t & base,
+							  const Token * close,
+							  const EditRange & edit,
+							  Relexed & relexed)
+{
+	const int64_t & delta = edit.delta;
+	const uint32_t edit_end = edit.offset + edit.removed + delta;
+
+	// Start from segment before the edited one, edit can join them (e.g. `T_ENDL` removed)
+	auto after = std::upper_bound(segments.begin(), segments.end(), edit.offset, [&base](const uint32_t & off, const Segment & segment){
+		return off < base + segment.begin;
+	});
+	size_t first = after - segments.begin();
+	first = first > 1 ? first - 2 : 0;
+	// Note: Segment of `T_ENDL` only is left by lexing error before it (see `split_after_errors`),
+	// so that error is lexed again to split it the same way
+	while(first > 0 && std::all_of(segments[first].tokens.begin(), segments[first].tokens.end(), [](const Token & token){
+		return token.type == T_ENDL;
+	})){
+		first--;
+	}
+
+	// Note: Code before the first segment has no tokens, so it is lexed from the start of code or block
+	const uint32_t lex_begin = first > 0 ? base + segments[first].begin : close ? base + 1 : 0;
+	// Note: `}` of block is lexed too, so it's known that tokens don't cross it
+	const uint32_t limit = close ? close->offset + 1 : code.size();
+	std::vector <Token> & tokens = relexed.tokens;
+	uint32_t pos = lex_begin;
+	uint32_t lex_end = std::min <uint32_t>(limit, edit_end + 256);
+	size_t sync = SIZE_MAX;
+	size_t candidate = first + 1;
+	size_t checked = 0;
+
+	// Note: Statements are split while tokens are checked, so each token is processed once
+	StatementSplitter splitter(relexed.ends);
+	size_t next_error = 0;
+
+	// Old segment containing the last checked token, when relexed token is the same as old one,
+	// the rest of tokens is copied from old segments (`copied` is the last copied one)
+	size_t cursor = first;
+	size_t copied = SIZE_MAX;
+
+	auto is_sync_token = [&](const Token & token){
+		if(token.offset < edit_end){
+			return false;
+		}
+		while(candidate < segments.size() && base + segments[candidate].begin + delta < token.offset){
+			candidate++;
+		}
+		if(candidate == segments.size() || segments[candidate].tokens.empty()){
+			return false;
+		}
+		const Segment & segment = segments[candidate];
+		Token old = segment.tokens[0];
+		old.offset += base + segment.begin + delta;
+		// Relexed tokens must be whole statements
+		// Note: Lexing error before `T_ENDL` ends statement only at the next token, so it's not applied yet
+		const bool error_pending = next_error < lex_errors.size() && lex_errors[next_error].first < token.offset;
+		return same_token(token, old) && !error_pending && splitter.is_complete(&token);
+	};
+
+	// Lexer keeps only the type of previous token, so after the same token with the same previous one
+	// it gives the same tokens as before the edit (see `ParallelLexer::stitch`)
+	auto is_old_token = [&](const Token & token){
+		if(copied != SIZE_MAX || token.offset < edit_end || checked == 0){
+			return false;
+		}
+		const uint32_t old_offset = token.offset - delta;
+		while(cursor + 1 < segments.size() && base + segments[cursor + 1].begin <= old_offset){
+			cursor++;
+		}
+		const Segment & segment = segments[cursor];
+		// Note: Old lexing errors are not kept, so segment with error is always lexed again
+		if(!segment.error.empty() || old_offset < base + segment.begin){
+			return false;
+		}
+		const uint32_t relative = old_offset - base - segment.begin;
+		auto it = std::lower_bound(segment.tokens.begin(), segment.tokens.end(), relative, [](const Token & token, const uint32_t & offset){
+			return token.offset < offset;
+		});
+		if(it == segment.tokens.end() || it->offset != relative || it->type != token.type || it->length != token.length || it->val != token.val){
+			return false;
+		}
+		const size_t index = it - segment.tokens.begin();
+		bool after_endl = false;
+		if(index > 0){
+			// Note: Token before `}` of nested block is inside of it
+			if(std::any_of(segment.blocks.begin(), segment.blocks.end(), [&index](const Block & block){ return block.open + 1 == index; })){
+				return false;
+			}
+			after_endl = segment.tokens[index - 1].type == T_ENDL;
+		}else if(cursor > 0 && !segments[cursor - 1].tokens.empty()){
+			after_endl = segments[cursor - 1].tokens.back().type == T_ENDL;
+		}
+		if(after_endl != (tokens[checked - 1].type == T_ENDL)){
+			return false;
+		}
+
+		// Replace relexed tokens from this one with old ones
+		tokens.resize(checked);
+		std::vector <Token> old;
+		get_tokens(segment, base + segment.begin, old);
+		auto from = std::lower_bound(old.begin(), old.end(), old_offset, [](const Token & token, const uint32_t & offset){
+			return token.offset < offset;
+		});
+		for(; from != old.end(); ++from){
+			tokens.push_back(*from);
+			tokens.back().offset += delta;
+		}
+		copied = cursor;
+		return true;
+	};
+
+	// Note: Lexer starts without previous token, so `T_ENDL` after `T_ENDL` of previous segment is removed
+	bool after_endl = false;
+	for(size_t i = first; i-- > 0;){
+		if(!segments[i].tokens.empty()){
+			after_endl = segments[i].tokens.back().type == T_ENDL;
+			break;
+		}
+	}
+
+	while(sync == SIZE_MAX){
+		if(copied == SIZE_MAX){
+			pos = lex(pos, lex_end, tokens);
+			if(after_endl && !tokens.empty()){
+				if(tokens[0].type == T_ENDL){
+					tokens.erase(tokens.begin());
+				}
+				after_endl = false;
+			}
+			// Note: Lexing error inside of block can't be kept by its segments, so it's lexed in the enclosing one
+			if(close && !lex_errors.empty()){
+				return false;
+			}
+		}
+
+		while(checked < tokens.size()){
+			const Token & token = tokens[checked];
+			if(close && token.offset + token.length > close->offset){
+				// Note: Ends of statements are found as for the whole block in `nest()`
+				if(!same_token(token, *close) || !splitter.finish(nullptr)){
+					return false;
+				}
+				sync = segments.size();
+				break;
+			}
+			split_after_errors(splitter, lex_errors, next_error, token);
+			if(is_sync_token(token)){
+				sync = candidate;
+				break;
+			}
+			if(is_old_token(token)){
+				continue;
+			}
+			splitter.push(token);
+			checked++;
+		}
+		if(sync != SIZE_MAX){
+			break;
+		}
+
+		if(copied == SIZE_MAX){
+			if(pos >= limit){
+				if(close){
+					return false;
+				}
+				break;
+			}
+			// Note: Lex twice more each time, edit can change much (e.g. opened comment)
+			lex_end = std::min <uint64_t>(limit, pos + static_cast<uint64_t>(pos - lex_begin) + 256);
+		}else if(++copied == segments.size()){
+			if(!close){
+				break;
+			}
+			tokens.push_back(*close);
+		}else if(!segments[copied].error.empty()){
+			pos = base + segments[copied].begin + delta;
+			lex_end = std::min <uint32_t>(limit, pos + 256);
+			copied = SIZE_MAX;
+		}else{
+			get_tokens(segments[copied], base + segments[copied].begin + delta, tokens);
+		}
+	}
+
+	if(sync == SIZE_MAX){
+		if(!splitter.finish(nullptr)){
+			// Note: Unclosed statement at the end, parser will report it
+			relexed.ends.push_back(tokens.size());
+		}
+		sync = segments.size();
+	}else if(sync < segments.size()){
+		splitter.finish(&tokens[checked]);
+	}
+	tokens.resize(checked);
+
+	relexed.first = first;
+	relexed.sync = sync;
+	return true;
+}
+
+// Move offsets of nodes of segment after `from` by `delta`, nodes of nested blocks are not moved
+// Note: IncrementalParser doesn't use hash-consing, so each node is visited once
+static void move_offsets(const Segment & segment, const uint32_t & from, const int64_t & delta){
+	std::vector <Node*> stack(segment.statements.begin(), segment.statements.end());
+	while(!stack.empty()){
+		Node * node = stack.back();
+		stack.pop_back();
+		if(!node){
+			continue;
+		}
+		if(node->offset > from){
+			node->offset += delta;
+		}
+		if(std::none_of(segment.blocks.begin(), segment.blocks.end(), [&node](const Block & block){ return block.node == node; })){
+			node->get_children(stack);
+		}
+	}
+}
+
+bool IncrementalParser::edit_block(Segment & segment, const uint32_t & begin, Block & block, const EditRange & edit){
+	Token open = segment.tokens[block.open];
+	open.offset += begin;
+	Token close = segment.tokens[block.open + 1];
+	close.offset += begin + edit.delta;
+
+	Relexed relexed;
+	if(!relex(block.segments, open.offset, &close, edit, relexed)){
+		lex_errors.clear();
+		return false;
+	}
+	const size_t first = relexed.first;
+	const size_t sync = relexed.sync;
+	// Note: Block keeps at least one segment, so the edit is always inside of some of them
+	if(relexed.ends.empty() && first == 0 && sync == block.segments.size()){
+		return false;
+	}
+
+	// Parse new statements in braces, so they're parsed as in block
+	std::vector <Token> tokens;
+	tokens.reserve(relexed.tokens.size() + 2);
+	tokens.push_back(open);
+	tokens.insert(tokens.end(), relexed.tokens.begin(), relexed.tokens.end());
+	tokens.push_back(close);
+	TokenVector source(tokens, code);
+	NBlock * parsed;
+	try{
+		parsed = parser.parse_more_block(source, &lines);
+	}catch(const Exception & e){
+		return false;
+	}
+	parsed_tokens += tokens.size();
+	if(!parsed || parsed->statements.size() != relexed.ends.size()){
+		return false;
+	}
+
+	std::vector <Segment> new_segments;
+	split_segments(relexed.tokens, relexed.ends, open.offset, new_segments);
+	for(size_t i = 0; i < new_segments.size(); i++){
+		new_segments[i].statements.push_back(parsed->statements[i]);
+		nest(new_segments[i]);
+	}
+
+	for(size_t i = first; i < sync; i++){
+		total_tokens -= count_tokens(block.segments[i]);
+	}
+	total_tokens += relexed.tokens.size();
+
+	for(size_t i = sync; i < block.segments.size(); i++){
+		block.segments[i].begin += edit.delta;
+	}
+
+	StatementList & statements = block.node->statements;
+	if(new_segments.size() == sync - first){
+		std::move(new_segments.begin(), new_segments.end(), block.segments.begin() + first);
+		std::copy(parsed->statements.begin(), parsed->statements.end(), statements.begin() + first);
+	}else{
+		block.segments.erase(block.segments.begin() + first, block.segments.begin() + sync);
+		block.segments.insert(block.segments.begin() + first,
+							  std::make_move_iterator(new_segments.begin()),
+							  std::make_move_iterator(new_segments.end()));
+		statements.erase(statements.begin() + first, statements.begin() + sync);
+		statements.insert(statements.begin() + first, parsed->statements.begin(), parsed->statements.end());
+	}
+
+	last_relexed = relexed.tokens.size();
+	last_spliced = 1;
+	return true;
+}
+
+void IncrementalParser::edit(const uint32_t & offset, const uint32_t & removed, std::string_view inserted){
+	code.replace(offset, removed, inserted);
+	lines.edit(offset, removed, inserted);
+
+	// Replaced statements are not freed, parse everything again when there's too much of them
+	if(segments.empty() || parsed_tokens > total_tokens * 2 + 4096){
+		parse_all();
+		return;
+	}
+
+	const int64_t delta = static_cast<int64_t>(inserted.size()) - removed;
+	const EditRange range{offset, removed, delta};
+	last_relexed = 0;
+	last_reparsed = 0;
+	last_spliced = 0;
+
+	// Nested blocks containing the edited range inside of their braces, from the outermost one
+	struct Level {
+		Segment * segment;
+		uint32_t begin;
+		Block * block;
+	};
+	std::vector <Level> path;
+	std::vector <Segment> * level = &segments;
+	uint32_t base = 0;
+	while(true){
+		auto it = std::upper_bound(level->begin(), level->end(), offset, [&base](const uint32_t & off, const Segment & segment){
+			return off < base + segment.begin;
+		});
+		if(it == level->begin()){
+			break;
+		}
+		Segment & segment = *(it - 1);
+		const uint32_t begin = base + segment.begin;
+		auto block = std::find_if(segment.blocks.begin(), segment.blocks.end(), [&](const Block & block){
+			return offset > begin + segment.tokens[block.open].offset && offset + removed <= begin + segment.tokens[block.open + 1].offset;
+		});
+		if(block == segment.blocks.end()){
+			break;
+		}
+		path.push_back(Level{&segment, begin, &*block});
+		level = &block->segments;
+		base = begin + segment.tokens[block->open].offset;
+	}
+
+	for(size_t i = path.size(); i-- > 0;){
+		if(!edit_block(*path[i].segment, path[i].begin, *path[i].block, range)){
+			continue;
+		}
+
+		// Tokens and nodes after changed blocks are moved, segments keep offsets relative to their blocks
+		for(size_t j = i + 1; j-- > 0;){
+			Segment & segment = *path[j].segment;
+			const uint32_t open = path[j].block->open;
+			move_offsets(segment, segment.parsed_begin + segment.tokens[open].offset, delta);
+			for(size_t k = open + 1; k < segment.tokens.size(); k++){
+				segment.tokens[k].offset += delta;
+			}
+
+			std::vector <Segment> & around = j > 0 ? path[j - 1].block->segments : segments;
+			for(size_t k = &segment - around.data() + 1; k < around.size(); k++){
+				around[k].begin += delta;
+				if(!around[k].error.empty()){
+					update_error(around[k]);
+				}
+			}
+		}
+		return;
+	}
+
+	Relexed relexed;
+	relex(segments, 0, nullptr, range, relexed);
+	const size_t first = relexed.first;
+	const size_t sync = relexed.sync;
+
+	// Errors of tokens after the region belong to old segments
+	if(sync != segments.size()){
+		const uint32_t region_end = segments[sync].begin + delta;
+		std::erase_if(lex_errors, [&region_end](const auto & error){
+			return error.first >= region_end;
+		});
+	}
+
+	std::vector <Segment> new_segments;
+	make_segments(relexed.tokens, relexed.ends, new_segments);
+
+	for(size_t i = first; i < sync; i++){
+		total_tokens -= count_tokens(segments[i]);
+	}
+	total_tokens += relexed.tokens.size();
+
+	for(size_t i = sync; i < segments.size(); i++){
+		segments[i].begin += delta;
+		if(!segments[i].error.empty()){
+			update_error(segments[i]);
+		}
+	}
+
+	// Note: Usually edit doesn't change count of statements, then segments after it are not moved in vector
+	if(new_segments.size() == sync - first){
+		std::move(new_segments.begin(), new_segments.end(), segments.begin() + first);
+	}else{
+		segments.erase(segments.begin() + first, segments.begin() + sync);
+		segments.insert(segments.begin() + first,
+						std::make_move_iterator(new_segments.begin()),
+						std::make_move_iterator(new_segments.end()));
+	}
+
+	last_relexed = relexed.tokens.size();
+}
+
+StatementList IncrementalParser::get_tree() const {
+	StatementList tree;
+	for(const Segment & segment : segments){
+		tree.insert(tree.end(), segment.statements.begin(), segment.statements.end());
+	}
+	return tree;
+}
@@ -0,0 +1,205 @@
+#ifndef INCREMENTALPARSER_H
+#define INCREMENTALPARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+#include "Lexer.h"
+#include "Parser.h"
+
+// IncrementalParser keeps code, tokens and tree of one file and updates them on edits.
+// Code is split into segments, one per top-level statement (see `split_statements`),
+// segment keeps its tokens with offsets relative to segment start and its parsed statements.
+// Statements of large blocks (at least `nested_tokens` tokens in braces) are split into segments
+// of that block the same way, so tokens of segment don't include tokens inside of its nested blocks.
+// On edit the innermost nested block containing edited range is found, tokens around the edit
+// are lexed again only until some token is the same as old token at the same place (as in `ParallelLexer::stitch`),
+// the rest of old tokens up to the start of the next segment is reused, and only segments covering
+// changed tokens are parsed again. Segments after the edit are just moved by the size difference,
+// so cost of edit depends on the size of edited statements and not of the block around them.
+// If edit changes brackets of nested block (or its tokens can't be parsed as block), the edit is done
+// in the enclosing block, and finally in top-level code, where the segment is parsed whole.
+// Note: Offsets in nodes of segment are offsets at the moment of its parsing,
+// use `Segment::shift()` (for top-level segments) or `walk()` to get their current position in code
+
+class IncrementalParser {
+	public:
+		IncrementalParser(const uint32_t & nested_tokens = 256);
+		virtual ~IncrementalParser() = default;
+
+		struct Block;
+
+		struct Segment {
+			// Byte offset of the first token, for segment of nested block it's relative to `{` of block
+			uint32_t begin;
+			// Offsets are relative to `begin`, tokens inside of nested blocks are kept by their segments
+			std::vector <Token> tokens;
+			StatementList statements;
+			// Error of the last lexing or parsing, segment has no statements then
+			std::string error;
+			// Note: Offset of error is moved with offsets of nodes (see `shift()`)
+			uint32_t error_offset;
+			// Absolute `begin` at the moment of parsing
+			uint32_t parsed_begin;
+			// Large blocks of statements in order of their `{`
+			std::vector <Block> blocks;
+
+			int64_t shift() const {
+				return static_cast<int64_t>(begin) - parsed_begin;
+			}
+		};
+
+		struct Block {
+			NBlock * node;
+			// Index of `{` in tokens of segment, its `}` is the next token
+			uint32_t open;
+			// Segments of `node->statements`, one statement each
+			std::vector <Segment> segments;
+		};
+
+		// Parse the whole code, code is copied
+		void parse(std::string_view code);
+
+		// Replace `removed` bytes at `offset` with `inserted`
+		void edit(const uint32_t & offset, const uint32_t & removed, std::string_view inserted);
+
+		std::string_view get_code() const {
+			return code;
+		}
+
+		const std::vector <Segment> & get_segments() const {
+			return segments;
+		}
+
+		// All top-level statements in order
+		StatementList get_tree() const;
+
+		// Tokens of segment and its nested blocks, `begin` is absolute offset of segment,
+		// tokens are appended with absolute offsets
+		static void get_tokens(const Segment & segment, const uint32_t & begin, std::vector <Token> & tokens);
+
+		// Call `visit(node, offset)` for all nodes of segment with their current offsets in code,
+		// nodes are visited in order of `Node::get_children`, parent before its children
+		template <class Visit>
+		static void walk(const Segment & segment, const uint32_t & begin, Visit visit){
+			struct Item {
+				Node * node;
+				const Segment * segment;
+				uint32_t begin;
+			};
+			std::vector <Item> stack;
+			std::vector <Node*> children;
+			auto push_segment = [&stack](const Segment & segment, const uint32_t & begin){
+				for(auto it = segment.statements.rbegin(); it != segment.statements.rend(); ++it){
+					stack.push_back(Item{*it, &segment, begin});
+				}
+			};
+
+			push_segment(segment, begin);
+			while(!stack.empty()){
+				const Item item = stack.back();
+				stack.pop_back();
+				if(!item.node){
+					continue;
+				}
+				visit(item.node, static_cast<uint32_t>(item.node->offset + (static_cast<int64_t>(item.begin) - item.segment->parsed_begin)));
+
+				auto block = std::find_if(item.segment->blocks.begin(), item.segment->blocks.end(), [&item](const Block & block){
+					return block.node == item.node;
+				});
+				if(block != item.segment->blocks.end()){
+					const uint32_t open = item.begin + item.segment->tokens[block->open].offset;
+					for(auto it = block->segments.rbegin(); it != block->segments.rend(); ++it){
+						push_segment(*it, open + it->begin);
+					}
+					continue;
+				}
+				children.clear();
+				item.node->get_children(children);
+				for(auto it = children.rbegin(); it != children.rend(); ++it){
+					stack.push_back(Item{*it, item.segment, item.begin});
+				}
+			}
+		}
+
+		// Stats of the last `edit`
+		uint32_t relexed_tokens() const {
+			return last_relexed;
+		}
+		uint32_t reparsed_segments() const {
+			return last_reparsed;
+		}
+		uint32_t spliced_blocks() const {
+			return last_spliced;
+		}
+
+	private:
+		std::string code;
+		LineIndex lines;
+		Lexer lexer;
+		Parser parser;
+		std::vector <Segment> segments;
+
+		// Blocks with fewer tokens in braces are parsed with their statement
+		uint32_t nested_tokens;
+
+		uint32_t last_relexed;
+		uint32_t last_reparsed;
+		uint32_t last_spliced;
+
+		// Replaced statements stay in Parser arena until full parsing,
+		// count of tokens parsed since it is used to limit the waste
+		uint32_t parsed_tokens;
+		uint32_t total_tokens;
+
+		void parse_all();
+
+		// Errors found by `lex()`, they're added to segments by `make_segments()`
+		std::vector <std::pair<uint32_t, std::string>> lex_errors;
+
+		// Lex code from `begin` until `end` (and to the end of token crossing it)
+		uint32_t lex(const uint32_t & begin, const uint32_t & end, std::vector <Token> & tokens);
+
+		struct EditRange {
+			uint32_t offset;
+			uint32_t removed;
+			int64_t delta;
+		};
+
+		// Tokens lexed again after edit, they replace segments [first, sync) of top-level code or of nested block,
+		// `ends` are ends of their statements
+		struct Relexed {
+			std::vector <Token> tokens;
+			std::vector <uint32_t> ends;
+			size_t first;
+			size_t sync;
+		};
+
+		// Lex again segments around the edit, `begin` of segments is relative to `base`,
+		// `close` is `}` of nested block in current code (nullptr for top-level code),
+		// returns false if tokens of block can't be lexed again without its braces
+		bool relex(const std::vector <Segment> & segments,
+				   const uint32_t & base,
+				   const Token * close,
+				   const EditRange & edit,
+				   Relexed & relexed);
+
+		// Split absolute tokens of top-level code into segments and parse them
+		void make_segments(const std::vector <Token> & tokens,
+						   const std::vector <uint32_t> & ends,
+						   std::vector <Segment> & result);
+		void parse_segment(Segment & segment);
+		// Position in error message is of the moment of parsing, it's updated when segment is moved
+		void update_error(Segment & segment);
+
+		// Move statements of large blocks of just parsed segment into nested segments
+		void nest(Segment & segment);
+
+		// Lex and parse again edited segments of `block` of `segment` (`begin` is its absolute offset),
+		// returns false if edit must be done in the enclosing block
+		bool edit_block(Segment & segment, const uint32_t & begin, Block & block, const EditRange & edit);
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "Interner.h"
+
+#include <cstring>
+#include <array>
+#include <stdexcept>
+
+Interner::Interner(){
+	chunk_used = CHUNK_SIZE;
+	pages.reset(new std::unique_ptr<Entry[]>[MAX_PAGES]);
+	count.store(0, std::memory_order_relaxed);
+
+	// Note: Table size must be power of 2
+	table.assign(1024, 0);
+}
+
+Symbol Interner::intern(std::string_view str){
+	const uint32_t h = hash(str);
+
+	// Per-thread direct-mapped cache of recently interned strings
+	struct CacheSlot {
+		const Interner * owner;
+		Symbol sym;
+	};
+	static thread_local std::array <CacheSlot, 1024> cache{};
+
+	CacheSlot & slot = cache[h & (cache.size() - 1)];
+	if(slot.owner == this){
+		const Entry & cached = entry(slot.sym);
+		if(cached.hash == h && cached.str == str){
+			return slot.sym;
+		}
+	}
+
+	Symbol sym;
+	{
+		std::lock_guard <std::mutex> lock(mutex);
+		sym = insert(str, h);
+	}
+
+	slot.owner = this;
+	slot.sym = sym;
+
+	return sym;
+}
+
+Symbol Interner::insert(std::string_view str, const uint32_t & h){
+	const uint32_t mask = table.size() - 1;
+
+	uint32_t slot = h & mask;
+	while(table[slot] != 0){
+		const Symbol sym = table[slot] - 1;
+		const Entry & e = entry(sym);
+		if(e.hash == h && e.str == str){
+			return sym;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	const Symbol sym = count.load(std::memory_order_relaxed);
+	if((sym >> PAGE_BITS) >= MAX_PAGES){
+		throw std::length_error("Interner: too many symbols");
+	}
+	if((sym & (PAGE_SIZE - 1)) == 0){
+		pages[sym >> PAGE_BITS].reset(new Entry[PAGE_SIZE]);
+	}
+	pages[sym >> PAGE_BITS][sym & (PAGE_SIZE - 1)] = Entry{std::string_view(store(str), str.size()), h};
+	table[slot] = sym + 1;
+	count.store(sym + 1, std::memory_order_release);
+
+	// Keep load factor under 1/2
+	if((sym + 1) * 2 > table.size()){
+		grow();
+	}
+
+	return sym;
+}
+
+const char * Interner::store(std::string_view str){
+	if(str.empty()){
+		return "";
+	}
+
+	// Note: Long strings get their own chunk, so the current chunk is not wasted
+	if(str.size() > CHUNK_SIZE / 4){
+		chunks.emplace_back(new char[str.size()]);
+		std::memcpy(chunks.back().get(), str.data(), str.size());
+		const char * stored = chunks.back().get();
+		// Keep the current chunk at the back
+		if(chunks.size() > 1){
+			std::swap(chunks[chunks.size() - 1], chunks[chunks.size() - 2]);
+		}
+		return stored;
+	}
+
+	if(chunk_used + str.size() > CHUNK_SIZE){
+		chunks.emplace_back(new char[CHUNK_SIZE]);
+		chunk_used = 0;
+	}
+
+	char * stored = chunks.back().get() + chunk_used;
+	std::memcpy(stored, str.data(), str.size());
+	chunk_used += str.size();
+
+	return stored;
+}
+
+void Interner::grow(){
+	std::vector <uint32_t> new_table(table.size() * 2, 0);
+	const uint32_t mask = new_table.size() - 1;
+	const uint32_t size = count.load(std::memory_order_relaxed);
+
+	for(Symbol sym = 0; sym < size; sym++){
+		uint32_t slot = entry(sym).hash & mask;
+		while(new_table[slot] != 0){
+			slot = (slot + 1) & mask;
+		}
+		new_table[slot] = sym + 1;
+	}
+
+	table.swap(new_table);
+}
+
+// FNV-1a
+uint32_t Interner::hash(std::string_view str){
+	uint32_t h = 2166136261u;
+	for(const char & c : str){
+		h ^= static_cast<unsigned char>(c);
+		h *= 16777619u;
+	}
+	return h;
+}
@@ -0,0 +1,84 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+// Symbol is the id of interned string, same strings always have same Symbol,
+// so names are compared as integers
+typedef uint32_t Symbol;
+
+// Interner stores every distinct string once in arena chunks and gives it stable Symbol.
+// Strings are never freed or moved, so `str()` views stay valid until the end of program.
+// Note: Interner is thread-safe (chunks of code are lexed in parallel),
+// repeating names are found in per-thread cache without locking
+class Interner {
+	public:
+		Interner();
+		virtual ~Interner() = default;
+
+		Interner(const Interner &) = delete;
+		Interner & operator=(const Interner &) = delete;
+
+		Symbol intern(std::string_view str);
+
+		std::string_view str(const Symbol & sym) const {
+			return entry(sym).str;
+		}
+
+		uint32_t size() const {
+			return count.load(std::memory_order_acquire);
+		}
+
+	private:
+		std::mutex mutex;
+
+		// Arena
+		static const uint32_t CHUNK_SIZE = 64 * 1024;
+		std::vector <std::unique_ptr<char[]>> chunks;
+		uint32_t chunk_used;
+		const char * store(std::string_view str);
+
+		// Entries are stored in fixed pages, so they're never moved and can be read without locking
+		// Note: Symbol is the index of entry
+		struct Entry {
+			std::string_view str;
+			uint32_t hash;
+		};
+		static const uint32_t PAGE_BITS = 12;
+		static const uint32_t PAGE_SIZE = 1 << PAGE_BITS;
+		static const uint32_t MAX_PAGES = 1 << 14;
+		std::unique_ptr <std::unique_ptr<Entry[]>[]> pages;
+		std::atomic <uint32_t> count;
+
+		const Entry & entry(const Symbol & sym) const {
+			return pages[sym >> PAGE_BITS][sym & (PAGE_SIZE - 1)];
+		}
+
+		// Open-addressing hash set of `Symbol + 1`, 0 is empty slot
+		std::vector <uint32_t> table;
+		Symbol insert(std::string_view str, const uint32_t & h);
+		void grow();
+
+		static uint32_t hash(std::string_view str);
+};
+
+// Global interner shared by Lexer, Parser and Scope
+inline Interner & interner(){
+	static Interner instance;
+	return instance;
+}
+
+inline Symbol intern(std::string_view str){
+	return interner().intern(str);
+}
+
+inline std::string_view symbol_str(const Symbol & sym){
+	return interner().str(sym);
+}
+
+#endif
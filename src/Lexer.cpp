@@ -1,572 +1,643 @@
 #include "Lexer.h"
 
-#include <iostream>
+#include "Trace.h"
 
 Lexer::Lexer(){
-	// Note: When using line and column to show tokens in error output, use (column-1)
-	tokens.clear();
+	reset();
+}
+
+void Lexer::reset(){
+	code = source.view();
 
 	index = 0;
-	line = 1;
-	column = 0;
+	code_lines = nullptr;
+
+	token_ready = false;
+	prog_end = false;
+	// Note: T_PROG_END as last type means that there were no tokens yet
+	last_type = T_PROG_END;
 }
 
 char Lexer::peek(){
+	// Note: Mapped code is not null-terminated, so '\0' is returned at the end
+	if(index >= code.size()){
+		return '\0';
+	}
 	return code[index];
 }
 
+char Lexer::peek_next(){
+	if(index + 1 >= code.size()){
+		return '\0';
+	}
+	return code[index + 1];
+}
+
+// Note: Lexer tracks only byte offset, line and column are computed by LineIndex on error
 char Lexer::advance(){
 	index++;
-	if(peek() == '\n'){
-		line++;
-		column = 0;
-	}else{
-		column++;
-	}
 	return peek();
 }
 
-void Lexer::add_token(const TokenType & type, const std::string & val){
-	Token t(type, val);
-	t.pos.line = line;
-	t.pos.column = column;
-	tokens.push_back(t);
+// Note: Token span is [token_start, index) and it's finished in `next_token`,
+// because some tokens are added before their last char is skipped
+void Lexer::add_token(const TokenType & type, const uint32_t & val){
+	token = Token{type, token_start, 0, val};
+	token_ready = true;
+	last_type = type;
 }
 void Lexer::add_token(const Operator & op){
-	Token t(op);
-	t.pos.line = line;
-	t.pos.column = column;
-	tokens.push_back(t);
+	add_token(T_OP, static_cast<uint32_t>(op));
 }
 
 // Determinators
 bool Lexer::eof(){
-	return index >= code.length();
+	return index >= code.size();
 }
+// Note: Determinators are lookups in constant table, see CharClass.h
 bool Lexer::is_skipable(const char & c){
-	return c == ' '  || c == '\t' || c == '\v'
-		|| c == '\f' || c == '\r';
+	return is_char_class(c, CC_SKIPABLE);
 }
 bool Lexer::is_endl(const char & c){
-	return c == '\n';
+	return is_char_class(c, CC_ENDL);
 }
 bool Lexer::is_digit(const char & c){
-	return c >= '0' && c <= '9';
+	return is_char_class(c, CC_DIGIT);
 }
 bool Lexer::is_hex(const char & c){
-	return is_digit(c)
-		|| (c >= 'a' && c <= 'f')
-		|| (c >= 'A' && c <= 'F');
+	return is_char_class(c, CC_HEX);
 }
 bool Lexer::is_identifier_first(const char & c){
-	return (c >= 'a' && c <= 'z')
-		|| (c >= 'A' && c <= 'Z')
-		||  c == '$' || c == '_';
+	return is_char_class(c, CC_ID_FIRST);
 }
 bool Lexer::is_identifier(const char & c){
-	return is_identifier_first(c) || is_digit(c);
+	return is_char_class(c, CC_ID);
 }
 bool Lexer::is_quote(const char & c){
-	return c == '"' || c == '\'' || c == '`';
+	return is_char_class(c, CC_QUOTE);
 }
 
-void Lexer::lex_number(){	
-	std::string num;
-	enum {
-		INT, BIN, HEX, FLOAT
-	} number_type;
-
-	bool negative = false;
-
-	number_type = INT;
-
-	if(peek() == '-'){
-		negative = true;
-		advance();
+// Skip run of chars matching `matcher` by blocks of 16/32 chars
+template <class Matcher>
+void Lexer::skip_run(const Matcher & matcher){
+	if(eof()){
+		return;
 	}
+	index += run_length(matcher, code.data() + index, code.size() - index);
+}
 
-	if(peek() == '0'){
-		if(negative){
-			error("Only integer numbers can be negative");
+// Digits run with `_` separators, separator must be followed by digit
+void Lexer::skip_digits(const uint8_t & cc){
+	while(true){
+		if(cc == CC_DIGIT){
+			skip_run(DigitMatcher{});
+		}else{
+			while(is_char_class(peek(), cc)){
+				advance();
+			}
+		}
+		if(peek() != '_'){
+			break;
 		}
 		advance();
-		if(peek() == 'x' || peek() == 'X'){
-			number_type = HEX;
-			advance();
-			num = "0x";
-		}else if(peek() == 'b' || peek() == 'B'){
-			number_type = BIN;
-			advance();
-			num = "0b";
-		}else{
-			num = "0";
+		if(!is_char_class(peek(), cc)){
+			error("Expected digit after `_` in number literal");
 		}
 	}
+}
 
-	if(number_type == HEX){
-		while(is_hex(peek())){
-			num += peek();
-			advance();
+// Note: Number is not converted here, only scanned and checked for range.
+// Token gets value from its span with `from_chars`, so no strings are built
+void Lexer::lex_number(){
+	bool is_float = false;
+
+	if(peek() == '0' && (peek_next() == 'x' || peek_next() == 'X')){
+		advance();
+		advance();
+		if(!is_hex(peek())){
+			error("Expected hex digit after `0x`");
+		}
+		skip_digits(CC_HEX);
+	}else if(peek() == '0' && (peek_next() == 'b' || peek_next() == 'B')){
+		advance();
+		advance();
+		if(peek() != '0' && peek() != '1'){
+			error("Expected binary digit after `0b`");
 		}
-	}else if(number_type == BIN){
-		if(peek() != '0' || peek() != '1'){
+		skip_digits(CC_BIN);
+		if(is_digit(peek())){
 			unexpected_token();
 		}
-		do{
-			num += peek();
-		}while(peek() == '0' || peek() == '1');
 	}else{
-		while(is_digit(peek())){
-			num += peek();
+		skip_digits(CC_DIGIT);
+
+		// Note: only decimal numbers can be floating.
+		// `1..2` and `1.foo` are not floats, dot must be followed by digit
+		if(peek() == '.' && is_digit(peek_next())){
 			advance();
+			skip_digits(CC_DIGIT);
+			is_float = true;
 		}
-	}
 
-	// Note: only decimal numbers can be floating
-	if(number_type == INT && peek() == '.'){
-		num += peek();
-		if(!is_digit(advance())){
-			unexpected_token("");
-		}
-		while(is_digit(peek())){
-			num += peek();
-			advance();
+		if(peek() == 'e' || peek() == 'E'){
+			const char sign = peek_next();
+			const uint32_t exp_start = (sign == '+' || sign == '-') ? index + 2 : index + 1;
+			if(exp_start < code.size() && is_digit(code[exp_start])){
+				index = exp_start;
+				skip_digits(CC_DIGIT);
+				is_float = true;
+			}
 		}
-		number_type = FLOAT;
 	}
 
-	TokenType token_type;
+	if(is_identifier(peek())){
+		unexpected_token();
+	}
 
-	switch(number_type){
-		case INT:
-		case HEX:
-		case BIN:{
-			token_type = T_INT;
+	const std::string_view literal = code.substr(token_start, index - token_start);
+	NumberStatus status;
+	if(is_float){
+		double value;
+		status = parse_float_literal(literal, value);
+	}else{
+		int64_t value;
+		status = parse_int_literal(literal, value);
+	}
+
+	switch(status){
+		case NUM_OK: break;
+		case NUM_OUT_OF_RANGE:{
+			error("Number `" + std::string(literal) + "` is out of range");
+			break;
+		}
+		case NUM_TOO_LONG:{
+			error("Number literal is too long");
 			break;
 		}
-		case FLOAT:{
-			token_type = T_FLOAT;
+		case NUM_INVALID:{
+			error("Invalid number literal `" + std::string(literal) + "`");
 			break;
 		}
 	}
 
-	add_token(token_type, num);
+	add_token(is_float ? T_FLOAT : T_INT);
 }
 
-std::string Lexer::lex_identifier(){
-	std::string id(1, peek());
-	while(is_identifier(advance())){
-		id += peek();
-	}
-	return id;
+std::string_view Lexer::lex_identifier(){
+	const uint32_t start = index;
+	advance();
+	skip_run(IdentifierMatcher{});
+	return code.substr(start, index - start);
 }
 
 // Errors
 void Lexer::error(const std::string & msg){
-	// Debug
-	std::cout << "Tokens:\n";
-	for(auto & t : tokens){
-		std::cout << t.to_string(true) << std::endl;
+	if(!code_lines){
+		lines.build(code);
+		code_lines = &lines;
 	}
 
-	err("Lexer [ERROR]: " + msg, line, column);
+	TRACE(TL_DEBUG, TC_LEXER, "Last token: ", token.to_string(code, *code_lines));
+
+	Position pos = code_lines->position(index);
+	err("Lexer [ERROR]: " + msg, pos.line, pos.column);
 }
 void Lexer::unexpected_token(const std::string & token){
 	error("Unexpected token `" + (token.empty() ? std::string(1, peek()) : token) + "`");
 }
 
+void Lexer::open(const char * path){
+	source.open(path);
+	reset();
+}
+
+void Lexer::open(std::string_view code){
+	source.borrow(code);
+	reset();
+}
+
 std::vector <Token> Lexer::lex(const char * path){
-	// Read code (Maybe move to separate stream class)
-	std::ifstream file(path);
-	std::stringstream buffer;
-	buffer << file.rdbuf();
-	code = buffer.str();
+	open(path);
+	return lex_all();
+}
+
+std::vector <Token> Lexer::lex(std::string_view code){
+	open(code);
+	return lex_all();
+}
+
+std::vector <Token> Lexer::lex_all(){
+	std::vector <Token> tokens;
+	do{
+		tokens.push_back(next_token());
+	}while(tokens.back().type != T_PROG_END);
+
+	return tokens;
+}
+
+Token Lexer::next_token(){
+	while(!token_ready){
+		if(eof()){
+			if(prog_end){
+				return token;
+			}
+			prog_end = true;
+			token_start = index;
+			add_token(T_PROG_END);
+			break;
+		}
+		token_start = index;
+		lex_token();
+	}
+	return take_token();
+}
 
-	// Fix first endl line++
-	// TODO: Move to Stream
-	// if(peek() == '\n'){
-	// 	line++;
-	// }
+uint32_t Lexer::lex_range(std::string_view code,
+						  const uint32_t & begin,
+						  const uint32_t & end,
+						  std::vector <Token> & tokens,
+						  const LineIndex * code_lines)
+{
+	source.borrow(code);
+	reset();
+	index = begin;
+	this->code_lines = code_lines;
 
-	while(!eof()){
-		// TODO: Add comments
+	while(index < end && !eof()){
+		token_start = index;
+		lex_token();
+		if(token_ready){
+			tokens.push_back(take_token());
+		}
+	}
+
+	return index;
+}
 
-		// Think about replacing determinator functions and arrays with switch-case
-		// Maybe it will increase efficiency
+Token Lexer::take_token(){
+	token.length = index - token.offset;
+	token_ready = false;
+	return token;
+}
+
+void Lexer::lex_token(){
+	// Think about replacing determinator functions and arrays with switch-case
+	// Maybe it will increase efficiency
 
-		if(is_skipable(peek())){
+	if(is_skipable(peek())){
+		skip_run(SkipableMatcher{});
+	}else if(is_endl(peek())){
+		// TODO: Skip case "endl [white-space] endl"
+		while(is_endl(peek())){
 			advance();
-			continue;
-		}else if(is_endl(peek())){
-			// TODO: Skip case "endl [white-space] endl"
-			while(is_endl(peek())){
+		}
+		// Do not add endl token if previous was endl
+		if(last_type != T_ENDL){
+			add_token(T_ENDL);
+		}
+	}else if(is_identifier_first(peek())){
+		std::string_view id = lex_identifier();
+		const Word * word = find_word(id);
+		if(!word){
+			add_token(T_ID, intern(id));
+		}else if(word->type == T_OP && word->val == OP_AS && peek() == '?'){
+			// Check for `as?` operator
+			add_token(OP_AS_NULLABLE);
+			advance();
+		}else{
+			add_token(word->type, word->val);
+		}
+	}else if(is_digit(peek())){
+		lex_number();
+	}else if(is_quote(peek())){
+		const char quote = peek();
+		const uint32_t str_start = index + 1;
+		advance();
+		skip_run(StringBodyMatcher{quote});
+		if(eof() || peek() != quote){
+			error("Expected ending quote `" + std::string(1, quote) + "`");
+		}
+		add_token(T_STR, intern(code.substr(str_start, index - str_start)));
+		advance();
+	}else{
+		// Lex operators
+		switch(peek()){
+			case '+':{
 				advance();
+				switch(peek()){
+					case '=':{
+						add_token(OP_ASSIGN_ADD);
+						advance();
+						break;
+					}
+					case '+':{
+						add_token(OP_INC);
+						advance();
+						break;
+					}
+					default: add_token(OP_ADD); break;
+				}
+				break;
 			}
-			// Do not add endl token if previous was endl
-			if(!(tokens.size() > 0 && tokens.back().type == T_ENDL)){
-				add_token(T_ENDL, "");
-			}
-		}else if(is_identifier_first(peek())){
-			std::string id = lex_identifier();
-			if(is_kw(id)){
-				if(id == "true" || id == "false"){
-					add_token(T_BOOL, id);
+			case '-':{
+				advance();
+				if(is_digit(peek())){
+					lex_number();
+				}else if(peek() == '='){
+					add_token(OP_ASSIGN_SUB);
+					advance();
+				}else if(peek() == '-'){
+					add_token(OP_DEC);
+					advance();
 				}else{
-					add_token(T_KW, id);
+					add_token(OP_SUB);
 				}
-			}else if(id == "as" && peek() == '?'){
-				// Check for `as?` operator
-				add_token(OP_AS_NULLABLE);
-				advance();
-			}else if(str_operator(id) < operators.size()){
-				add_token(str_operator(id));
-			}else{
-				add_token(T_ID, id);
+				break;
 			}
-		}else if(is_digit(peek())){
-			lex_number();
-		}else if(is_quote(peek())){
-			std::string str = "";
-			const char quote = peek();
-			advance();
-			while(peek() != quote && !eof() && peek() != '\n'){
-				str += peek();
+			case '*':{
 				advance();
-			}
-			if(eof() || peek() != quote){
-				error("Expected ending quote `" + std::string(1, quote) + "`");
-			}
-			add_token(T_STR, str);
-			advance();
-		}else{
-			// Lex operators
-			switch(peek()){
-				case '+':{
-					advance();
-					switch(peek()){
-						case '=':{
-							add_token(OP_ASSIGN_ADD);
-							advance();
-							break;
-						}
-						case '+':{
-							add_token(OP_INC);
+				switch(peek()){
+					case '=':{
+						add_token(OP_ASSIGN_MUL);
+						advance();
+						break;
+					}
+					case '*':{
+						advance();
+						if(peek() == '='){
+							add_token(OP_ASSIGN_EXP);
 							advance();
-							break;
+						}else{
+							add_token(OP_EXP);
 						}
-						default: add_token(OP_ADD); break;
+						break;
 					}
-					break;
+					// case '/':{
+					// 	add_token(OP_CLOSE_COMMENT);
+					// 	advance();
+					// 	break;
+					// }
+					default: add_token(OP_MUL); break;
 				}
-				case '-':{
-					advance();
-					if(is_digit(peek())){
-						lex_number();
-					}else if(peek() == '='){
-						add_token(OP_ASSIGN_SUB);
+				break;
+			}
+			case '/':{
+				advance();
+				switch(peek()){
+					case '=':{
+						add_token(OP_ASSIGN_DIV);
 						advance();
-					}else if(peek() == '-'){
-						add_token(OP_DEC);
+						break;
+					}
+					// Note: One-line comment
+					case '/':{
+						while(!eof() && !is_endl(advance())){}
+						break;
+					}
+					case '*':{
+						// Start multiline comment
 						advance();
-					}else{
-						add_token(OP_SUB);
+						const size_t comment_end = code.find("*/", index);
+						// Note: Not closed comment lasts until the end
+						const uint32_t next = comment_end == std::string_view::npos ? code.size() : comment_end + 2;
+						TRACE(TL_VERBOSE, TC_LEXER, "Skip multi-line comment of ", next - index, " bytes at ", index);
+						index = next;
+						break;
 					}
-					break;
+					// TODO: Think about '//' as int div
+					default: add_token(OP_DIV); break;
 				}
-				case '*':{
-					advance();
-					switch(peek()){
-						case '=':{
-							add_token(OP_ASSIGN_MUL);
-							advance();
-							break;
-						}
-						case '*':{
-							advance();
-							if(peek() == '='){
-								add_token(OP_ASSIGN_EXP);
-								advance();
-							}else{
-								add_token(OP_EXP);
-							}
-							break;
-						}
-						// case '/':{
-						// 	add_token(OP_CLOSE_COMMENT);
-						// 	advance();
-						// 	break;
-						// }
-						default: add_token(OP_MUL); break;
+				break;
+			}
+			case '%':{
+				advance();
+				switch(peek()){
+					case '=':{
+						add_token(OP_ASSIGN_MOD);
+						advance();
+						break;
 					}
-					break;
+					default: add_token(OP_MOD); break;
 				}
-				case '/':{
+				break;
+			}
+			case '=':{
+				advance();
+				if(peek() == '='){
+					add_token(OP_EQUAL);
 					advance();
-					switch(peek()){
-						case '=':{
-							add_token(OP_ASSIGN_DIV);
-							advance();
-							break;
-						}
-						// Note: One-line comment
-						case '/':{
-							while(!is_endl(advance())){}
-							break;
-						}
-						case '*':{
-							// Start multiline comment
-							advance();
-							std::string comment_operator(1, peek());
-							comment_operator += advance();
-							std::cout << "comment_operator: " << comment_operator << std::endl;
-							while(!eof()){
-								std::cout << "comment_operator: " << comment_operator << std::endl;
-								if(comment_operator == "*/"){
-									break;
-								}
-								comment_operator = peek();
-								comment_operator += advance();
-							}
-							advance();
-							break;
-						}
-						// TODO: Think about '//' as int div
-						default: add_token(OP_DIV); break;
-					}
-					break;
-				}
-				case '%':{
+				}else if(peek() == '>'){
+					add_token(OP_ARROW);
 					advance();
-					switch(peek()){
-						case '=':{
-							add_token(OP_ASSIGN_MOD);
-							advance();
-							break;
-						}
-						default: add_token(OP_MOD); break;
-					}
-					break;
+				}else{
+					add_token(OP_ASSIGN);
 				}
-				case '=':{
-					advance();
-					if(peek() == '='){
-						add_token(OP_EQUAL);
+				break;
+			}
+			case '&':{
+				advance();
+				switch(peek()){
+					case '&':{
+						add_token(OP_AND);
 						advance();
-					}else if(peek() == '>'){
-						add_token(OP_ARROW);
+						break;
+					}
+					case '=':{
+						add_token(OP_ASSIGN_BIT_AND);
 						advance();
-					}else{
-						add_token(OP_ASSIGN);
+						break;
 					}
-					break;
+					default: add_token(OP_BIT_AND); break;
 				}
-				case '&':{
-					advance();
-					switch(peek()){
-						case '&':{
-							add_token(OP_AND);
-							advance();
-							break;
-						}
-						case '=':{
-							add_token(OP_ASSIGN_BIT_AND);
-							advance();
-							break;
-						}
-						default: add_token(OP_BIT_AND); break;
+				break;
+			}
+			case '|':{
+				advance();
+				switch(peek()){
+					case '|':{
+						add_token(OP_OR);
+						advance();
+						break;
 					}
-					break;
-				}
-				case '|':{
-					advance();
-					switch(peek()){
-						case '|':{
-							add_token(OP_OR);
-							advance();
-							break;
-						}
-						case '=':{
-							add_token(OP_ASSIGN_BIT_OR);
-							advance();
-							break;
-						}
-						case '>':{
-							add_token(OP_PIPELINE);
-							advance();
-							break;
-						}
-						default: add_token(OP_BIT_OR); break;
+					case '=':{
+						add_token(OP_ASSIGN_BIT_OR);
+						advance();
+						break;
 					}
-					break;
-				}
-				case '^':{
-					advance();
-					switch(peek()){
-						case '=':{
-							add_token(OP_ASSIGN_BIT_XOR);
-							advance();
-							break;
-						}
-						default: add_token(OP_BIT_XOR); break;
+					case '>':{
+						add_token(OP_PIPELINE);
+						advance();
+						break;
 					}
-					break;
+					default: add_token(OP_BIT_OR); break;
 				}
-				case '!':{
-					advance();
-					if(is_identifier_first(peek())){
-						std::string id = lex_identifier();
-						if(id == "in"){
-							add_token(OP_NOT_IN);
-							advance();
-						}else if(id == "is"){
-							add_token(OP_NOT_IS);
-						}else{
-							add_token(T_ID, id);
-						}
-					}else if(peek() == '='){
-						add_token(OP_NOT_EQUAL);
+				break;
+			}
+			case '^':{
+				advance();
+				switch(peek()){
+					case '=':{
+						add_token(OP_ASSIGN_BIT_XOR);
 						advance();
+						break;
+					}
+					default: add_token(OP_BIT_XOR); break;
+				}
+				break;
+			}
+			case '!':{
+				advance();
+				if(is_identifier_first(peek())){
+					const uint32_t id_start = index;
+					std::string_view id = lex_identifier();
+					if(id == "in"){
+						add_token(OP_NOT_IN);
+					}else if(id == "is"){
+						add_token(OP_NOT_IS);
 					}else{
+						// Note: Identifier is lexed again as next token (it can be `true`, `false`, etc.)
+						index = id_start;
 						add_token(OP_NOT);
 					}
-					break;
-				}
-				case '<':{
+				}else if(peek() == '='){
+					add_token(OP_NOT_EQUAL);
 					advance();
-					switch(peek()){
-						case '=':{
-							advance();
-							if(peek() == '>'){
-								add_token(OP_SPACESHIP);
-								advance();
-							}else{
-								add_token(OP_LESS_EQUAL);
-							}
-							break;
-						}
-						case '<':{
-							advance();
-							if(peek() == '='){
-								add_token(OP_ASSIGN_SHIFT_LEFT);
-								advance();
-							}else{
-								add_token(OP_SHIFT_LEFT);
-							}
-							break;
-						}
-						default: add_token(OP_LESS); break;
-					}
-					break;
+				}else{
+					add_token(OP_NOT);
 				}
-				case '>':{
-					advance();
-					switch(peek()){
-						case '=':{
-							add_token(OP_GREATER_EQUAL);
+				break;
+			}
+			case '<':{
+				advance();
+				switch(peek()){
+					case '=':{
+						advance();
+						if(peek() == '>'){
+							add_token(OP_SPACESHIP);
 							advance();
-							break;
+						}else{
+							add_token(OP_LESS_EQUAL);
 						}
-						case '>':{
+						break;
+					}
+					case '<':{
+						advance();
+						if(peek() == '='){
+							add_token(OP_ASSIGN_SHIFT_LEFT);
 							advance();
-							if(peek() == '='){
-								add_token(OP_ASSIGN_SHIFT_RIGHT);
-								advance();
-							}else{
-								add_token(OP_SHIFT_RIGHT);
-							}
-							break;
+						}else{
+							add_token(OP_SHIFT_LEFT);
 						}
-						default: add_token(OP_GREATER); break;
+						break;
 					}
-					break;
+					default: add_token(OP_LESS); break;
 				}
-				case '~':{
-					advance();
-					add_token(OP_BIT_INVERT);
-					break;
-				}
-				// Punctuations
-				case '(':{
-					add_token(OP_PAREN_L);
-					advance();
-					break;
-				}
-				case ')':{
-					add_token(OP_PAREN_R);
-					advance();
-					break;
-				}
-				case '[':{
-					add_token(OP_BRACKET_L);
-					advance();
-					break;
-				}
-				case ']':{
-					add_token(OP_BRACKET_R);
-					advance();
-					break;
-				}
-				case '{':{
-					add_token(OP_BRACE_L);
-					advance();
-					break;
-				}
-				case '}':{
-					add_token(OP_BRACE_R);
-					advance();
-					break;
-				}
-				case ':':{
-					add_token(OP_COLON);
-					advance();
-					break;
-				}
-				case ',':{
-					add_token(OP_COMMA);
-					advance();
-					break;
-				}
-				case '.':{
-					advance();
-					if(peek() == '.'){
+				break;
+			}
+			case '>':{
+				advance();
+				switch(peek()){
+					case '=':{
+						add_token(OP_GREATER_EQUAL);
 						advance();
-						if(peek() == '.'){
-							add_token(OP_SPREAD);
-							advance();
-						}else if(peek() == '='){
-							add_token(OP_RANGE_INCL);
+						break;
+					}
+					case '>':{
+						advance();
+						if(peek() == '='){
+							add_token(OP_ASSIGN_SHIFT_RIGHT);
 							advance();
 						}else{
-							add_token(OP_RANGE);
+							add_token(OP_SHIFT_RIGHT);
 						}
-					}else{
-						add_token(OP_MEMBER_ACCESS);
+						break;
 					}
-					break;
+					default: add_token(OP_GREATER); break;
 				}
-				case '?':{
+				break;
+			}
+			case '~':{
+				advance();
+				add_token(OP_BIT_INVERT);
+				break;
+			}
+			// Punctuations
+			case '(':{
+				add_token(OP_PAREN_L);
+				advance();
+				break;
+			}
+			case ')':{
+				add_token(OP_PAREN_R);
+				advance();
+				break;
+			}
+			case '[':{
+				add_token(OP_BRACKET_L);
+				advance();
+				break;
+			}
+			case ']':{
+				add_token(OP_BRACKET_R);
+				advance();
+				break;
+			}
+			case '{':{
+				add_token(OP_BRACE_L);
+				advance();
+				break;
+			}
+			case '}':{
+				add_token(OP_BRACE_R);
+				advance();
+				break;
+			}
+			case ':':{
+				add_token(OP_COLON);
+				advance();
+				break;
+			}
+			case ',':{
+				add_token(OP_COMMA);
+				advance();
+				break;
+			}
+			case '.':{
+				advance();
+				if(peek() == '.'){
 					advance();
-					if(peek() == ':'){
-						add_token(OP_ELVIS);
+					if(peek() == '.'){
+						add_token(OP_SPREAD);
+						advance();
+					}else if(peek() == '='){
+						add_token(OP_RANGE_INCL);
 						advance();
 					}else{
-						add_token(OP_QUESTION_MARK);
+						add_token(OP_RANGE);
 					}
-					break;
+				}else{
+					add_token(OP_MEMBER_ACCESS);
 				}
-				case ';':{
-					add_token(OP_SEMICOLON);
-					// Note: Skip all repeating semicolons, also delimited with endls!
-					while(advance() == ';' || is_endl(peek())){}
-					break;
+				break;
+			}
+			case '?':{
+				advance();
+				if(peek() == ':'){
+					add_token(OP_ELVIS);
+					advance();
+				}else{
+					add_token(OP_QUESTION_MARK);
 				}
-
-				default: unexpected_token("");
+				break;
 			}
+			case ';':{
+				add_token(OP_SEMICOLON);
+				// Note: Skip all repeating semicolons, also delimited with endls!
+				while(advance() == ';' || is_endl(peek())){}
+				break;
+			}
+
+			default: unexpected_token("");
 		}
 	}
-
-	add_token(T_PROG_END, "");
-
-	return tokens;
 }
\ No newline at end of file
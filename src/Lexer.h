@@ -1,36 +1,83 @@
 #ifndef LEXER_H
 #define LEXER_H
 
-#include <sstream>
-#include <fstream>
 #include <vector>
+#include <string_view>
 
 #include "Token.h"
+#include "Source.h"
+#include "TokenStream.h"
+#include "CharClass.h"
+#include "NumberLiteral.h"
 
-// TODO: Think about nextToken configuration instead of Lexer->Parser
+// Lexer is pull-based: Parser gets tokens one by one with `next_token()`,
+// so lexing and parsing go together and no full tokens list is stored.
+// `lex()` is just a wrapper that collects all tokens (used for debug output).
 
 // Note: One-line comments skipping is implemented on Lexer level, but
 // multi-line comments skipping is implemented on Parser level, because of complex operator problem
 
-class Lexer {
+class Lexer : public TokenSource {
 	public:
 		Lexer();
 		virtual ~Lexer() = default;
 
+		// Start lexing of file, it's mapped into memory and scanned in place
+		void open(const char * path);
+
+		// Start lexing of caller-owned code, it must outlive the Lexer
+		void open(std::string_view code);
+
+		// Lex next token, after the end of code it always returns `T_PROG_END`
+		virtual Token next_token() override;
+
+		virtual std::string_view get_code() override {
+			return code;
+		}
+
+		// Offset where lexing stopped (e.g. where error was found)
+		uint32_t get_index() const {
+			return index;
+		}
+
+		// Lex all tokens at once
 		std::vector <Token> lex(const char * path);
+		std::vector <Token> lex(std::string_view code);
+
+		// Lex tokens starting in [begin, end) of caller-owned code, without `T_PROG_END`
+		// Note: `begin` must be the start of line, the last token can end after `end`,
+		// returns offset where lexing actually stopped.
+		// Used by ParallelLexer to lex code by chunks,
+		// `code_lines` is line index of code kept by caller, it's used for error position
+		uint32_t lex_range(std::string_view code,
+						   const uint32_t & begin,
+						   const uint32_t & end,
+						   std::vector <Token> & tokens,
+						   const LineIndex * code_lines = nullptr);
 
 	private:
-		std::string code;
+		Source source;
+		std::string_view code;
+		void reset();
+		std::vector <Token> lex_all();
+
 		uint32_t index;
-		uint32_t line;
-		uint32_t column;
 		char peek();
+		char peek_next();
 		char advance();
 
-		std::vector <Token> tokens;
-		void add_token(const TokenType & type, const std::string & val);
+		// Note: One lexing step produces at most one token
+		Token token;
+		uint32_t token_start;
+		bool token_ready;
+		bool prog_end;
+		TokenType last_type;
+		void add_token(const TokenType & type, const uint32_t & val = 0);
 		void add_token(const Operator & op);
 
+		void lex_token();
+		Token take_token();
+
 		bool eof();
 		// Determinators
 		bool is_skipable(const char & c);
@@ -42,11 +89,18 @@ class Lexer {
 		bool is_quote(const char & c);
 		bool is_endl(const char & c);
 
+		template <class Matcher>
+		void skip_run(const Matcher & matcher);
+
+		void skip_digits(const uint8_t & cc);
 		void lex_number();
-		std::string lex_identifier();
+		std::string_view lex_identifier();
 
 	// Errors
 	private:
+		// Note: Line index is built only on error
+		LineIndex lines;
+		const LineIndex * code_lines;
 		void error(const std::string & msg);
 		void unexpected_token(const std::string & val = "");
 };
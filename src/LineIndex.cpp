@@ -0,0 +1,78 @@
+#include "LineIndex.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "CharClass.h"
+
+void LineIndex::build(std::string_view code){
+	line_starts.clear();
+	line_starts.push_back(0);
+
+	const char * data = code.data();
+	const uint32_t size = code.size();
+	uint32_t i = 0;
+
+#ifdef CHARCLASS_AVX2
+	const __m256i endl32 = _mm256_set1_epi8('\n');
+	while(i + 32 <= size){
+		const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, endl32)));
+		while(mask){
+			line_starts.push_back(i + std::countr_zero(mask) + 1);
+			mask &= mask - 1;
+		}
+		i += 32;
+	}
+#endif
+
+#ifdef CHARCLASS_SSE2
+	const __m128i endl16 = _mm_set1_epi8('\n');
+	while(i + 16 <= size){
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, endl16)));
+		while(mask){
+			line_starts.push_back(i + std::countr_zero(mask) + 1);
+			mask &= mask - 1;
+		}
+		i += 16;
+	}
+#endif
+
+	for(; i < size; i++){
+		if(data[i] == '\n'){
+			line_starts.push_back(i + 1);
+		}
+	}
+}
+
+void LineIndex::edit(const uint32_t & offset, const uint32_t & removed, std::string_view inserted){
+	// Lines starting after removed '\n' are joined, lines after the edit are moved
+	const size_t first = std::upper_bound(line_starts.begin(), line_starts.end(), offset) - line_starts.begin();
+	const size_t last = std::upper_bound(line_starts.begin() + first, line_starts.end(), offset + removed) - line_starts.begin();
+
+	const int64_t delta = static_cast<int64_t>(inserted.size()) - removed;
+	for(size_t i = last; i < line_starts.size(); i++){
+		line_starts[i] += delta;
+	}
+
+	std::vector <uint32_t> added;
+	for(uint32_t i = 0; i < inserted.size(); i++){
+		if(inserted[i] == '\n'){
+			added.push_back(offset + i + 1);
+		}
+	}
+
+	line_starts.erase(line_starts.begin() + first, line_starts.begin() + last);
+	line_starts.insert(line_starts.begin() + first, added.begin(), added.end());
+}
+
+Position LineIndex::position(const uint32_t & offset) const {
+	// Last line start that is not after offset
+	const auto line_start = std::upper_bound(line_starts.begin(), line_starts.end(), offset) - 1;
+
+	Position pos;
+	pos.line = static_cast<uint32_t>(line_start - line_starts.begin()) + 1;
+	pos.column = offset - *line_start;
+	return pos;
+}
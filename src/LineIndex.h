@@ -0,0 +1,37 @@
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+typedef struct {
+	uint32_t line;
+	uint32_t column;
+} Position;
+
+// Tokens and Nodes store only byte offset in code.
+// LineIndex converts offset to line:column, it's built only when position is really needed (e.g. for errors).
+class LineIndex {
+	public:
+		LineIndex() = default;
+		virtual ~LineIndex() = default;
+
+		// Find starts of all lines with vectorized '\n' scan
+		void build(std::string_view code);
+
+		// Update built index after `removed` bytes at `offset` were replaced with `inserted`
+		void edit(const uint32_t & offset, const uint32_t & removed, std::string_view inserted);
+
+		bool is_built() const {
+			return !line_starts.empty();
+		}
+
+		// Note: Line is 1-based, column is 0-based
+		Position position(const uint32_t & offset) const;
+
+	private:
+		std::vector <uint32_t> line_starts;
+};
+
+#endif
@@ -1,56 +1,82 @@
 #include "Node.h"
 
-Object * Node::eval(Scope * scope) {
-	return nullptr;
+// Note: Tree walker has no own stack, calls are C++ recursion through `eval`.
+// Collection is done only between statements (see `NBlock::eval`), so value of C++ stack
+// that is used after evaluation of other node is kept by Root
+const uint32_t MAX_CALL_DEPTH = 1000;
+
+static uint32_t call_depth = 0;
+
+static Value call(const Value & func, std::vector <Value> && args, const uint32_t & offset);
+
+Value Node::eval(Scope * scope) {
+	return Value::null();
 }
 
-Object * NExpression::eval(Scope * scope) {
-	return nullptr;
+Value NExpression::eval(Scope * scope) {
+	return Value::null();
 }
 
-Object * NStatement::eval(Scope * scope) {
-	return nullptr;
+Value NStatement::eval(Scope * scope) {
+	return Value::null();
 }
 
-Object * NExpressionStatement::eval(Scope * scope) {
-	return expression.eval();
+Value NExpressionStatement::eval(Scope * scope) {
+	return expression.eval(scope);
 }
 
 /////////////////
 // Value nodes //
 /////////////////
 
-Object * NInt::eval(Scope * scope) {
-	return new Int(*this);
+// Note: Literals don't allocate, except int that doesn't fit in Value
+Value NInt::eval(Scope * scope) {
+	return Value::integer(value);
 }
 
-Object * NFloat::eval(Scope * scope) {
-	return new Float(*this);
+Value NFloat::eval(Scope * scope) {
+	return Value::number(value);
 }
 
-Object * NBool::eval(Scope * scope) {
-	return new Bool(*this);
+Value NBool::eval(Scope * scope) {
+	return Value::boolean(value);
 }
 
-Object * NString::eval(Scope * scope) {
-	return new String(*this);
+Value NString::eval(Scope * scope) {
+	return Value::object(symbol_string(value));
 }
 
 //////////////////
 // Common nodes //
 //////////////////
 
-Object * NIdentifier::eval(Scope * scope) {
+// Scope and slot of variable resolved by Resolver
+static Scope * variable_scope(NIdentifier & id, Scope * scope, const uint32_t & offset){
+	Scope * var_scope = scope->up(id.depth);
+	if(id.check_defined && !var_scope->is_defined(id.slot)){
+		throw RuntimeError("`" + std::string(symbol_str(id.name)) + "` is not defined", offset);
+	}
+	return var_scope;
+}
+
+Value NIdentifier::eval(Scope * scope) {
 	// Note: NIdentifier is general for types, functions and variables
-	return scope->lookup(name);
+	return variable_scope(*this, scope, offset)->slots[slot];
 }
 
-Object * NBlock::eval(Scope * scope) {
-	// TODO: Think about return statement and the value of block
-	Object * last_stmt_value = nullptr;
+Value NBlock::eval(Scope * scope) {
+	// Note: Value of block is the value of its last statement,
+	// only expression statements have value
+	Scope * block_scope = slot_count ? heap().make<Scope>(scope, slot_count) : scope;
+	Root block_scope_root(block_scope);
+	Value last_stmt_value;
 	for(NStatement * stmt : statements){
 		if(stmt){
-			last_stmt_value = stmt->eval(scope);
+			heap().safepoint();
+			last_stmt_value = stmt->eval(block_scope);
+			if(block_scope->is_returned()){
+				return Value::null();
+			}
 		}
 	}
 	return last_stmt_value;
@@ -60,171 +86,413 @@ Object * NBlock::eval(Scope * scope) {
 // Operator nodes //
 ////////////////////
 
-// Note: Operators like &&, || are not overloadable
-const std::map <Operator, std::string> infix_operator_functions {
-	{OP_BIT_OR, "__or"},
-	{OP_BIT_XOR, "__xor"},
-	{OP_BIT_AND, "__and"},
-	{OP_EQUAL, "__eq"},
-	{OP_NOT_EQUAL, "__noteq"},
-	{OP_LESS, "__lt"},
-	{OP_LESS_EQUAL, "__le"},
-	{OP_GREATER, "__gt"},
-	{OP_GREATER_EQUAL, "__ge"},
-	{OP_SPACESHIP, "__cmp"},
-	{OP_SHIFT_LEFT, "__shl"},
-	{OP_SHIFT_RIGHT, "__shr"},
-	{OP_RANGE, "__rangeto"},
-	{OP_RANGE_INCL, "__rangeto_incl"},
-	{OP_ADD, "__add"},
-	{OP_SUB, "__sub"},
-	{OP_MUL, "__mul"},
-	{OP_DIV, "__div"},
-	{OP_MOD, "__mod"},
-	{OP_EXP, "__pow"},
-	{OP_IN, "__contains"}
-};
-
-const std::map <Operator, std::string> postfix_operator_functions {
-	{OP_INC, "__inc"},
-	{OP_DEC, "__dec"}
-};
-
-const std::map <Operator, std::string> prefix_operator_functions {
-	{OP_INC, "__inc"},
-	{OP_DEC, "__dec"},
-	{OP_ADD, "__uplus"},
-	{OP_SUB, "__uminus"},
-	{OP_NOT, "__not"},
-	{OP_BIT_INVERT, "__invert"}
-};
-
-Object * NInfixOp::eval(Scope * scope) {
-	Object * lho = left.eval(scope);
+// Assign to variable or list item, `update` gets the current value of target and returns the new one
+// Note: Current value is read only for augmented assignment, `++` and `--`, otherwise it's null
+template <class Update>
+static Value assign(NExpression & target, Scope * scope, const uint32_t & offset, const bool & read_current, Update update){
+	if(NIdentifier * id = dynamic_cast<NIdentifier*>(&target)){
+		// Note: Assignment to `val` is rejected by Resolver
+		Scope * var_scope = variable_scope(*id, scope, offset);
+		const Value value = update(read_current ? var_scope->slots[id->slot] : Value::null());
+		var_scope->set(id->slot, value);
+		return value;
+	}
+	if(NListAccess * access = dynamic_cast<NListAccess*>(&target)){
+		const Value object = access->left.eval(scope);
+		Root object_root(object);
+		const Value index = access->access.eval(scope);
+		Root index_root(index);
+		const Value current = read_current ? get_item(object, index, offset) : Value::null();
+		Root current_root(current);
+		const Value value = update(current);
+		return set_item(object, index, value, offset);
+	}
+	throw RuntimeError("Invalid left-hand side of assignment", offset);
+}
 
+Value NInfixOp::eval(Scope * scope) {
 	// Note: Augmented assignment operators work as: a += b -> a = a + b
 	// and cannot be overloaded (automatically overload when augment operator overloaded)
 
 	switch(op){
 		case OP_ASSIGN:{
-			return scope->set_var(right.eval(scope));
-			break;
+			return assign(left, scope, offset, false, [&](const Value &){ return right.eval(scope); });
 		}
-		// TODO: Add other augmented assignment operators
-		case OP_ASSIGN_ADD:{
-			return lho = lho->call_method(infix_operator_functions.at(OP_ADD), right.eval(scope));
-			break;
+		case OP_AND:{
+			return Value::boolean(left.eval(scope).to_bool() && right.eval(scope).to_bool());
+		}
+		case OP_OR:{
+			return Value::boolean(left.eval(scope).to_bool() || right.eval(scope).to_bool());
 		}
 		case OP_ELVIS:{
-			if(lho){
+			const Value lho = left.eval(scope);
+			if(!lho.is_null()){
 				return lho;
 			}else{
 				return right.eval(scope);
 			}
-			break;
 		}
-		case OP_NOT_IN:{
-			return lho->call_method()
-			break;
+		case OP_PIPELINE:{
+			// Note: `a |> f` is `f(a)`
+			const Value arg = left.eval(scope);
+			Root arg_root(arg);
+			const Value func = right.eval(scope);
+			return call(func, std::vector <Value>{arg}, offset);
 		}
 		default:{
-			return lho->call_method(infix_operator_functions.at(op), right.eval(scope));
+			const Operator base_op = augmented_operator(op);
+			if(base_op != op){
+				return assign(left, scope, offset, true, [&](const Value & current){
+					return call_infix(current, base_op, right.eval(scope), offset, cache);
+				});
+			}
+			const Value lho = left.eval(scope);
+			Root lho_root(lho);
+			return call_infix(lho, op, right.eval(scope), offset, cache);
 		}
 	}
 }
 
-Object * NPrefixOp::eval(Scope * scope) {
-	return right.eval(scope)->call_method(prefix_operator_functions.at(op));
+Value NPrefixOp::eval(Scope * scope) {
+	if(op == OP_INC || op == OP_DEC){
+		return assign(right, scope, offset, true, [&](const Value & current){ return call_prefix(op, current, offset, cache); });
+	}
+	return call_prefix(op, right.eval(scope), offset, cache);
 }
 
-Object * NPostfixOp::eval(Scope * scope) {
-	return left.eval(scope)->call_method(postfix_operator_functions.at(op));
+Value NPostfixOp::eval(Scope * scope) {
+	NIdentifier * id = dynamic_cast<NIdentifier*>(&left);
+	if(!id){
+		throw RuntimeError("Operator `" + op_to_str(op) + "` can be applied only to variable", offset);
+	}
+	Value old_value;
+	assign(*id, scope, offset, true, [&](const Value & current){
+		old_value = current;
+		return call_prefix(op, current, offset, cache);
+	});
+	return old_value;
 }
 
 ////////////////
 // Type nodes //
 ////////////////
 
-Object * NType::eval(Scope * scope) {
-	// Note: There must be no case when is base NType Node used, so just return nullptr,
+Value NType::eval(Scope * scope) {
+	// Note: There must be no case when is base NType Node used, so just return null,
 	// but maybe catch an error in the future on Parser level or on this level
-	return nullptr;
+	return Value::null();
 }
 
-Object * NIdentifierType::eval(Scope * scope) {
-	// TODO: ??? WHATT ??? How to use it???
+// Note: Types are not checked at runtime yet, so type nodes have no value
+Value NIdentifierType::eval(Scope * scope) {
+	return Value::null();
 }
 
-Object * NTypeDecl::eval(Scope * scope) {
-	return scope->define_type(*this);
+Value NListType::eval(Scope * scope) {
+	return Value::null();
 }
 
+Value NTupleType::eval(Scope * scope) {
+	return Value::null();
+}
 
-Object * NVarDecl::eval(Scope * scope) {
-	// Note: Think about definitions and maybe it must be one define for everything
-	return scope->define_var(*this);
+Value NTypeDecl::eval(Scope * scope) {
+	return Value::null();
 }
 
-Object * NFuncCall::eval(Scope * scope) {
-	Func * func = dynamic_cast<Func*>(left.eval(scope));
-	if(!func){
-		// TODO: Add error catching `left cannot be used as function`
-		return nullptr;
-	}
-	return func->call(args);
+
+Value NVarDecl::eval(Scope * scope) {
+	scope->define(id.slot, assignment_expr ? assignment_expr->eval(scope) : Value::null());
+	return Value::null();
 }
 
-Object * NReturn::eval(Scope * scope) {
-	// TODO: Return function in function scope
+Value NArgDecl::eval(Scope * scope) {
+	// Note: Arguments are defined by function call
+	return Value::null();
 }
 
-Object * NFuncDecl::eval(Scope * scope) {
-	return scope->define_func(*this);
+static Value call(const Value & func, std::vector <Value> && args, const uint32_t & offset){
+	if(func.is(OT_NATIVE_FUNC)){
+		try{
+			return static_cast<NativeFunc*>(func.as_object())->function(args);
+		}catch(RuntimeError & e){
+			e.offset = offset;
+			throw;
+		}
+	}
+	if(!func.is(OT_FUNC)){
+		throw RuntimeError("Object of type " + type_name(func) + " is not callable", offset);
+	}
+
+	// Note: Default values of arguments can reach a safepoint
+	Root func_root(func);
+	Root args_root(args);
+	Func * callee = static_cast<Func*>(func.as_object());
+	const ArgList & params = callee->decl.args;
+	if(args.size() > params.size()){
+		throw RuntimeError("Too many arguments for " + callee->to_string(), offset);
+	}
+	if(call_depth == MAX_CALL_DEPTH){
+		throw RuntimeError("Stack overflow", offset);
+	}
+
+	// Note: Arguments are the first slots of function scope
+	Scope * func_scope = heap().make<Scope>(callee->closure, callee->decl.slot_count, true);
+	Root func_scope_root(func_scope);
+	for(size_t i = 0; i < params.size(); i++){
+		if(i < args.size()){
+			func_scope->set(i, args[i]);
+		}else if(params[i]->default_value){
+			func_scope->set(i, params[i]->default_value->eval(func_scope));
+		}else{
+			throw RuntimeError("Missing argument `" + std::string(symbol_str(params[i]->id.name)) + "` of " + callee->to_string(), offset);
+		}
+	}
+
+	call_depth++;
+	callee->decl.block.eval(func_scope);
+	call_depth--;
+
+	// Note: Function without `return` returns null
+	return func_scope->get_return_value();
 }
 
-Object * NListAccess::eval(Scope * scope) {
-	List * list = dynamic_cast<List*>(left.eval(scope));
-	if(!list){
-		// TODO: Add error catching `left cannot be accessed as list`
-		return nullptr;
+Value NFuncCall::eval(Scope * scope) {
+	const Value func = left.eval(scope);
+	Root func_root(func);
+	std::vector <Value> arg_values;
+	Root arg_values_root(arg_values);
+	arg_values.reserve(args.size());
+	for(NExpression * arg : args){
+		arg_values.push_back(arg->eval(scope));
 	}
-	// TODO: Think about __getitem__ or equivalent instead
-	return list->access(access.eval(scope));
+	return call(func, std::move(arg_values), offset);
 }
 
-Object * NList::eval(Scope * scope) {
-	return new List(*this);
+Value NReturn::eval(Scope * scope) {
+	scope->set_return(right ? right->eval(scope) : Value::null());
+	return Value::null();
+}
+
+Value NFuncDecl::eval(Scope * scope) {
+	scope->define(id.slot, Value::object(heap().make<Func>(*this, scope)));
+	return Value::null();
+}
+
+Value NListAccess::eval(Scope * scope) {
+	const Value object = left.eval(scope);
+	Root object_root(object);
+	return get_item(object, access.eval(scope), offset);
+}
+
+Value NList::eval(Scope * scope) {
+	std::vector <Value> items;
+	Root items_root(items);
+	items.reserve(expressions.size());
+	for(NExpression * expr : expressions){
+		items.push_back(expr->eval(scope));
+	}
+	return Value::object(heap().make<List>(std::move(items)));
 }
 
-Object * NCondition::eval(Scope * scope) {
-	if(If.first->eval(scope)->toBool()){
+Value NCondition::eval(Scope * scope) {
+	if(If.first->eval(scope).to_bool()){
 		return If.second->eval(scope);
 	}
 
 	for(const auto & Elif : Elifs){
-		if(Elif.first->eval(scope)->toBool()){
+		if(Elif.first->eval(scope).to_bool()){
 			return Elif.second->eval(scope);
 		}
 	}
 
-	return Else->eval(scope);
+	return Else ? Else->eval(scope) : Value::null();
 }
 
-Object * NWhile::eval(Scope * scope) {
-	while(condition.eval(scope)->toBool()){
+Value NWhile::eval(Scope * scope) {
+	while(condition.eval(scope).to_bool()){
 		block.eval(scope);
+		if(scope->is_returned()){
+			break;
+		}
 	}
 
-	return nullptr;
+	return Value::null();
 }
 
+Value NFor::eval(Scope * scope) {
+	const Value iterable = In.eval(scope);
+	Root iterable_root(iterable);
+	if(!iterable.is(OT_LIST) && !iterable.is(OT_STRING)){
+		throw RuntimeError("Object of type " + type_name(iterable) + " is not iterable", offset);
+	}
 
-// aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa..........
+	// Note: List can be changed by the loop, so size is checked on each iteration
+	for(size_t i = 0; ; i++){
+		Value item;
+		if(iterable.is(OT_LIST)){
+			const std::vector <Value> & items = static_cast<List*>(iterable.as_object())->items;
+			if(i >= items.size()){
+				break;
+			}
+			item = items[i];
+		}else{
+			const std::string & str = static_cast<String*>(iterable.as_object())->value;
+			if(i >= str.size()){
+				break;
+			}
+			item = Value::object(char_string(str[i]));
+		}
 
-Object * NFor::eval(Scope * scope) {
+		Scope * loop_scope = heap().make<Scope>(scope, slot_count);
+		loop_scope->set(For.slot, item);
+		block.eval(loop_scope);
+		if(scope->is_returned()){
+			break;
+		}
+	}
 
+	return Value::null();
 }
 
-Object * NMatch::eval(Scope * scope) {
+Value NMatch::eval(Scope * scope) {
+	const Value value = expression.eval(scope);
+	Root value_root(value);
+	for(const MatchCase & Case : Cases){
+		for(NExpression * pattern : Case.first){
+			if(call_infix(value, OP_EQUAL, pattern->eval(scope), offset).to_bool()){
+				Case.second->eval(scope);
+				return Value::null();
+			}
+		}
+	}
+	if(Else){
+		Else->eval(scope);
+	}
+	return Value::null();
+}
+
+//////////////
+// Children //
+//////////////
+
+void NExpressionStatement::get_children(std::vector <Node*> & children){
+	children.push_back(&expression);
+}
+
+void NBlock::get_children(std::vector <Node*> & children){
+	children.insert(children.end(), statements.begin(), statements.end());
+}
+
+void NInfixOp::get_children(std::vector <Node*> & children){
+	children.push_back(&left);
+	children.push_back(&right);
+}
+
+void NPrefixOp::get_children(std::vector <Node*> & children){
+	children.push_back(&right);
+}
+
+void NPostfixOp::get_children(std::vector <Node*> & children){
+	children.push_back(&left);
+}
+
+void NIdentifierType::get_children(std::vector <Node*> & children){
+	children.push_back(&id);
+}
+
+void NListType::get_children(std::vector <Node*> & children){
+	children.push_back(&wrapped_type);
+}
+
+void NTupleType::get_children(std::vector <Node*> & children){
+	children.insert(children.end(), types.begin(), types.end());
+}
+
+void NTypeDecl::get_children(std::vector <Node*> & children){
+	children.push_back(&id);
+	children.push_back(&type);
+}
 
-}
\ No newline at end of file
+void NVarDecl::get_children(std::vector <Node*> & children){
+	children.push_back(&id);
+	if(type){
+		children.push_back(type);
+	}
+	if(assignment_expr){
+		children.push_back(assignment_expr);
+	}
+}
+
+void NArgDecl::get_children(std::vector <Node*> & children){
+	children.push_back(&id);
+	if(type){
+		children.push_back(type);
+	}
+	if(default_value){
+		children.push_back(default_value);
+	}
+}
+
+void NFuncCall::get_children(std::vector <Node*> & children){
+	children.push_back(&left);
+	children.insert(children.end(), args.begin(), args.end());
+}
+
+void NReturn::get_children(std::vector <Node*> & children){
+	if(right){
+		children.push_back(right);
+	}
+}
+
+void NFuncDecl::get_children(std::vector <Node*> & children){
+	children.push_back(&id);
+	children.insert(children.end(), args.begin(), args.end());
+	if(return_type){
+		children.push_back(return_type);
+	}
+	children.push_back(&block);
+}
+
+void NListAccess::get_children(std::vector <Node*> & children){
+	children.push_back(&left);
+	children.push_back(&access);
+}
+
+void NList::get_children(std::vector <Node*> & children){
+	children.insert(children.end(), expressions.begin(), expressions.end());
+}
+
+void NCondition::get_children(std::vector <Node*> & children){
+	children.push_back(If.first);
+	children.push_back(If.second);
+	for(const ConditionBlock & Elif : Elifs){
+		children.push_back(Elif.first);
+		children.push_back(Elif.second);
+	}
+	if(Else){
+		children.push_back(Else);
+	}
+}
+
+void NWhile::get_children(std::vector <Node*> & children){
+	children.push_back(&condition);
+	children.push_back(&block);
+}
+
+void NFor::get_children(std::vector <Node*> & children){
+	children.push_back(&For);
+	children.push_back(&In);
+	children.push_back(&block);
+}
+
+void NMatch::get_children(std::vector <Node*> & children){
+	children.push_back(&expression);
+	for(const MatchCase & Case : Cases){
+		children.insert(children.end(), Case.first.begin(), Case.first.end());
+		children.push_back(Case.second);
+	}
+	if(Else){
+		children.push_back(Else);
+	}
+}
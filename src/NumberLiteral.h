@@ -0,0 +1,96 @@
+#ifndef NUMBERLITERAL_H
+#define NUMBERLITERAL_H
+
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+
+// Number literals are converted in place from their code span with std::from_chars.
+// Literal can have `-` sign, `0x`/`0b` prefix and `_` separators, digits are copied
+// to stack buffer without prefix and separators, so conversion never allocates.
+
+enum NumberStatus {
+	NUM_OK,
+	NUM_INVALID,
+	NUM_OUT_OF_RANGE,
+	NUM_TOO_LONG
+};
+
+// Note: Limit for digits count without separators
+const uint32_t NUMBER_MAX_LENGTH = 128;
+
+// Returns false if literal is too long
+inline bool number_digits(std::string_view str, char * buffer, uint32_t & length, int & base){
+	uint32_t i = 0;
+	length = 0;
+	base = 10;
+
+	if(i < str.size() && str[i] == '-'){
+		buffer[length++] = '-';
+		i++;
+	}
+
+	if(i + 1 < str.size() && str[i] == '0'){
+		const char prefix = str[i + 1] | 0x20;
+		if(prefix == 'x'){
+			base = 16;
+			i += 2;
+		}else if(prefix == 'b'){
+			base = 2;
+			i += 2;
+		}
+	}
+
+	for(; i < str.size(); i++){
+		if(str[i] == '_'){
+			continue;
+		}
+		if(length == NUMBER_MAX_LENGTH){
+			return false;
+		}
+		buffer[length++] = str[i];
+	}
+
+	return true;
+}
+
+inline NumberStatus parse_int_literal(std::string_view str, int64_t & value){
+	char buffer[NUMBER_MAX_LENGTH];
+	uint32_t length;
+	int base;
+	if(!number_digits(str, buffer, length, base)){
+		return NUM_TOO_LONG;
+	}
+
+	const auto result = std::from_chars(buffer, buffer + length, value, base);
+	if(result.ec == std::errc::result_out_of_range){
+		return NUM_OUT_OF_RANGE;
+	}
+	if(result.ec != std::errc() || result.ptr != buffer + length){
+		return NUM_INVALID;
+	}
+	return NUM_OK;
+}
+
+inline NumberStatus parse_float_literal(std::string_view str, double & value){
+	char buffer[NUMBER_MAX_LENGTH];
+	uint32_t length;
+	int base;
+	if(!number_digits(str, buffer, length, base)){
+		return NUM_TOO_LONG;
+	}
+	if(base != 10){
+		return NUM_INVALID;
+	}
+
+	const auto result = std::from_chars(buffer, buffer + length, value);
+	if(result.ec == std::errc::result_out_of_range){
+		return NUM_OUT_OF_RANGE;
+	}
+	if(result.ec != std::errc() || result.ptr != buffer + length){
+		return NUM_INVALID;
+	}
+	return NUM_OK;
+}
+
+#endif
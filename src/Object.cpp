@@ -0,0 +1,664 @@
+#include "Object.h"
+#include "Node.h"
+
+#include <cmath>
+#include <charconv>
+#include <iostream>
+
+///////////
+// Scope //
+///////////
+
+Scope::Scope(Scope * parent, const uint32_t & size, const bool & is_function){
+	this->parent = parent;
+	frame = is_function || !parent ? this : parent->frame;
+	returned = false;
+	slots.assign(size, Value::null());
+	if(!parent){
+		defined.assign(size, 0);
+	}
+}
+
+void Scope::trace(Heap & heap){
+	if(parent){
+		heap.mark(parent);
+	}
+	heap.mark(frame);
+	heap.mark(slots.data(), slots.data() + slots.size());
+	heap.mark(return_value);
+}
+
+///////////
+// Value //
+///////////
+
+Value Value::big_integer(const int64_t & value){
+	return object(heap().make<Int>(value));
+}
+
+std::string Value::to_string() const {
+	if(is_object()){
+		return as_object()->to_string();
+	}
+	if(is_small_int()){
+		return std::to_string(as_small_int());
+	}
+	if(is_float()){
+		// Note: Shortest representation that reads back to the same value, `1` is printed as `1.0`
+		char chars[32];
+		const auto result = std::to_chars(chars, chars + sizeof(chars), as_float());
+		std::string str(chars, result.ptr);
+		if(str.find_first_of(".ena") == std::string::npos){
+			str += ".0";
+		}
+		return str;
+	}
+	if(is_bool()){
+		return as_bool() ? "true" : "false";
+	}
+	return "null";
+}
+
+std::string type_name(const Value & value){
+	switch(value.type()){
+		case OT_NULL: return "null";
+		case OT_INT: return "int";
+		case OT_FLOAT: return "float";
+		case OT_BOOL: return "bool";
+		case OT_STRING: return "string";
+		case OT_LIST: return "list";
+		default: return "func";
+	}
+}
+
+/////////////////////
+// Operator tables //
+/////////////////////
+
+typedef std::initializer_list <std::pair<Operator, OperatorFunc>> OperatorList;
+
+// Note: Every value has `==`, `!=` (by identity) and `!`, functions of type replace them
+static OperatorTable make_operators(OperatorList infix, OperatorList prefix){
+	OperatorTable table {};
+	table.infix[OP_EQUAL] = [](const Value & self, const Value & arg){
+		return Value::boolean(self == arg);
+	};
+	table.infix[OP_NOT_EQUAL] = [](const Value & self, const Value & arg){
+		return Value::boolean(self != arg);
+	};
+	table.prefix[OP_NOT] = [](const Value & self, const Value &){
+		return Value::boolean(!self.to_bool());
+	};
+	for(const auto & [op, func] : infix){
+		table.infix[op] = func;
+	}
+	for(const auto & [op, func] : prefix){
+		table.prefix[op] = func;
+	}
+	return table;
+}
+
+// Note: null supports only `==`, `!=` and `!`, as functions do
+static const OperatorTable base_operators = make_operators({}, {});
+
+/////////////
+// Numbers //
+/////////////
+
+// Note: Int and float share operator table, int operator int is int, otherwise it's float
+
+template <class IntOp, class FloatOp>
+static Value arithmetic(const Value & self, const Value & arg, IntOp int_op, FloatOp float_op){
+	if(!arg.is_number()){
+		return Value::undefined();
+	}
+	if(self.is_int() && arg.is_int()){
+		return int_op(self.as_int(), arg.as_int());
+	}
+	return float_op(self.as_number(), arg.as_number());
+}
+
+template <class Compare>
+static Value compare(const Value & self, const Value & arg, Compare cmp){
+	return arithmetic(self, arg,
+		[&](int64_t a, int64_t b){ return Value::boolean(cmp(a, b)); },
+		[&](double a, double b){ return Value::boolean(cmp(a, b)); });
+}
+
+template <class IntOp>
+static Value int_only(const Value & self, const Value & arg, IntOp int_op){
+	if(!self.is_int() || !arg.is_int()){
+		return Value::undefined();
+	}
+	return int_op(self.as_int(), arg.as_int());
+}
+
+// Note: Int overflow wraps around
+static int64_t wrap(const uint64_t & value){
+	return static_cast<int64_t>(value);
+}
+
+static Value make_range(int64_t from, int64_t to){
+	std::vector <Value> items;
+	if(to > from){
+		items.reserve(to - from);
+	}
+	for(int64_t i = from; i < to; i++){
+		items.push_back(Value::integer(i));
+	}
+	return Value::object(heap().make<List>(std::move(items)));
+}
+
+static const OperatorTable number_operators = make_operators({
+	{OP_ADD, [](const Value & self, const Value & arg){
+		return arithmetic(self, arg,
+			[](int64_t a, int64_t b){ return Value::integer(wrap(static_cast<uint64_t>(a) + b)); },
+			[](double a, double b){ return Value::number(a + b); });
+	}},
+	{OP_SUB, [](const Value & self, const Value & arg){
+		return arithmetic(self, arg,
+			[](int64_t a, int64_t b){ return Value::integer(wrap(static_cast<uint64_t>(a) - b)); },
+			[](double a, double b){ return Value::number(a - b); });
+	}},
+	{OP_MUL, [](const Value & self, const Value & arg){
+		return arithmetic(self, arg,
+			[](int64_t a, int64_t b){ return Value::integer(wrap(static_cast<uint64_t>(a) * b)); },
+			[](double a, double b){ return Value::number(a * b); });
+	}},
+	{OP_DIV, [](const Value & self, const Value & arg){
+		return arithmetic(self, arg,
+			[](int64_t a, int64_t b){
+				if(b == 0){
+					throw RuntimeError("Division by zero");
+				}
+				return Value::integer(b == -1 ? wrap(0 - static_cast<uint64_t>(a)) : a / b);
+			},
+			[](double a, double b){ return Value::number(a / b); });
+	}},
+	{OP_MOD, [](const Value & self, const Value & arg){
+		return arithmetic(self, arg,
+			[](int64_t a, int64_t b){
+				if(b == 0){
+					throw RuntimeError("Division by zero");
+				}
+				return Value::integer(b == -1 ? 0 : a % b);
+			},
+			[](double a, double b){ return Value::number(std::fmod(a, b)); });
+	}},
+	{OP_EXP, [](const Value & self, const Value & arg){
+		return arithmetic(self, arg,
+			[](int64_t a, int64_t b){
+				if(b < 0){
+					return Value::number(std::pow(static_cast<double>(a), static_cast<double>(b)));
+				}
+				uint64_t result = 1;
+				uint64_t base = a;
+				while(b){
+					if(b & 1){
+						result *= base;
+					}
+					base *= base;
+					b >>= 1;
+				}
+				return Value::integer(wrap(result));
+			},
+			[](double a, double b){ return Value::number(std::pow(a, b)); });
+	}},
+	{OP_EQUAL, [](const Value & self, const Value & arg){
+		if(!arg.is_number()){
+			return Value::boolean(false);
+		}
+		return compare(self, arg, [](auto a, auto b){ return a == b; });
+	}},
+	{OP_NOT_EQUAL, [](const Value & self, const Value & arg){
+		if(!arg.is_number()){
+			return Value::boolean(true);
+		}
+		return compare(self, arg, [](auto a, auto b){ return a != b; });
+	}},
+	{OP_LESS, [](const Value & self, const Value & arg){
+		return compare(self, arg, [](auto a, auto b){ return a < b; });
+	}},
+	{OP_LESS_EQUAL, [](const Value & self, const Value & arg){
+		return compare(self, arg, [](auto a, auto b){ return a <= b; });
+	}},
+	{OP_GREATER, [](const Value & self, const Value & arg){
+		return compare(self, arg, [](auto a, auto b){ return a > b; });
+	}},
+	{OP_GREATER_EQUAL, [](const Value & self, const Value & arg){
+		return compare(self, arg, [](auto a, auto b){ return a >= b; });
+	}},
+	{OP_SPACESHIP, [](const Value & self, const Value & arg){
+		return arithmetic(self, arg,
+			[](int64_t a, int64_t b){ return Value::integer((a > b) - (a < b)); },
+			[](double a, double b){ return Value::integer((a > b) - (a < b)); });
+	}},
+	{OP_BIT_OR, [](const Value & self, const Value & arg){
+		return int_only(self, arg, [](int64_t a, int64_t b){ return Value::integer(a | b); });
+	}},
+	{OP_BIT_XOR, [](const Value & self, const Value & arg){
+		return int_only(self, arg, [](int64_t a, int64_t b){ return Value::integer(a ^ b); });
+	}},
+	{OP_BIT_AND, [](const Value & self, const Value & arg){
+		return int_only(self, arg, [](int64_t a, int64_t b){ return Value::integer(a & b); });
+	}},
+	{OP_SHIFT_LEFT, [](const Value & self, const Value & arg){
+		return int_only(self, arg, [](int64_t a, int64_t b){ return Value::integer(wrap(static_cast<uint64_t>(a) << (b & 63))); });
+	}},
+	{OP_SHIFT_RIGHT, [](const Value & self, const Value & arg){
+		return int_only(self, arg, [](int64_t a, int64_t b){ return Value::integer(a >> (b & 63)); });
+	}},
+	{OP_RANGE, [](const Value & self, const Value & arg){
+		return int_only(self, arg, [](int64_t a, int64_t b){ return make_range(a, b); });
+	}},
+	{OP_RANGE_INCL, [](const Value & self, const Value & arg){
+		return int_only(self, arg, [](int64_t a, int64_t b){ return make_range(a, b + 1); });
+	}}
+}, {
+	{OP_ADD, [](const Value & self, const Value &){
+		return self;
+	}},
+	{OP_SUB, [](const Value & self, const Value &){
+		if(self.is_int()){
+			return Value::integer(wrap(0 - static_cast<uint64_t>(self.as_int())));
+		}
+		return Value::number(-self.as_float());
+	}},
+	{OP_INC, [](const Value & self, const Value &){
+		if(self.is_int()){
+			return Value::integer(wrap(static_cast<uint64_t>(self.as_int()) + 1));
+		}
+		return Value::number(self.as_float() + 1);
+	}},
+	{OP_DEC, [](const Value & self, const Value &){
+		if(self.is_int()){
+			return Value::integer(wrap(static_cast<uint64_t>(self.as_int()) - 1));
+		}
+		return Value::number(self.as_float() - 1);
+	}},
+	{OP_BIT_INVERT, [](const Value & self, const Value &){
+		if(!self.is_int()){
+			return Value::undefined();
+		}
+		return Value::integer(~self.as_int());
+	}}
+});
+
+//////////
+// Bool //
+//////////
+
+static const OperatorTable bool_operators = make_operators({
+	{OP_BIT_AND, [](const Value & self, const Value & arg){
+		if(!arg.is_bool()){
+			return Value::undefined();
+		}
+		return Value::boolean(self.as_bool() && arg.as_bool());
+	}},
+	{OP_BIT_OR, [](const Value & self, const Value & arg){
+		if(!arg.is_bool()){
+			return Value::undefined();
+		}
+		return Value::boolean(self.as_bool() || arg.as_bool());
+	}},
+	{OP_BIT_XOR, [](const Value & self, const Value & arg){
+		if(!arg.is_bool()){
+			return Value::undefined();
+		}
+		return Value::boolean(self.as_bool() != arg.as_bool());
+	}}
+}, {});
+
+////////////
+// String //
+////////////
+
+static const std::string & as_string(const Value & value){
+	return static_cast<String*>(value.as_object())->value;
+}
+
+// Note: Cached strings are permanent, they're created by `new`
+String * symbol_string(const Symbol & symbol){
+	static std::unordered_map <Symbol, String*> strings;
+	String *& str = strings[symbol];
+	if(!str){
+		str = new String(std::string(symbol_str(symbol)));
+	}
+	return str;
+}
+
+String * char_string(const char & c){
+	static String * strings[256] = {};
+	String *& str = strings[static_cast<unsigned char>(c)];
+	if(!str){
+		str = new String(std::string(1, c));
+	}
+	return str;
+}
+
+template <class Compare>
+static Value compare_strings(const Value & self, const Value & arg, Compare cmp){
+	if(!arg.is(OT_STRING)){
+		return Value::undefined();
+	}
+	return Value::boolean(cmp(as_string(self).compare(as_string(arg)), 0));
+}
+
+static const OperatorTable string_operators = make_operators({
+	{OP_ADD, [](const Value & self, const Value & arg){
+		if(!arg.is(OT_STRING)){
+			return Value::undefined();
+		}
+		return Value::object(heap().make<String>(as_string(self) + as_string(arg)));
+	}},
+	{OP_MUL, [](const Value & self, const Value & arg){
+		if(!arg.is_int()){
+			return Value::undefined();
+		}
+		std::string str;
+		for(int64_t i = 0; i < arg.as_int(); i++){
+			str += as_string(self);
+		}
+		return Value::object(heap().make<String>(str));
+	}},
+	{OP_EQUAL, [](const Value & self, const Value & arg){
+		return Value::boolean(arg.is(OT_STRING) && as_string(self) == as_string(arg));
+	}},
+	{OP_NOT_EQUAL, [](const Value & self, const Value & arg){
+		return Value::boolean(!arg.is(OT_STRING) || as_string(self) != as_string(arg));
+	}},
+	{OP_LESS, [](const Value & self, const Value & arg){
+		return compare_strings(self, arg, [](int a, int b){ return a < b; });
+	}},
+	{OP_LESS_EQUAL, [](const Value & self, const Value & arg){
+		return compare_strings(self, arg, [](int a, int b){ return a <= b; });
+	}},
+	{OP_GREATER, [](const Value & self, const Value & arg){
+		return compare_strings(self, arg, [](int a, int b){ return a > b; });
+	}},
+	{OP_GREATER_EQUAL, [](const Value & self, const Value & arg){
+		return compare_strings(self, arg, [](int a, int b){ return a >= b; });
+	}},
+	{OP_SPACESHIP, [](const Value & self, const Value & arg){
+		if(!arg.is(OT_STRING)){
+			return Value::undefined();
+		}
+		const int result = as_string(self).compare(as_string(arg));
+		return Value::integer((result > 0) - (result < 0));
+	}},
+	{OP_IN, [](const Value & self, const Value & arg){
+		if(!arg.is(OT_STRING)){
+			return Value::undefined();
+		}
+		return Value::boolean(as_string(self).find(as_string(arg)) != std::string::npos);
+	}}
+}, {});
+
+//////////
+// List //
+//////////
+
+static const OperatorTable list_operators = make_operators({
+	{OP_ADD, [](const Value & self, const Value & arg){
+		if(!arg.is(OT_LIST)){
+			return Value::undefined();
+		}
+		std::vector <Value> items = static_cast<List*>(self.as_object())->items;
+		const std::vector <Value> & right = static_cast<List*>(arg.as_object())->items;
+		items.insert(items.end(), right.begin(), right.end());
+		return Value::object(heap().make<List>(std::move(items)));
+	}},
+	{OP_IN, [](const Value & self, const Value & arg){
+		for(const Value & item : static_cast<List*>(self.as_object())->items){
+			if(call_infix(item, OP_EQUAL, arg, NO_OFFSET).to_bool()){
+				return Value::boolean(true);
+			}
+		}
+		return Value::boolean(false);
+	}}
+}, {});
+
+std::string List::to_string(){
+	std::string str = "[";
+	for(size_t i = 0; i < items.size(); i++){
+		str += items[i].to_string();
+		if(i < items.size() - 1){
+			str += ", ";
+		}
+	}
+	return str + "]";
+}
+
+Value & List::at(const Value & index){
+	if(!index.is_int()){
+		throw RuntimeError("List index must be int, not " + type_name(index));
+	}
+	const int64_t i = index.as_int();
+	if(i < 0 || static_cast<uint64_t>(i) >= items.size()){
+		throw RuntimeError("Index " + std::to_string(i) + " is out of range of list of size " + std::to_string(items.size()));
+	}
+	return items[i];
+}
+
+const OperatorTable & operators_of(const ObjectType & type){
+	switch(type){
+		case OT_INT:
+		case OT_FLOAT: return number_operators;
+		case OT_BOOL: return bool_operators;
+		case OT_STRING: return string_operators;
+		case OT_LIST: return list_operators;
+		default: return base_operators;
+	}
+}
+
+///////////////
+// Functions //
+///////////////
+
+std::string Func::to_string(){
+	return "<func " + std::string(symbol_str(decl.id.name)) + ">";
+}
+
+static Value builtin_print(std::span <Value> args){
+	for(size_t i = 0; i < args.size(); i++){
+		if(i > 0){
+			std::cout << ' ';
+		}
+		std::cout << args[i].to_string();
+	}
+	std::cout << '\n';
+	return Value::null();
+}
+
+static Value builtin_len(std::span <Value> args){
+	if(args.size() != 1){
+		throw RuntimeError("`len` expects 1 argument");
+	}
+	if(args[0].is(OT_STRING)){
+		return Value::integer(as_string(args[0]).size());
+	}
+	if(args[0].is(OT_LIST)){
+		return Value::integer(static_cast<List*>(args[0].as_object())->items.size());
+	}
+	throw RuntimeError("Object of type " + type_name(args[0]) + " has no length");
+}
+
+static Value builtin_str(std::span <Value> args){
+	if(args.size() != 1){
+		throw RuntimeError("`str` expects 1 argument");
+	}
+	if(args[0].is(OT_STRING)){
+		return args[0];
+	}
+	return Value::object(heap().make<String>(args[0].to_string()));
+}
+
+const std::vector <NativeFunc*> & builtins(){
+	static const std::vector <NativeFunc*> functions {
+		new NativeFunc(intern("print"), builtin_print),
+		new NativeFunc(intern("len"), builtin_len),
+		new NativeFunc(intern("str"), builtin_str)
+	};
+	return functions;
+}
+
+///////////////
+// Operators //
+///////////////
+
+// Note: Operators like &&, || are not overloadable
+static bool is_infix_operator(const Operator & op){
+	switch(op){
+		case OP_BIT_OR: case OP_BIT_XOR: case OP_BIT_AND:
+		case OP_EQUAL: case OP_NOT_EQUAL:
+		case OP_LESS: case OP_LESS_EQUAL: case OP_GREATER: case OP_GREATER_EQUAL: case OP_SPACESHIP:
+		case OP_SHIFT_LEFT: case OP_SHIFT_RIGHT:
+		case OP_RANGE: case OP_RANGE_INCL:
+		case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD: case OP_EXP:
+		case OP_IN: case OP_NOT_IN: return true;
+		default: return false;
+	}
+}
+
+static bool is_prefix_operator(const Operator & op){
+	switch(op){
+		case OP_INC: case OP_DEC:
+		case OP_ADD: case OP_SUB:
+		case OP_NOT: case OP_BIT_INVERT: return true;
+		default: return false;
+	}
+}
+
+Operator augmented_operator(const Operator & op){
+	switch(op){
+		case OP_ASSIGN_ADD: return OP_ADD;
+		case OP_ASSIGN_SUB: return OP_SUB;
+		case OP_ASSIGN_MUL: return OP_MUL;
+		case OP_ASSIGN_DIV: return OP_DIV;
+		case OP_ASSIGN_MOD: return OP_MOD;
+		case OP_ASSIGN_EXP: return OP_EXP;
+		case OP_ASSIGN_BIT_AND: return OP_BIT_AND;
+		case OP_ASSIGN_BIT_OR: return OP_BIT_OR;
+		case OP_ASSIGN_BIT_XOR: return OP_BIT_XOR;
+		case OP_ASSIGN_SHIFT_LEFT: return OP_SHIFT_LEFT;
+		case OP_ASSIGN_SHIFT_RIGHT: return OP_SHIFT_RIGHT;
+		default: return op;
+	}
+}
+
+// Note: Operator without function is checked only on error, so supported operator costs one lookup
+template <class Lookup>
+static Value apply_infix(const Value & left, const Operator & op, const Value & right, const uint32_t & offset, Lookup lookup){
+	// Note: `a in b` is `b.in(a)`, `a !in b` is `!b.in(a)`
+	const bool swapped = op == OP_IN || op == OP_NOT_IN;
+	const Value & self = swapped ? right : left;
+	const Value & arg = swapped ? left : right;
+
+	const OperatorFunc func = lookup(self.type(), op == OP_NOT_IN ? OP_IN : op);
+	if(!func){
+		if(!is_infix_operator(op)){
+			throw RuntimeError("Operator `" + op_to_str(op) + "` is not supported", offset);
+		}
+		if(self.is_null()){
+			throw RuntimeError("Cannot apply operator `" + op_to_str(op) + "` to null", offset);
+		}
+	}
+
+	Value result = Value::undefined();
+	if(func){
+		try{
+			result = func(self, arg);
+		}catch(RuntimeError & e){
+			if(e.offset == NO_OFFSET){
+				e.offset = offset;
+			}
+			throw;
+		}
+	}
+
+	if(result.is_undefined()){
+		throw RuntimeError("Cannot apply operator `" + op_to_str(op) + "` to "
+						   + type_name(self) + " and " + type_name(arg), offset);
+	}
+
+	if(op == OP_NOT_IN){
+		return Value::boolean(!result.to_bool());
+	}
+	return result;
+}
+
+template <class Lookup>
+static Value apply_prefix(const Operator & op, const Value & right, const uint32_t & offset, Lookup lookup){
+	const OperatorFunc func = lookup(right.type(), op);
+	if(!func){
+		if(!is_prefix_operator(op)){
+			throw RuntimeError("Operator `" + op_to_str(op) + "` is not supported", offset);
+		}
+		if(right.is_null()){
+			throw RuntimeError("Cannot apply operator `" + op_to_str(op) + "` to null", offset);
+		}
+	}
+	const Value result = func ? func(right, Value::null()) : Value::undefined();
+	if(result.is_undefined()){
+		throw RuntimeError("Cannot apply operator `" + op_to_str(op) + "` to " + type_name(right), offset);
+	}
+	return result;
+}
+
+Value call_infix(const Value & left, const Operator & op, const Value & right, const uint32_t & offset){
+	return apply_infix(left, op, right, offset, [](const ObjectType & type, const Operator & op){
+		return operators_of(type).infix[op];
+	});
+}
+
+Value call_infix(const Value & left, const Operator & op, const Value & right, const uint32_t & offset, OperatorCache & cache){
+	return apply_infix(left, op, right, offset, [&](const ObjectType & type, const Operator & op){
+		return cache.infix(type, op);
+	});
+}
+
+Value call_prefix(const Operator & op, const Value & right, const uint32_t & offset){
+	return apply_prefix(op, right, offset, [](const ObjectType & type, const Operator & op){
+		return operators_of(type).prefix[op];
+	});
+}
+
+Value call_prefix(const Operator & op, const Value & right, const uint32_t & offset, OperatorCache & cache){
+	return apply_prefix(op, right, offset, [&](const ObjectType & type, const Operator & op){
+		return cache.prefix(type, op);
+	});
+}
+
+Value get_item(const Value & object, const Value & index, const uint32_t & offset){
+	try{
+		if(object.is(OT_LIST)){
+			return static_cast<List*>(object.as_object())->at(index);
+		}
+		if(object.is(OT_STRING)){
+			const std::string & str = as_string(object);
+			if(!index.is_int() || index.as_int() < 0 || static_cast<uint64_t>(index.as_int()) >= str.size()){
+				throw RuntimeError("Invalid index of string of size " + std::to_string(str.size()));
+			}
+			return Value::object(char_string(str[index.as_int()]));
+		}
+	}catch(RuntimeError & e){
+		e.offset = offset;
+		throw;
+	}
+	throw RuntimeError("Object of type " + type_name(object) + " cannot be accessed by index", offset);
+}
+
+Value set_item(const Value & object, const Value & index, const Value & value, const uint32_t & offset){
+	if(!object.is(OT_LIST)){
+		throw RuntimeError("Object of type " + type_name(object) + " does not support item assignment", offset);
+	}
+	try{
+		List * list = static_cast<List*>(object.as_object());
+		list->at(index) = value;
+		heap().write_barrier(list);
+		return value;
+	}catch(RuntimeError & e){
+		e.offset = offset;
+		throw;
+	}
+}
@@ -1,104 +1,101 @@
-#ifndef VALUE_H
-#define VALUE_H
+#ifndef OBJECT_H
+#define OBJECT_H
 
-/**
- * The objects storing in scope rules
- *
- * Functions:
- * example: func print(str: string): void {}
- * converted: "func_print(string)"
- * Note: function return type is cannot be overloaded so it doesn't matter for storing
- */
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <span>
+#include <cstdint>
 
+#include "Interner.h"
+#include "Token.h"
+#include "Value.h"
+#include "Heap.h"
 
 /**
- * get - get from THIS scope
- * define - var/val/func and etc. that defines new name in the scope
- * set - assignes (but not defines) the value to something
- * lookup - get the nearest scope where something exists
+ * Runtime objects shared by tree walker (`Node::eval`) and VM
+ *
+ * Values are passed as Value, null, bool, float and small int are stored in it,
+ * other values are heap objects.
+ * Operators are functions of type of left operand in its OperatorTable (see `operators_of`),
+ * function gets right operand as `arg` and prefix operator function gets null.
+ * Objects and scopes are cells of Heap, they're created by `heap().make` and traced by the collector.
  */
 
-class Object;
-class Var;
-class Func;
+struct NFuncDecl;
 
-class Scope {
+// Scope of tree walker holds variables in flat array of slots.
+// Slots of names are assigned by Resolver, so variable access is `up(depth)->slots[slot]`.
+// Note: Only the global scope tracks which slots are defined, because global can be used
+// (by function or before its declaration) when it's not defined yet.
+// Slots are written only by `set` and `define`, they keep write barrier of Heap
+class Scope : public Cell {
 	public:
-		Scope();
+		// Function scope is the frame of `return` for scopes of its blocks
+		Scope(Scope * parent, const uint32_t & size, const bool & is_function = false);
 		virtual ~Scope() = default;
 
-		Scope * get_parent();
+		virtual void trace(Heap & heap) override;
 
-		Var * get_var(const std::string & var_name){
-			if(locals.contains(var_name)){
-				return locals.at(var_name);
-			}else{
-				return nullptr;
-			}
-		}
+		std::vector <Value> slots;
+		std::vector <uint8_t> defined;
 
-		Var * define_var(const NVarDecl & var_decl){
-			// Note: Variable only needs a name of var, but not like a func where structure has sense
+		Scope * get_parent(){
+			return parent;
+		}
 
-			if(locals.contains(var_decl.id.name)){
-			}else{
-				// Note: Variables stores with "var_" prefix for var and val together
-				return locals[var_decl.id.name] = new Var(var_decl);
+		Scope * up(uint32_t depth){
+			Scope * scope = this;
+			while(depth--){
+				scope = scope->parent;
 			}
+			return scope;
 		}
 
-		// Func * get_func(const std::string & func_structure){
-		// 	if(locals.contains(func_structure)){
-		// 		return locals.at(func_structure);
-		// 	}else{
-		// 		return nullptr;
-		// 	}
-		// }
-
-		// Func * define_func(const NFuncDecl & func_decl){
-		// 	std::string func_structure = "func_";
-		// 	func_structure += func_decl.id.name;
+		void set(const uint32_t & slot, const Value & value){
+			slots[slot] = value;
+			heap().write_barrier(this);
+		}
+		void define(const uint32_t & slot, const Value & value){
+			set(slot, value);
+			if(!defined.empty()){
+				defined[slot] = 1;
+			}
+		}
+		bool is_defined(const uint32_t & slot) const {
+			return defined.empty() || defined[slot];
+		}
 
-		// 	func_structure += "(";
-		// 	for(NArgDecl * arg : func_decl.args){
-		// 		func_structure += arg.type->to_storage_structure();
-		// 	}
-		// 	func_structure += ")";
-		// }
+		// `return` stops evaluation of all blocks up to the function scope
+		void set_return(const Value & value){
+			frame->returned = true;
+			frame->return_value = value;
+			heap().write_barrier(frame);
+		}
+		bool is_returned() const {
+			return frame->returned;
+		}
+		Value get_return_value() const {
+			return frame->return_value;
+		}
 
 	private:
 		Scope * parent;
-
-		std::map <std::string, Object*> locals;
-
+		Scope * frame;
+		bool returned;
+		Value return_value;
 };
 
-/**
- * Thoughts
- *
- * All primitives are objects (classes)
- *
- * Classes must have:
- * - constructors
- * - fields:
- *   * var/val
- *   * functions
- * All classes inherit `any`
- * All primitives are lower-case (not like in Kotlin)
- *
- * The problems:
- * - How to implement functions extensions? How to store them and etc.
- */
-
 // Note: Object is not something like Object in Java
-// It's just a main class to project everything (var/val, func, objects and etc.)
+// It's just a main class to project everything (values, functions and etc.)
 
-class Object : Scope {
+class Object : public Cell {
 	public:
-		Object();
-
+		Object(const ObjectType & type) : type(type) {}
 		virtual ~Object() = default;
 
+		const ObjectType type;
+
 		//////////////////////
 		// Object functions //
 		//////////////////////
@@ -107,52 +104,215 @@ class Object : Scope {
 			return true;
 		}
 
-	private:
-
+		virtual std::string to_string() = 0;
 };
 
-class Func : Object {
+std::string type_name(const Value & value);
+
+// Int that doesn't fit in small int of Value
+class Int : public Object {
+	public:
+		Int(const int64_t & value) : Object(OT_INT), value(value) {}
+		virtual ~Int() = default;
+
+		const int64_t value;
 
+		virtual bool to_bool() override {
+			return value != 0;
+		}
+		virtual std::string to_string() override {
+			return std::to_string(value);
+		}
 };
 
-class Int : Object {
+// Note: String is immutable, so one object can be shared (e.g. by literal)
+class String : public Object {
 	public:
-		Int(NInt & value) : value(value) {}
+		String(const std::string & value) : Object(OT_STRING), value(value) {}
+		virtual ~String() = default;
 
-		virtual ~Int() = default;
+		const std::string value;
 
-	private:
-		NInt & value;
+		virtual bool to_bool() override {
+			return !value.empty();
+		}
+		virtual std::string to_string() override {
+			return value;
+		}
 };
 
-class Float : Object {
+// String object of interned string or of one char, it's created once
+String * symbol_string(const Symbol & symbol);
+String * char_string(const char & c);
+
+class List : public Object {
 	public:
-		Float(NFloat & value) : value(value) {}
+		List(std::vector <Value> && items) : Object(OT_LIST), items(std::move(items)) {}
+		virtual ~List() = default;
 
-		virtual ~Float() = default;
+		std::vector <Value> items;
 
-	private:
-		NFloat & value;
+		virtual bool to_bool() override {
+			return !items.empty();
+		}
+		virtual std::string to_string() override;
+
+		virtual void trace(Heap & heap) override {
+			heap.mark(items.data(), items.data() + items.size());
+		}
+
+		// Throws RuntimeError if index is not int or is out of range
+		Value & at(const Value & index);
 };
 
-class Bool : Object {
+// Function of tree walker, closure is the scope where function was declared
+class Func : public Object {
 	public:
-		Bool(NBool & value) : value(value) {}
+		Func(NFuncDecl & decl, Scope * closure) : Object(OT_FUNC), decl(decl), closure(closure) {}
+		virtual ~Func() = default;
 
-		virtual ~Bool() = default;
+		NFuncDecl & decl;
+		Scope * closure;
 
-	private:
-		NBool & value;
+		virtual std::string to_string() override;
+
+		virtual void trace(Heap & heap) override {
+			heap.mark(closure);
+		}
 };
 
-class String : Object {
+typedef Value (*NativeFunction)(std::span <Value> args);
+
+class NativeFunc : public Object {
 	public:
-		String(NString & value) : value(value) {}
+		NativeFunc(const Symbol & name, NativeFunction function) : Object(OT_NATIVE_FUNC), name(name), function(function) {}
+		virtual ~NativeFunc() = default;
 
-		virtual ~String() = default;
+		Symbol name;
+		NativeFunction function;
+
+		virtual std::string to_string() override {
+			return "<func " + std::string(symbol_str(name)) + ">";
+		}
+};
+
+// Builtin functions (`print`, `len`, `str`) that are defined in global scope
+const std::vector <NativeFunc*> & builtins();
+
+///////////
+// Value //
+///////////
+
+inline bool Value::is(const ObjectType & type) const {
+	return is_object() && as_object()->type == type;
+}
+
+inline bool Value::is_int() const {
+	return is_small_int() || is(OT_INT);
+}
+
+inline int64_t Value::as_int() const {
+	return is_small_int() ? as_small_int() : static_cast<Int*>(as_object())->value;
+}
+
+inline ObjectType Value::type() const {
+	if(is_object()){
+		return as_object()->type;
+	}
+	if(is_float()){
+		return OT_FLOAT;
+	}
+	if(is_small_int()){
+		return OT_INT;
+	}
+	return is_bool() ? OT_BOOL : OT_NULL;
+}
+
+inline bool Value::to_bool() const {
+	if(is_bool()){
+		return as_bool();
+	}
+	if(is_small_int()){
+		return as_small_int() != 0;
+	}
+	if(is_object()){
+		return as_object()->to_bool();
+	}
+	if(is_float()){
+		return as_float() != 0;
+	}
+	return false;
+}
+
+////////////////
+// Operators //
+////////////////
+
+// Note: Operator function returns undefined if it cannot be applied to `arg`
+typedef Value (*OperatorFunc)(const Value & self, const Value & arg);
+
+// Operator functions of type indexed by Operator, nullptr if type doesn't support operator
+// Note: `a in b` is `b.in(a)`, `!in` has no own function
+struct OperatorTable {
+	OperatorFunc infix[OP_COUNT];
+	OperatorFunc prefix[OP_COUNT];
+};
+
+const OperatorTable & operators_of(const ObjectType & type);
+
+// Inline cache of operator node (e.g. NInfixOp), it remembers operator function
+// for types of left operand seen by node, so repeated operator is found without table lookup.
+// Note: Operator of node never changes, so cache is keyed only by type.
+// If node sees more types than cache holds it's megamorphic and table is used for new types
+class OperatorCache {
+	public:
+		OperatorFunc infix(const ObjectType & type, const Operator & op){
+			for(uint8_t i = 0; i < count; i++){
+				if(types[i] == type){
+					return funcs[i];
+				}
+			}
+			return add(type, operators_of(type).infix[op]);
+		}
+		OperatorFunc prefix(const ObjectType & type, const Operator & op){
+			for(uint8_t i = 0; i < count; i++){
+				if(types[i] == type){
+					return funcs[i];
+				}
+			}
+			return add(type, operators_of(type).prefix[op]);
+		}
 
 	private:
-		NString & value;
+		static const uint8_t SIZE = 4;
+		ObjectType types[SIZE];
+		OperatorFunc funcs[SIZE];
+		uint8_t count = 0;
+
+		OperatorFunc add(const ObjectType & type, OperatorFunc func){
+			if(count < SIZE){
+				types[count] = type;
+				funcs[count] = func;
+				count++;
+			}
+			return func;
+		}
 };
 
-#endif
\ No newline at end of file
+// Operator of augmented assignment (e.g. OP_ADD for OP_ASSIGN_ADD), `op` itself for other operators
+Operator augmented_operator(const Operator & op);
+
+// Apply operator to evaluated operands, throws RuntimeError at `offset`
+// if operand does not support it
+// Note: `null` supports only `==` and `!=`
+Value call_infix(const Value & left, const Operator & op, const Value & right, const uint32_t & offset);
+Value call_prefix(const Operator & op, const Value & right, const uint32_t & offset);
+// Same with inline cache of operator node
+Value call_infix(const Value & left, const Operator & op, const Value & right, const uint32_t & offset, OperatorCache & cache);
+Value call_prefix(const Operator & op, const Value & right, const uint32_t & offset, OperatorCache & cache);
+
+// Value of `a[index]`, throws RuntimeError at `offset`
+Value get_item(const Value & object, const Value & index, const uint32_t & offset);
+Value set_item(const Value & object, const Value & index, const Value & value, const uint32_t & offset);
+
+#endif
@@ -0,0 +1,152 @@
+#include "ParallelLexer.h"
+
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <algorithm>
+
+ParallelLexer::ParallelLexer(const uint32_t & threads){
+	this->threads = threads;
+	if(this->threads == 0){
+		this->threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+}
+
+std::vector <Token> ParallelLexer::lex(const char * path){
+	source.open(path);
+	std::string_view code = source.view();
+
+	std::vector <Chunk> chunks = split(code);
+	lex_chunks(code, chunks);
+	return stitch(code, chunks);
+}
+
+std::vector <Token> ParallelLexer::lex(std::string_view code){
+	source.borrow(code);
+
+	std::vector <Chunk> chunks = split(code);
+	lex_chunks(code, chunks);
+	return stitch(code, chunks);
+}
+
+std::vector <ParallelLexer::Chunk> ParallelLexer::split(std::string_view code){
+	std::vector <Chunk> chunks;
+
+	// Note: More chunks than threads to balance load, chunks are not equal by tokens count
+	uint32_t chunks_count = std::min<uint64_t>(threads * 4, code.size() / MIN_CHUNK_SIZE);
+	if(threads == 1 || chunks_count < 2){
+		chunks_count = 1;
+	}
+
+	const uint32_t chunk_size = code.size() / chunks_count;
+
+	uint32_t begin = 0;
+	for(uint32_t i = 1; i <= chunks_count && begin < code.size(); i++){
+		uint32_t end = code.size();
+		if(i < chunks_count){
+			// Move border to the start of next line
+			const uint32_t target = std::max(begin, i * chunk_size);
+			const void * endl = std::memchr(code.data() + target, '\n', code.size() - target);
+			if(endl){
+				end = static_cast<const char*>(endl) - code.data() + 1;
+			}
+		}
+		chunks.push_back(Chunk{begin, end, begin, false, {}});
+		begin = end;
+	}
+
+	return chunks;
+}
+
+void ParallelLexer::lex_chunks(std::string_view code, std::vector <Chunk> & chunks){
+	std::atomic <uint32_t> next_chunk(0);
+
+	auto worker = [&](){
+		Lexer lexer;
+		uint32_t i;
+		while((i = next_chunk.fetch_add(1)) < chunks.size()){
+			Chunk & chunk = chunks[i];
+			// Approximately one token per 8 bytes of code
+			chunk.tokens.reserve((chunk.end - chunk.begin) / 8);
+			try{
+				chunk.lexed_end = lexer.lex_range(code, chunk.begin, chunk.end, chunk.tokens);
+			}catch(const std::exception & e){
+				// Speculation may start inside multi-line comment, the real error (if it is) is thrown on stitching
+				chunk.failed = true;
+			}
+		}
+	};
+
+	const uint32_t workers_count = std::min<uint32_t>(threads, chunks.size());
+	std::vector <std::thread> workers;
+	for(uint32_t i = 1; i < workers_count; i++){
+		workers.emplace_back(worker);
+	}
+	worker();
+	for(std::thread & w : workers){
+		w.join();
+	}
+}
+
+std::vector <Token> ParallelLexer::stitch(std::string_view code, std::vector <Chunk> & chunks){
+	size_t total = 0;
+	for(const Chunk & chunk : chunks){
+		total += chunk.tokens.size();
+	}
+
+	std::vector <Token> tokens;
+	tokens.reserve(total + 1);
+
+	// Offset where sequential lexer would be now
+	uint32_t index = 0;
+	Lexer lexer;
+
+	// Do not add endl token if previous was endl (as Lexer does)
+	auto append = [&](std::vector <Token>::iterator first, std::vector <Token>::iterator last){
+		if(first != last && first->type == T_ENDL && !tokens.empty() && tokens.back().type == T_ENDL){
+			first++;
+		}
+		tokens.insert(tokens.end(), first, last);
+	};
+
+	std::vector <Token> gap;
+	for(Chunk & chunk : chunks){
+		if(chunk.end <= index){
+			// Whole chunk is inside of the last token (e.g. comment)
+			continue;
+		}
+
+		auto first = chunk.tokens.begin();
+		if(chunk.failed){
+			// Speculation failed, re-lex from the real offset
+			chunk.tokens.clear();
+			chunk.lexed_end = lexer.lex_range(code, index, chunk.end, chunk.tokens);
+			first = chunk.tokens.begin();
+		}else if(chunk.begin != index){
+			// Previous chunk ended inside of this one, speculative tokens after the real offset are still valid
+			// if the real lexer stops exactly at start of one of them
+			first = std::lower_bound(chunk.tokens.begin(), chunk.tokens.end(), index, [](const Token & token, const uint32_t & offset){
+				return token.offset < offset;
+			});
+			const uint32_t resync = first == chunk.tokens.end() ? chunk.lexed_end : first->offset;
+			gap.clear();
+			if(index < resync && lexer.lex_range(code, index, resync, gap) != resync){
+				// Token of the real lexer crosses resync point (e.g. comment), re-lex the rest of chunk
+				gap.clear();
+				chunk.lexed_end = lexer.lex_range(code, index, chunk.end, gap);
+				first = chunk.tokens.end();
+			}
+			append(gap.begin(), gap.end());
+		}
+
+		append(first, chunk.tokens.end());
+		index = chunk.lexed_end;
+
+		// Free memory as soon as possible
+		std::vector <Token>().swap(chunk.tokens);
+	}
+
+	tokens.push_back(Token{T_PROG_END, static_cast<uint32_t>(code.size()), 0, 0});
+
+	return tokens;
+}
@@ -0,0 +1,54 @@
+#ifndef PARALLELLEXER_H
+#define PARALLELLEXER_H
+
+#include <vector>
+#include <string_view>
+
+#include "Lexer.h"
+
+// ParallelLexer lexes large code by chunks on several threads and stitches chunks tokens into one list.
+// Result is the same as `Lexer::lex` gives.
+//
+// Code is split at line starts. Every chunk is lexed speculatively as if nothing continues into it
+// from the previous chunk. While stitching, if previous chunk actually ended not at the chunk start
+// (multi-line `/* */` comment, `;` or endl run crossing the border), speculative tokens before the real
+// offset are dropped and the rest is reused from the first token the real lexer stops at. Only if speculative
+// lexing failed or no token boundary matches, the chunk is re-lexed from the real offset.
+// Lexer errors are thrown in code order as sequential lexer does.
+class ParallelLexer {
+	public:
+		// Note: 0 threads means hardware concurrency
+		ParallelLexer(const uint32_t & threads = 0);
+		virtual ~ParallelLexer() = default;
+
+		std::vector <Token> lex(const char * path);
+
+		// Lex caller-owned code, it must outlive tokens
+		std::vector <Token> lex(std::string_view code);
+
+		std::string_view get_code() const {
+			return source.view();
+		}
+
+		// Code smaller than this is lexed by one thread
+		static const uint32_t MIN_CHUNK_SIZE = 256 * 1024;
+
+	private:
+		Source source;
+		uint32_t threads;
+
+		struct Chunk {
+			uint32_t begin;
+			uint32_t end;
+			// Offset where lexing of chunk actually stopped
+			uint32_t lexed_end;
+			bool failed;
+			std::vector <Token> tokens;
+		};
+
+		std::vector <Chunk> split(std::string_view code);
+		void lex_chunks(std::string_view code, std::vector <Chunk> & chunks);
+		std::vector <Token> stitch(std::string_view code, std::vector <Chunk> & chunks);
+};
+
+#endif
@@ -0,0 +1,105 @@
+#include "ParallelParser.h"
+#include "StatementSplit.h"
+
+#include <thread>
+#include <atomic>
+#include <functional>
+
+ParallelParser::ParallelParser(const uint32_t & threads){
+	this->threads = threads;
+	if(this->threads == 0){
+		this->threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	for(uint32_t i = 0; i < this->threads; i++){
+		parsers.push_back(std::make_unique<Parser>());
+	}
+}
+
+StatementList ParallelParser::parse(const std::vector <Token> & tokens, std::string_view code){
+	for(auto & parser : parsers){
+		parser->clear();
+	}
+
+	// Note: `T_PROG_END` is not a part of statements, TokenVector returns it after the end
+	uint32_t count = tokens.size();
+	if(count > 0 && tokens[count - 1].type == T_PROG_END){
+		count--;
+	}
+
+	std::vector <Chunk> chunks = split(tokens, count);
+	if(chunks.size() == 1){
+		TokenVector source(std::span <const Token>(tokens.data(), count), code);
+		return parsers[0]->parse_more(source);
+	}
+	parse_chunks(tokens, code, chunks);
+
+	StatementList tree;
+	for(Chunk & chunk : chunks){
+		if(chunk.failed){
+			// Parse the rest sequentially, it throws the same error as Parser::parse
+			TokenVector rest(std::span <const Token>(tokens.data() + chunk.begin, count - chunk.begin), code);
+			StatementList statements = parsers[0]->parse_more(rest);
+			tree.insert(tree.end(), statements.begin(), statements.end());
+			break;
+		}
+		tree.insert(tree.end(), chunk.statements.begin(), chunk.statements.end());
+	}
+
+	return tree;
+}
+
+std::vector <ParallelParser::Chunk> ParallelParser::split(const std::vector <Token> & tokens, const uint32_t & count){
+	std::vector <Chunk> chunks;
+
+	// Note: More chunks than threads to balance load, statements are not equal by parsing time
+	uint32_t chunks_count = std::min<uint32_t>(threads * 4, count / MIN_CHUNK_TOKENS);
+	if(threads == 1 || chunks_count < 2){
+		chunks.push_back(Chunk{0, count, {}, false});
+		return chunks;
+	}
+
+	std::vector <uint32_t> ends;
+	if(!split_statements(std::span <const Token>(tokens.data(), count), nullptr, ends)){
+		ends.push_back(count);
+	}
+
+	// Cut chunk at the first statement end after its target size
+	const uint32_t chunk_size = count / chunks_count;
+	uint32_t begin = 0;
+	for(const uint32_t & end : ends){
+		if(end - begin >= chunk_size || end == ends.back()){
+			chunks.push_back(Chunk{begin, end, {}, false});
+			begin = end;
+		}
+	}
+
+	return chunks;
+}
+
+void ParallelParser::parse_chunks(const std::vector <Token> & tokens, std::string_view code, std::vector <Chunk> & chunks){
+	std::atomic <uint32_t> next_chunk(0);
+
+	auto worker = [&](Parser & parser){
+		uint32_t i;
+		while((i = next_chunk.fetch_add(1)) < chunks.size()){
+			Chunk & chunk = chunks[i];
+			TokenVector source(std::span <const Token>(tokens.data() + chunk.begin, chunk.end - chunk.begin), code);
+			try{
+				chunk.statements = parser.parse_more(source);
+			}catch(const std::exception & e){
+				// Error is thrown on sequential parsing of this chunk and the rest of code
+				chunk.failed = true;
+			}
+		}
+	};
+
+	const uint32_t workers_count = std::min<uint32_t>(threads, chunks.size());
+	std::vector <std::thread> workers;
+	for(uint32_t i = 1; i < workers_count; i++){
+		workers.emplace_back(worker, std::ref(*parsers[i]));
+	}
+	worker(*parsers[0]);
+	for(std::thread & w : workers){
+		w.join();
+	}
+}
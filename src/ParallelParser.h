@@ -0,0 +1,55 @@
+#ifndef PARALLELPARSER_H
+#define PARALLELPARSER_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Parser.h"
+
+// ParallelParser parses top-level statements of already lexed code on several threads.
+// Result is the same as `Parser::parse` gives.
+//
+// Top-level statement boundaries are found by `split_statements` pre-pass (brackets depth, `T_ENDL`, `;`),
+// statements are grouped into chunks and every chunk is parsed by worker with its own Parser,
+// so nodes are allocated in per-thread arenas. Statements of chunks are concatenated in code order.
+// If some chunk fails, code is parsed sequentially from the start of that chunk,
+// so the error (or tree, if split was wrong) is the same as sequential parser gives.
+// Note: Trees are freed on the next `parse`, as with Parser
+//
+// Note: Parsing is not claimed to be faster. Speedup against Parser with a given count of threads
+// is measured by bench/ParallelParse.cpp, it was only run on a single-core machine, where all thread counts
+// give the same tree and the same time (0.9-1.2x, noise), so multi-core scaling is not known.
+// Pre-pass takes ~20% of sequential parse time, so speedup is bounded by ~5x at most
+class ParallelParser {
+	public:
+		// Note: 0 threads means hardware concurrency
+		ParallelParser(const uint32_t & threads = 0);
+		virtual ~ParallelParser() = default;
+
+		// Parse tokens of caller-owned code (e.g. from `ParallelLexer::lex`), code must outlive the tree
+		StatementList parse(const std::vector <Token> & tokens, std::string_view code);
+
+		// Code with less tokens than this is parsed by one thread
+		static const uint32_t MIN_CHUNK_TOKENS = 16 * 1024;
+
+	private:
+		uint32_t threads;
+
+		// Parser per worker, they own nodes of the last tree
+		std::vector <std::unique_ptr<Parser>> parsers;
+
+		struct Chunk {
+			// Range of tokens
+			uint32_t begin;
+			uint32_t end;
+			StatementList statements;
+			bool failed;
+		};
+
+		std::vector <Chunk> split(const std::vector <Token> & tokens, const uint32_t & count);
+		void parse_chunks(const std::vector <Token> & tokens, std::string_view code, std::vector <Chunk> & chunks);
+};
+
+#endif
@@ -1,19 +1,24 @@
 #include "Parser.h"
 
-Parser::Parser(){
-	index = 0;
-}
+#include <algorithm>
+#include <bit>
 
-bool Parser::eof(){
-	return peek().type == T_PROG_END;
+Parser::Parser(){
+	code_lines = nullptr;
 }
 
-Token Parser::peek(){
-	return tokens[index];
+Position Parser::position(){
+	if(code_lines){
+		return code_lines->position(peek().offset);
+	}
+	if(!lines.is_built()){
+		lines.build(code);
+	}
+	return lines.position(peek().offset);
 }
 
-Token Parser::advance(){
-	return tokens[++index];
+bool Parser::eof(){
+	return peek().type == T_PROG_END;
 }
 
 // Recognizers
@@ -47,13 +52,13 @@ bool Parser::is_kw(const Keyword & kw){
 }
 
 bool Parser::is_infix_op(){
-	return is_op() && OP_INFIX_PREC.find(peek().op()) != OP_INFIX_PREC.end();
+	return is_op() && OP_INFIX_PREC[peek().op()].prec != 0;
 }
 bool Parser::is_prefix_op(){
-	return is_op() && OP_PREFIX_PREC.find(peek().op()) != OP_PREFIX_PREC.end();
+	return is_op() && OP_PREFIX_PREC[peek().op()].prec != 0;
 }
 bool Parser::is_postfix_op(){
-	return is_op() && OP_POSTFIX_PREC.find(peek().op()) != OP_POSTFIX_PREC.end();
+	return is_op() && OP_POSTFIX_PREC[peek().op()].prec != 0;
 }
 
 // Skippers
@@ -100,9 +105,59 @@ void Parser::skip_kw(const Keyword & kw, const bool & skip_left_endl, const bool
 	}
 }
 
+bool Parser::skip_endl_before_kw(const Keyword & kw){
+	// Note: Only the end of line is skipped, so the statement after `if` on the next line is not taken
+	if(!panic && is_endl()){
+		const Token & next = stream.peek(1);
+		if(next.type == T_KW && next.kw() == kw){
+			advance();
+		}
+	}
+	return is_kw(kw);
+}
+
+bool Parser::skip_nullable(){
+	if(is_op(OP_QUESTION_MARK)){
+		advance();
+		return true;
+	}
+	return false;
+}
+
+// Note: Expressions with side effects are not shared even if they're identical
+static bool is_pure_op(const Operator & op){
+	switch(op){
+		case OP_ASSIGN:
+		case OP_ASSIGN_ADD: case OP_ASSIGN_SUB: case OP_ASSIGN_MUL:
+		case OP_ASSIGN_DIV: case OP_ASSIGN_MOD: case OP_ASSIGN_EXP:
+		case OP_ASSIGN_BIT_AND: case OP_ASSIGN_BIT_OR:
+		case OP_ASSIGN_BIT_XOR: case OP_ASSIGN_SHIFT_LEFT: case OP_ASSIGN_SHIFT_RIGHT:
+		case OP_INC: case OP_DEC:
+		case OP_PIPELINE:{
+			return false;
+		}
+		default:{
+			return true;
+		}
+	}
+}
+
 // Errors
 void Parser::error(const std::string & msg){
-	err("Parser [ERROR]: " + msg, peek().pos.line, peek().pos.line);
+	if(panic){
+		// Note: Errors until synchronization are caused by the first one
+		return;
+	}
+
+	Position pos = position();
+	// Note: Thrown error is recorded too, so its offset is known to the caller
+	diagnostics.push_back(Diagnostic{"Parser [ERROR]: " + msg, peek().offset, pos.line, pos.column});
+	if(!recover){
+		throw Exception(diagnostics.back().to_string());
+	}
+
+	panic_token = Token{T_PROG_END, peek().offset, 0, 0};
+	panic = true;
 }
 void Parser::expected_error(const std::string & expected, const std::string & given){
 	error("Expected " + expected + ", " + given + " given");
@@ -113,20 +168,108 @@ void Parser::expected_error(const std::string & expected){
 	if(eof()){
 		given = "end of file";
 	}else{
-		given = peek().to_string();
+		given = peek().to_string(code);
 	}
 	expected_error(expected, given);
 }
 void Parser::unexpected_error(){
-	peek().unexpected_error();
+	error("Unexpected token " + peek().to_string(code));
+}
+
+void Parser::synchronize(const bool & in_block){
+	panic = false;
+
+	// Note: Brackets opened after the error are skipped with their content
+	uint32_t depth = 0;
+	while(!eof()){
+		const Token & token = peek();
+		if(token.type == T_OP){
+			switch(token.op()){
+				case OP_PAREN_L:
+				case OP_BRACKET_L:
+				case OP_BRACE_L:{
+					depth++;
+					break;
+				}
+				case OP_PAREN_R:
+				case OP_BRACKET_R:{
+					if(depth > 0){
+						depth--;
+					}
+					break;
+				}
+				case OP_BRACE_R:{
+					if(depth > 0){
+						depth--;
+						break;
+					}
+					if(!in_block){
+						// Stray `}` ends statement at top-level
+						advance();
+						optional_expr_end = true;
+					}
+					return;
+				}
+				default: break;
+			}
+		}
+		if(depth == 0 && is_expr_end()){
+			// Note: In block expression end is skipped by block loop
+			if(!in_block){
+				advance();
+			}
+			return;
+		}
+		advance();
+	}
+}
+
+StatementList Parser::parse(const std::vector <Token> & tokens, std::string_view code){
+	TokenVector source(tokens, code);
+	return parse(source);
+}
+
+StatementList Parser::parse(TokenSource & source){
+	// Note: Tree of previous parsing is freed at once
+	arena.clear();
+	shared_nodes.clear();
+	return parse_more(source);
 }
 
-StatementList Parser::parse(const std::vector <Token> & tokens){
-	this->tokens = tokens;
+void Parser::start(TokenSource & source, const LineIndex * code_lines){
+	stream.reset(&source);
+	code = source.get_code();
+	lines = LineIndex();
+	this->code_lines = code_lines;
+	tree.clear();
+
+	// Note: Previous parsing could stop on error in the middle of statement
+	optional_expr_end = false;
+	allow_func_call = false;
+	panic = false;
+	nesting = 0;
+	expr_stack.clear();
+	expr_items.clear();
+	diagnostics.clear();
+}
+
+NBlock * Parser::parse_more_block(TokenSource & source, const LineIndex * code_lines){
+	start(source, code_lines);
+	if(!is_op(OP_BRACE_L)){
+		return nullptr;
+	}
+	const size_t used = arena.used();
+	NBlock * block = parse_block();
+	return eof() && !panic && check_depth(block, used) ? block : nullptr;
+}
+
+StatementList Parser::parse_more(TokenSource & source, const LineIndex * code_lines){
+	start(source, code_lines);
 
 	while(!eof()){
+		const size_t used = arena.used();
 		NStatement * statement = parse_statement();
-		if(statement != nullptr){
+		if(statement != nullptr && check_depth(statement, used)){
 			tree.push_back(statement);
 		}
 		if(!eof()){
@@ -134,16 +277,77 @@ StatementList Parser::parse(const std::vector <Token> & tokens){
 			skip_expr_end(optional_expr_end);
 			optional_expr_end = false;
 		}
+		if(panic){
+			synchronize(false);
+		}
 	}
 
 	return tree;
 }
 
+// Note: Tree is walked by explicit stack, so depth is checked before recursive walks
+static uint32_t tree_depth(Node * root){
+	uint32_t max_depth = 0;
+	std::vector <std::pair<Node*, uint32_t>> stack {{root, 1}};
+	std::vector <Node*> children;
+	while(!stack.empty()){
+		const auto [node, depth] = stack.back();
+		stack.pop_back();
+		max_depth = std::max(max_depth, depth);
+		children.clear();
+		node->get_children(children);
+		for(Node * child : children){
+			if(child != nullptr){
+				stack.push_back({child, depth + 1});
+			}
+		}
+	}
+	return max_depth;
+}
+
+bool Parser::check_depth(Node * node, const size_t & used){
+	// Note: Each level of tree is a node of at least 16 bytes made for this tree, so small tree is not walked,
+	// but with hash-consing its nodes can be made by previous statements
+	if(panic || (!hash_consing && arena.used() - used < MAX_TREE_DEPTH * sizeof(Node))){
+		return true;
+	}
+	if(tree_depth(node) <= MAX_TREE_DEPTH){
+		return true;
+	}
+	error("Statement is nested too deep (more than " + std::to_string(MAX_TREE_DEPTH) + " levels)");
+	return false;
+}
+
+bool Parser::enter_nested(){
+	if(nesting >= MAX_TREE_DEPTH){
+		error("Code is nested too deep (more than " + std::to_string(MAX_TREE_DEPTH) + " levels)");
+		return false;
+	}
+	nesting++;
+	return true;
+}
+
+FlatTree Parser::parse_flat(TokenSource & source){
+	FlatTree flat;
+	for(NStatement * statement : parse(source)){
+		flat.add_root(statement->flatten(flat));
+	}
+
+	tree.clear();
+	arena.clear();
+	shared_nodes.clear();
+
+	return flat;
+}
+
 NStatement * Parser::parse_statement(){
-	if(is_expr_end()){
-		// Skip lines with expr_end only
+	// Skip lines with expr_end only
+	while(is_expr_end()){
 		advance();
-		return parse_statement();
+	}
+	// Note: Code can end with expr_end after comment (e.g. `a;\n// c\n`)
+	if(eof()){
+		return nullptr;
 	}
 	if(is_kw()){
 		switch(peek().kw()){
@@ -159,56 +363,154 @@ NStatement * Parser::parse_statement(){
 				return parse_func_decl();
 				break;
 			}
+			case KW_WHILE:{
+				return parse_while();
+			}
+			case KW_FOR:{
+				return parse_for();
+			}
 			case KW_MATCH:{
 				return parse_match();
 				break;
 			}
 			case KW_RETURN:{
-				Position pos = peek().pos;
+				const uint32_t offset = peek().offset;
 				advance();
 				NExpression * return_expr = nullptr;
 				if(!is_expr_end()){
 					return_expr = parse_expression();
 				}
-				return new NReturn(return_expr, pos);
+				return arena.make<NReturn>(return_expr, offset);
 			}
 		}
-	}else{
-		return new NExpressionStatement(*parse_expression(), peek().pos);
 	}
 
-	return nullptr;
+	// Note: `if` is an expression, so it's parsed as expression statement too
+	// Note: Offset is taken after the expression is parsed, arguments of `make` can be evaluated in any order
+	NExpression * expression = parse_expression();
+	return arena.make<NExpressionStatement>(*expression, peek().offset);
 }
 
+// Note: Expression is parsed by loop over explicit stack of frames instead of recursion:
+// expression is atom followed by calls, list accesses and infix operators,
+// each of them takes the whole expression before it as the left side.
+// Frame is unfinished construct waiting for its operand, every operand is expression,
+// except operands of infix and prefix operators that are atoms with calls and list accesses
+// (infix operators after them are taken by precedence).
+// Expression itself has no frame, so simple expressions (e.g. `a`, `1`) do not touch the stack.
 NExpression * Parser::parse_expression(){
-	NExpression * expression = parse_atom();
-	
-	while(!eof()){
+	const size_t base = expr_stack.size();
+	NExpression * value = nullptr;
+	// Next value is operand of infix or prefix operator
+	bool operand = false;
+	// Value can be continued with infix operator
+	bool chain = false;
+
+	while(true){
+		if(value == nullptr){
+			chain = !operand;
+			value = parse_atom(chain);
+			operand = value == nullptr && expr_stack.back().kind == EF_PREFIX;
+			continue;
+		}
+
 		// Check for chain of function call or list access or infix operator
 		if(is_op(OP_PAREN_L)){
-			expression = parse_func_call(expression);
-		}else if(is_op(OP_BRACKET_L)){
-			expression = parse_list_access(expression);
-		}else if(is_infix_op()){
-			expression = maybe_infix(expression, 0);
-		}else{
-			break;
+			const uint32_t offset = peek().offset;
+			skip_op(OP_PAREN_L, false, true);
+			expr_stack.push_back(ExprFrame{EF_CALL, {}, 0, chain, offset, value, static_cast<uint32_t>(expr_items.size())});
+			value = next_call_arg();
+			continue;
+		}
+		if(is_op(OP_BRACKET_L)){
+			const uint32_t offset = peek().offset;
+			skip_op(OP_BRACKET_L, false, true);
+			expr_stack.push_back(ExprFrame{EF_LIST_ACCESS, {}, 0, chain, offset, value});
+			value = nullptr;
+			continue;
+		}
+		if(chain && is_infix_op()){
+			expr_stack.push_back(ExprFrame{EF_INFIX, {}, 0, true, 0, value});
+			value = next_infix();
+			operand = value == nullptr;
+			continue;
 		}
-	}
 
-	return expression;
+		// Give operand to the top frame
+		if(expr_stack.size() == base){
+			return value;
+		}
+		ExprFrame & frame = expr_stack.back();
+		chain = frame.chain;
+		switch(frame.kind){
+			case EF_INFIX:{
+				if(frame.left == nullptr){
+					frame.left = value;
+				}else{
+					frame.left = make_node<NInfixOp>(is_pure_op(frame.op) && frame.left->shared && value->shared,
+													 [&]{ return NodeKey{NK_INFIX, static_cast<uint8_t>(frame.op), 0, frame.left, value}; },
+													 *frame.left, frame.op, *value, frame.offset);
+				}
+				value = next_infix();
+				operand = value == nullptr;
+				break;
+			}
+			case EF_PAREN:{
+				skip_op(OP_PAREN_R, true, false);
+				expr_stack.pop_back();
+				break;
+			}
+			case EF_LIST:{
+				expr_items.push_back(value);
+				value = next_list_item();
+				break;
+			}
+			case EF_PREFIX:{
+				value = make_node<NPrefixOp>(is_pure_op(frame.op) && value->shared,
+											 [&]{ return NodeKey{NK_PREFIX, static_cast<uint8_t>(frame.op), 0, value}; },
+											 frame.op, *value, frame.offset);
+				expr_stack.pop_back();
+				break;
+			}
+			case EF_CALL:{
+				expr_items.push_back(value);
+				if(eof()){
+					skip_expr_end();
+				}
+				if(!is_op(OP_PAREN_R)){
+					skip_op(OP_COMMA, true, true);
+				}
+				value = next_call_arg();
+				break;
+			}
+			case EF_LIST_ACCESS:{
+				skip_op(OP_BRACKET_R, true, false);
+				value = arena.make<NListAccess>(*frame.left, *value, frame.offset);
+				expr_stack.pop_back();
+				break;
+			}
+		}
+	}
 }
 
-NExpression * Parser::maybe_infix(NExpression * left, int prec){
+NExpression * Parser::next_infix(){
+	ExprFrame & frame = expr_stack.back();
 	if(is_infix_op()){
 		Operator op = peek().op();
-		int right_prec = OP_INFIX_PREC.at(op);
-		if(right_prec > prec){
-			Position pos;
+		const OpPrec & op_prec = OP_INFIX_PREC[op];
+		if(op_prec.prec > frame.prec){
+			// Note: Right operand of right-associative operator takes operators of the same precedence
+			const uint8_t right_prec = op_prec.assoc == ASSOC_RIGHT ? op_prec.prec - 1 : op_prec.prec;
+			frame.op = op;
+			frame.offset = peek().offset;
 			advance();
-			return maybe_infix(new NInfixOp(*left, op, *maybe_infix(parse_atom(), right_prec), pos), prec);
+			expr_stack.push_back(ExprFrame{EF_INFIX, {}, right_prec, false});
+			return nullptr;
 		}
 	}
+
+	NExpression * left = frame.left;
+	expr_stack.pop_back();
 	return left;
 }
 
@@ -224,21 +526,28 @@ NExpression * Parser::maybe_call(NExpression * left){
 NExpression * Parser::maybe_list_access(NExpression * left){
 	// if(is_op(OP_BRACKET_L)){
 	// 	NExpression * access = parse_expression();
-	// 	return new NListAccess(*left, *access);
+	// 	return arena.make<NListAccess>(*left, *access);
 	// }
 
 	return left;
 }
 
-NListAccess * Parser::parse_list_access(NExpression * left){
-	skip_op(OP_BRACKET_L, false, true);
-	NExpression * access = parse_expression();
-	skip_op(OP_BRACKET_R, true, false);
-
-	return new NListAccess(*left, *access);
+NExpression * Parser::next_list_item(){
+	ExprFrame & frame = expr_stack.back();
+	if(eof() || is_op(OP_BRACKET_R)){
+		skip_op(OP_BRACKET_R, true, false);
+		NList * list = arena.make<NList>(ExpressionList(expr_items.begin() + frame.items, expr_items.end()), frame.offset);
+		expr_items.resize(frame.items);
+		expr_stack.pop_back();
+		return list;
+	}
+	if(expr_items.size() > frame.items){
+		skip_op(OP_COMMA, true, true);
+	}
+	return nullptr;
 }
 
-NExpression * Parser::parse_atom(){
+NExpression * Parser::parse_atom(const bool & chain){
 
 	/*if(is_endl()){
 		// Skip end_of_line
@@ -248,17 +557,20 @@ NExpression * Parser::parse_atom(){
 
 	// Numbers
 	if(is_typeof(T_INT)){
-		NInt * num = new NInt(peek().Int());
+		const int64_t value = peek().Int(code);
+		NInt * num = make_node<NInt>(true, [&]{ return NodeKey{NK_INT, 0, static_cast<uint64_t>(value)}; }, value, peek().offset);
 		advance();
 		return num;
 	}
 	if(is_typeof(T_FLOAT)){
-		NFloat * num = new NFloat(peek().Float());
+		const double value = peek().Float(code);
+		NFloat * num = make_node<NFloat>(true, [&]{ return NodeKey{NK_FLOAT, 0, std::bit_cast<uint64_t>(value)}; }, value, peek().offset);
 		advance();
 		return num;
 	}
 	if(is_typeof(T_BOOL)){
-		NBool * num = new NBool(peek().Bool());
+		const bool value = peek().Bool();
+		NBool * num = make_node<NBool>(true, [&]{ return NodeKey{NK_BOOL, 0, value}; }, value, peek().offset);
 		advance();
 		return num;
 	}
@@ -266,43 +578,30 @@ NExpression * Parser::parse_atom(){
 	if(is_op(OP_PAREN_L)){
 		// Parse subexpression
 		skip_op(OP_PAREN_L, true, true);
-		NExpression * expression = parse_expression();
-		skip_op(OP_PAREN_R, true, false);
-		
+		expr_stack.push_back(ExprFrame{EF_PAREN, {}, 0, chain});
+
 		// TODO: Think about allow_func_call after subexpression
-		
-		return expression;
+
+		return nullptr;
 	}
 	if(is_op(OP_BRACKET_L)){
+		const uint32_t offset = peek().offset;
 		skip_op(OP_BRACKET_L, false, true);
-		ExpressionList expressions;
-		bool first = true;
-		while(!eof()){
-			if(is_op(OP_BRACKET_R)){
-				break;
-			}
-			if(first){
-				first = false;
-			}else{
-				skip_op(OP_COMMA, true, true);
-			}
-			expressions.push_back(parse_expression());
-		}
-
-		skip_op(OP_BRACKET_R, true, false);
-
-		return new NList(expressions);
+		expr_stack.push_back(ExprFrame{EF_LIST, {}, 0, chain, offset, nullptr, static_cast<uint32_t>(expr_items.size())});
+		return next_list_item();
 	}
 	if(is_str()){
-		NString * str = new NString(peek().String());
+		NString * str = make_node<NString>(true, [&]{ return NodeKey{NK_STRING, 0, peek().sym()}; }, peek().sym(), peek().offset);
 		advance();
 		return str;
 	}
 	if(is_prefix_op()){
 		// Parse prefix operator
 		Operator op = peek().op();
+		const uint32_t offset = peek().offset;
 		advance();
-		return new NPrefixOp(op, *parse_expression());
+		expr_stack.push_back(ExprFrame{EF_PREFIX, op, 0, chain, offset});
+		return nullptr;
 	}
 	if(is_kw()){
 		switch(peek().kw()){
@@ -313,19 +612,23 @@ NExpression * Parser::parse_atom(){
 		}
 	}
 	if(is_id()){
-		NIdentifier * id = new NIdentifier(peek().String());
+		NIdentifier * id = make_node<NIdentifier>(true, [&]{ return NodeKey{NK_IDENTIFIER, 0, peek().sym()}; }, peek().sym(), peek().offset);
 		allow_func_call = true;
 		advance();
 		return id;
 	}
 
+	const uint32_t offset = peek().offset;
 	unexpected_error();
 
-	return nullptr;
+	return arena.make<NError>(offset);
 }
 
 NBlock * Parser::parse_block(){
-	NBlock * block = new NBlock();
+	NBlock * block = arena.make<NBlock>(peek().offset);
+	if(!enter_nested()){
+		return block;
+	}
 
 	bool one_line = false;
 	bool first = true;
@@ -339,7 +642,10 @@ NBlock * Parser::parse_block(){
 	}
 
 	if(one_line){
-		block->statements.push_back(parse_statement());
+		NStatement * statement = parse_statement();
+		if(statement != nullptr){
+			block->statements.push_back(statement);
+		}
 	}else{
 		while(!eof()){
 			if(is_op(OP_BRACE_R)) break;
@@ -347,60 +653,79 @@ NBlock * Parser::parse_block(){
 				first = false;
 			}else{
 				skip_expr_end();
+				if(panic){
+					synchronize(true);
+					continue;
+				}
 			}
 			if(is_op(OP_BRACE_R)) break;
-			block->statements.push_back(parse_statement());
+			NStatement * statement = parse_statement();
+			if(statement != nullptr){
+				block->statements.push_back(statement);
+			}
+			if(panic){
+				synchronize(true);
+			}
 		}
 		skip_op(OP_BRACE_R, true, false);
 	}
 	optional_expr_end = true;
+	nesting--;
 
 	return block;
 }
 
 NIdentifier * Parser::parse_identifier(){
 	if(!is_id()){
+		const uint32_t offset = peek().offset;
 		expected_error("identifier");
+		return arena.make<NIdentifier>(intern(""), offset);
 	}
-	NIdentifier * id = new NIdentifier(peek().String());
+	NIdentifier * id = make_node<NIdentifier>(true, [&]{ return NodeKey{NK_IDENTIFIER, 0, peek().sym()}; }, peek().sym(), peek().offset);
 	advance();
 	return id;
 }
 
+// Note: Type is made after `?`, because shared type cannot be changed
 NType * Parser::parse_type(){
-
-	NType * type = nullptr;
-
-	if(is_op(OP_BRACKET_L)){
-		type = parse_list_type();
-	}else if(is_op(OP_PAREN_L)){
-		type = parse_tuple_type();
-	}else if(is_id()){
-		type = new NIdentifierType(*parse_identifier());
-	}else{
-		unexpected_error();
-		return nullptr;
+	if(is_op(OP_BRACKET_L) || is_op(OP_PAREN_L)){
+		const uint32_t offset = peek().offset;
+		if(!enter_nested()){
+			return arena.make<NError>(offset);
+		}
+		NType * type = is_op(OP_BRACKET_L) ? static_cast<NType*>(parse_list_type()) : parse_tuple_type();
+		nesting--;
+		return type;
 	}
-
-	if(is_op(OP_QUESTION_MARK)){
-		type->nullable = true;
-		advance();
+	if(is_id()){
+		NIdentifier * id = parse_identifier();
+		const bool nullable = skip_nullable();
+		NIdentifierType * type = make_node<NIdentifierType>(id->shared, [&]{ return NodeKey{NK_IDENTIFIER_TYPE, nullable, 0, id}; }, *id, id->offset);
+		type->nullable = nullable;
+		return type;
 	}
 
-	return type;
+	const uint32_t offset = peek().offset;
+	unexpected_error();
+	return arena.make<NError>(offset);
 }
 
 NListType * Parser::parse_list_type(){
+	const uint32_t offset = peek().offset;
 	skip_op(OP_BRACKET_L, false, false);
 	NType * wrapped_type = parse_type();
 	skip_op(OP_BRACKET_R, false, false);
+	const bool nullable = skip_nullable();
 
-	return new NListType(*wrapped_type);
+	NListType * type = make_node<NListType>(wrapped_type->shared, [&]{ return NodeKey{NK_LIST_TYPE, nullable, 0, wrapped_type}; }, *wrapped_type, offset);
+	type->nullable = nullable;
+	return type;
 }
 
 NTupleType * Parser::parse_tuple_type(){
 	// TODO: Add tuple var names and maybe default values
 
+	const uint32_t offset = peek().offset;
 	skip_op(OP_PAREN_L, false, false);
 
 	std::vector <NType*> types;
@@ -419,11 +744,22 @@ NTupleType * Parser::parse_tuple_type(){
 	}
 
 	skip_op(OP_PAREN_R, false, false);
+	const bool nullable = skip_nullable();
+
+	bool can_share = true;
+	for(NType * type : types){
+		can_share = can_share && type->shared;
+	}
 
-	return new NTupleType(types);
+	NTupleType * type = make_node<NTupleType>(can_share,
+											  [&]{ return NodeListKey{NK_TUPLE_TYPE, nullable, {types.begin(), types.end()}}; },
+											  types, offset);
+	type->nullable = nullable;
+	return type;
 }
 
 NTypeDecl * Parser::parse_type_decl(){
+	const uint32_t offset = peek().offset;
 	skip_kw(KW_TYPE, false, false);
 
 	NIdentifier * id = parse_identifier();
@@ -432,11 +768,12 @@ NTypeDecl * Parser::parse_type_decl(){
 
 	NType * type = parse_type();
 
-	return new NTypeDecl(*id, *type);
+	return arena.make<NTypeDecl>(*id, *type, offset);
 }
 
 NVarDecl * Parser::parse_var_decl(){
 	const bool is_val = is_kw(KW_VAL);
+	const uint32_t offset = peek().offset;
 	advance();
 
 	NIdentifier * id = parse_identifier();
@@ -454,29 +791,27 @@ NVarDecl * Parser::parse_var_decl(){
 		assignment_expr = parse_expression();
 	}
 
-	return new NVarDecl(is_val, *id, type, assignment_expr);
+	return arena.make<NVarDecl>(is_val, *id, type, assignment_expr, offset);
 }
 
-NFuncCall * Parser::parse_func_call(NExpression * left){
-	skip_op(OP_PAREN_L, false, true);
-	ExpressionList args;
-	while(!is_op(OP_PAREN_R) && !eof()){
-		args.push_back(parse_expression());
-		if(eof()){
-			skip_expr_end();
-		}
-		if(!is_op(OP_PAREN_R)){
-			skip_op(OP_COMMA, true, true);
-		}
+NExpression * Parser::next_call_arg(){
+	if(!is_op(OP_PAREN_R) && !eof()){
+		return nullptr;
 	}
 	skip_op(OP_PAREN_R, true, false);
-	return new NFuncCall(*left, args);
+
+	ExprFrame & frame = expr_stack.back();
+	NFuncCall * call = arena.make<NFuncCall>(*frame.left, ExpressionList(expr_items.begin() + frame.items, expr_items.end()), frame.offset);
+	expr_items.resize(frame.items);
+	expr_stack.pop_back();
+	return call;
 }
 
 // 
 // Function
 // 
 NArgDecl * Parser::parse_arg_declaration(){
+	const uint32_t offset = peek().offset;
 	NIdentifier * id = parse_identifier();
 	// TODO: Add default `any` type
 	NType * type = nullptr;
@@ -491,7 +826,7 @@ NArgDecl * Parser::parse_arg_declaration(){
 		default_value = parse_expression();
 	}
 
-	return new NArgDecl(*id, type, default_value);
+	return arena.make<NArgDecl>(*id, type, default_value, offset);
 }
 
 ArgList Parser::parse_arg_declaration_list(){
@@ -511,6 +846,7 @@ ArgList Parser::parse_arg_declaration_list(){
 }
 
 NFuncDecl * Parser::parse_func_decl(){
+	const uint32_t offset = peek().offset;
 	skip_kw(KW_FUNC, false, false);
 	NIdentifier * id = parse_identifier();
 
@@ -524,13 +860,14 @@ NFuncDecl * Parser::parse_func_decl(){
 
 	NBlock * block = parse_block();
 
-	return new NFuncDecl(*id, args, return_type, *block);
+	return arena.make<NFuncDecl>(*id, args, return_type, *block, offset);
 }
 
 // 
 // Condition
 // 
 NCondition * Parser::parse_condition(){
+	const uint32_t offset = peek().offset;
 	skip_kw(KW_IF, false, true);
 
 	ConditionBlock If;
@@ -540,7 +877,7 @@ NCondition * Parser::parse_condition(){
 	If.second = parse_block();
 
 	std::vector <ConditionBlock> Elifs;
-	while(is_kw(KW_ELIF)){
+	while(skip_endl_before_kw(KW_ELIF)){
 		skip_kw(KW_ELIF, true, true);
 
 		ConditionBlock Elif;
@@ -553,18 +890,17 @@ NCondition * Parser::parse_condition(){
 		Elifs.push_back(Elif);
 	}
 
-	skip_endl(true);
-
 	NBlock * Else = nullptr;
-	if(is_kw(KW_ELSE)){
+	if(skip_endl_before_kw(KW_ELSE)){
 		skip_kw(KW_ELSE, true, true);
 		Else = parse_block();
 	}
 
-	return new NCondition(If, Elifs, Else);
+	return arena.make<NCondition>(If, Elifs, Else, offset);
 }
 
 NWhile * Parser::parse_while(){
+	const uint32_t offset = peek().offset;
 	skip_kw(KW_WHILE, false, true);
 
 	skip_op(OP_PAREN_L, true, true);
@@ -573,10 +909,11 @@ NWhile * Parser::parse_while(){
 
 	NBlock * block = parse_block();
 
-	return new NWhile(*condition, *block);
+	return arena.make<NWhile>(*condition, *block, offset);
 }
 
 NFor * Parser::parse_for(){
+	const uint32_t offset = peek().offset;
 	skip_kw(KW_FOR, false, true);
 
 	skip_op(OP_PAREN_L, true, true);
@@ -598,10 +935,11 @@ NFor * Parser::parse_for(){
 
 	NBlock * block = parse_block();
 
-	return new NFor(*For, *In, *block);
+	return arena.make<NFor>(*For, *In, *block, offset);
 }
 
 NMatch * Parser::parse_match(){
+	const uint32_t offset = peek().offset;
 	skip_kw(KW_MATCH, false, true);
 
 	skip_op(OP_PAREN_L, true, true);
@@ -612,7 +950,7 @@ NMatch * Parser::parse_match(){
 
 	std::vector <MatchCase> Cases;
 
-	NBlock * Else;
+	NBlock * Else = nullptr;
 
 	while(!eof()){
 		if(is_op(OP_BRACE_R)){
@@ -658,5 +996,5 @@ NMatch * Parser::parse_match(){
 
 	skip_op(OP_BRACE_R, true, true);
 
-	return new NMatch(*expression, Cases, Else);
+	return arena.make<NMatch>(*expression, Cases, Else, offset);
 }
\ No newline at end of file
@@ -1,73 +1,221 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include <map>
+#include <array>
+#include <initializer_list>
 
 #include "Node.h"
+#include "TokenStream.h"
+#include "Arena.h"
+#include "HashCons.h"
 
-const std::map <Operator, int> OP_INFIX_PREC {
-	{OP_PIPELINE, 2},
+// Operator precedence tables are built at compile time as flat arrays indexed by Operator,
+// precedence 0 means that operator cannot be used in this position
 
-	{OP_ASSIGN, 3},
-	{OP_ASSIGN_ADD, 3}, {OP_ASSIGN_SUB, 3}, {OP_ASSIGN_MUL, 3},
-	{OP_ASSIGN_DIV, 3}, {OP_ASSIGN_MOD, 3}, {OP_ASSIGN_EXP, 3},
+enum Assoc : uint8_t {
+	ASSOC_LEFT,
+	ASSOC_RIGHT
+};
 
-	{OP_ASSIGN_BIT_AND, 3}, {OP_ASSIGN_BIT_OR, 3},
-	{OP_ASSIGN_BIT_XOR, 3}, {OP_ASSIGN_SHIFT_LEFT, 3}, {OP_ASSIGN_SHIFT_RIGHT, 3},
+struct OpPrec {
+	uint8_t prec;
+	Assoc assoc;
+};
 
-	{OP_OR, 5},
-	{OP_AND, 6},
-	{OP_BIT_OR, 8},
-	{OP_BIT_XOR, 9},
-	{OP_BIT_AND, 10},
-	{OP_EQUAL, 11}, {OP_NOT_EQUAL, 11},
+typedef std::array <OpPrec, OP_COUNT> PrecTable;
 
-	{OP_LESS, 12}, {OP_LESS_EQUAL, 12}, {OP_GREATER, 12},
-	{OP_GREATER_EQUAL, 12}, {OP_SPACESHIP, 12},
+constexpr void set_prec(PrecTable & table, std::initializer_list <Operator> ops, const uint8_t & prec, const Assoc & assoc = ASSOC_LEFT){
+	for(const Operator op : ops){
+		table[op] = OpPrec{prec, assoc};
+	}
+}
 
-	{OP_IN, 13}, {OP_NOT_IN, 13}, {OP_IS, 13, OP_NOT_IS, 13},
+constexpr PrecTable make_infix_prec(){
+	PrecTable table{};
 
-	{OP_ELVIS, 14},
+	set_prec(table, {OP_PIPELINE}, 2);
 
-	{OP_SHIFT_LEFT, 15}, {OP_SHIFT_RIGHT, 15},
+	set_prec(table, {
+		OP_ASSIGN,
+		OP_ASSIGN_ADD, OP_ASSIGN_SUB, OP_ASSIGN_MUL,
+		OP_ASSIGN_DIV, OP_ASSIGN_MOD, OP_ASSIGN_EXP,
+		OP_ASSIGN_BIT_AND, OP_ASSIGN_BIT_OR,
+		OP_ASSIGN_BIT_XOR, OP_ASSIGN_SHIFT_LEFT, OP_ASSIGN_SHIFT_RIGHT
+	}, 3, ASSOC_RIGHT);
 
-	{OP_RANGE, 16}, {OP_RANGE_INCL, 16},
-	
-	{OP_ADD, 17}, {OP_SUB, 17},
-	{OP_MUL, 18}, {OP_DIV, 18}, {OP_MOD, 18},
+	set_prec(table, {OP_OR}, 5);
+	set_prec(table, {OP_AND}, 6);
+	set_prec(table, {OP_BIT_OR}, 8);
+	set_prec(table, {OP_BIT_XOR}, 9);
+	set_prec(table, {OP_BIT_AND}, 10);
+	set_prec(table, {OP_EQUAL, OP_NOT_EQUAL}, 11);
 
-	{OP_EXP, 19},
+	set_prec(table, {OP_LESS, OP_LESS_EQUAL, OP_GREATER, OP_GREATER_EQUAL, OP_SPACESHIP}, 12);
 
-	{OP_AS, 20}, {OP_AS_NULLABLE, 20},
+	set_prec(table, {OP_IN, OP_NOT_IN, OP_IS, OP_NOT_IS}, 13);
 
-	{OP_MEMBER_ACCESS, 25}
-};
+	set_prec(table, {OP_ELVIS}, 14, ASSOC_RIGHT);
 
-const std::map <Operator, int> OP_PREFIX_PREC {
-	{OP_SPREAD, 1},
-	{OP_INC, 21}, {OP_DEC, 21}, {OP_ADD, 21}, {OP_SUB, 21},
-	{OP_BIT_INVERT, 21}, {OP_NOT, 21}
-};
+	set_prec(table, {OP_SHIFT_LEFT, OP_SHIFT_RIGHT}, 15);
 
-const std::map <Operator, int> OP_POSTFIX_PREC {
-	{OP_INC, 22}, {OP_DEC, 22}
-};
+	set_prec(table, {OP_RANGE, OP_RANGE_INCL}, 16);
+
+	set_prec(table, {OP_ADD, OP_SUB}, 17);
+	set_prec(table, {OP_MUL, OP_DIV, OP_MOD}, 18);
+
+	set_prec(table, {OP_EXP}, 19, ASSOC_RIGHT);
+
+	set_prec(table, {OP_AS, OP_AS_NULLABLE}, 20);
+
+	set_prec(table, {OP_MEMBER_ACCESS}, 25);
+
+	return table;
+}
+
+constexpr PrecTable make_prefix_prec(){
+	PrecTable table{};
+	set_prec(table, {OP_SPREAD}, 1, ASSOC_RIGHT);
+	set_prec(table, {OP_INC, OP_DEC, OP_ADD, OP_SUB, OP_BIT_INVERT, OP_NOT}, 21, ASSOC_RIGHT);
+	return table;
+}
+
+constexpr PrecTable make_postfix_prec(){
+	PrecTable table{};
+	set_prec(table, {OP_INC, OP_DEC}, 22);
+	return table;
+}
+
+constexpr PrecTable OP_INFIX_PREC = make_infix_prec();
+constexpr PrecTable OP_PREFIX_PREC = make_prefix_prec();
+constexpr PrecTable OP_POSTFIX_PREC = make_postfix_prec();
 
 class Parser {
 	public:
 		Parser();
 		virtual ~Parser() = default;
 
-		StatementList parse(const std::vector <Token> & tokens);
+		// Note: Nodes are allocated in Parser arena, so tree lives until Parser
+		// is destroyed or the next `parse()` call
+
+		// Parse tokens pulled on demand from source (e.g. Lexer)
+		StatementList parse(TokenSource & source);
+
+		// Parse without freeing of previously parsed trees, they stay valid
+		// Note: Used to parse code by parts (e.g. edited statements),
+		// `code_lines` is line index of the whole code kept by caller, so it's not built for each part
+		StatementList parse_more(TokenSource & source, const LineIndex * code_lines = nullptr);
+
+		// Parse tokens of one block in braces like `parse_more`, returns nullptr if tokens don't end after it
+		NBlock * parse_more_block(TokenSource & source, const LineIndex * code_lines = nullptr);
+
+		// Parse already lexed tokens of `code`
+		StatementList parse(const std::vector <Token> & tokens, std::string_view code);
+
+		// Free all parsed trees
+		void clear(){
+			tree.clear();
+			arena.clear();
+			shared_nodes.clear();
+		}
+
+		// Parse to flat tree, nodes are freed after flattening
+		FlatTree parse_flat(TokenSource & source);
+
+		// In recovery mode errors are not thrown but recorded into diagnostics,
+		// erroneous part of tree is replaced with NError and parser goes on
+		// from the end of statement (`T_ENDL`, `;` or `}`), so one parsing reports all errors
+		void set_recovery(const bool & recover){
+			this->recover = recover;
+		}
+
+		// Diagnostics of the last parsing, without recovery it is the thrown error
+		const std::vector <Diagnostic> & get_diagnostics() const {
+			return diagnostics;
+		}
+
+		// With hash-consing identical literals, identifiers, types and pure operator expressions
+		// are the same node (see HashCons), so repeated code takes less memory
+		// and types are compared by pointer.
+		// Note: Shared node has the offset of the first occurrence, so errors of evaluation
+		// point to it, and types of different Parsers must not be compared
+		void set_hash_consing(const bool & hash_consing){
+			this->hash_consing = hash_consing;
+		}
+
+		const HashCons & get_shared_nodes() const {
+			return shared_nodes;
+		}
+
+		// Bytes used by nodes of all parsed trees
+		size_t memory_used() const {
+			return arena.used();
+		}
 
 	private:
 		StatementList tree;
+		Arena arena;
+
+		TokenStream stream;
+		std::string_view code;
 
-		std::vector <Token> tokens;
-		uint32_t index;
+		// Note: Line index is built only when position is needed (on error)
+		LineIndex lines;
+		const LineIndex * code_lines;
+		void start(TokenSource & source, const LineIndex * code_lines);
+		Position position();
 		bool eof();
-		Token peek();
-		Token advance();
+
+		// Note: Tokens are returned by reference to TokenStream lookahead buffer,
+		// reference is valid until the next `advance()`
+		const Token & peek(){
+			if(panic){
+				return panic_token;
+			}
+			return stream.peek();
+		}
+		const Token & advance(){
+			if(panic){
+				return panic_token;
+			}
+			return stream.advance();
+		}
+
+		// Recovery
+		bool recover = false;
+		std::vector <Diagnostic> diagnostics;
+
+		// After error parser sees `panic_token` (end of code) instead of tokens until `synchronize()`,
+		// so all parsers of erroneous statement return at once without more errors
+		bool panic = false;
+		Token panic_token;
+
+		// Skip tokens to the end of statement, `}` closing block is not skipped if `in_block`
+		void synchronize(const bool & in_block);
+
+		// Hash-consing
+		bool hash_consing = false;
+		HashCons shared_nodes;
+
+		// Make node or take shared node with the same key if hash-consing is on,
+		// `make_key` returns NodeKey or NodeListKey and is called only with hash-consing,
+		// so parsing without it does not pay for keys
+		// Note: `can_share` is false for nodes with unshared children, key of such node is unique
+		template <class T, class MakeKey, class ...Args>
+		T * make_node(const bool & can_share, MakeKey && make_key, Args && ...args){
+			Node ** slot = nullptr;
+			if(hash_consing && can_share){
+				slot = &shared_nodes.find(make_key());
+				if(*slot != nullptr){
+					return static_cast<T*>(*slot);
+				}
+			}
+			T * node = arena.make<T>(std::forward<Args>(args)...);
+			if(slot != nullptr){
+				node->shared = true;
+				*slot = node;
+			}
+			return node;
+		}
 
 		// Recognizers
 		bool is_typeof(const TokenType & t);
@@ -91,9 +239,23 @@ class Parser {
 		void skip_op(const Operator & op, const bool & skip_left_endl, const bool & skip_right_endl);
 		void skip_kw(const Keyword & kw, const bool & skip_left_endl, const bool & skip_right_endl);
 
+		// Skip end of line before `kw` that continues statement (e.g. `else` on the line after `}`),
+		// returns true if current token is `kw`
+		bool skip_endl_before_kw(const Keyword & kw);
+
+		// Skip `?` of nullable type, returns true if it's skipped
+		bool skip_nullable();
+
 		bool optional_expr_end = false;
 		void skip_expr_end(const bool & optional = false);
 
+		// Depth limits (see MAX_TREE_DEPTH)
+		// Blocks and types are parsed by recursion, `nesting` is the count of them being parsed
+		uint32_t nesting = 0;
+		bool enter_nested();
+		// Check depth of tree made since arena used `used` bytes, reports error if it's too deep
+		bool check_depth(Node * node, const size_t & used);
+
 		// Errors
 		void error(const std::string & msg);
 		void expected_error(const std::string & expected, const std::string & given);
@@ -107,7 +269,50 @@ class Parser {
 		// Common
 		NStatement * parse_statement();
 		NExpression * parse_expression();
-		NExpression * parse_atom();
+
+		// Expression parser does not recurse, unfinished parts of expression are kept in `expr_stack`,
+		// so parser itself is not limited by depth of expression,
+		// but statements deeper than MAX_TREE_DEPTH are rejected, because later walks of tree are recursive.
+		// Note: Stack is shared by nested `parse_expression()` calls (e.g. `if` in expression),
+		// each call works only with frames above the size of stack at its start
+		enum ExprFrameKind : uint8_t {
+			// `left op ...` operand of infix operator with precedence greater than `prec`
+			EF_INFIX,
+			// `(...)`
+			EF_PAREN,
+			// `[...]`
+			EF_LIST,
+			// `op ...`
+			EF_PREFIX,
+			// `left(...)`
+			EF_CALL,
+			// `left[...]`
+			EF_LIST_ACCESS
+		};
+
+		struct ExprFrame {
+			ExprFrameKind kind;
+			Operator op{};
+			uint8_t prec = 0;
+			// Result can be continued with infix operator
+			bool chain = false;
+			uint32_t offset = 0;
+			NExpression * left = nullptr;
+			// Start of list items or call arguments in `expr_items`
+			uint32_t items = 0;
+		};
+
+		std::vector <ExprFrame> expr_stack;
+		std::vector <NExpression*> expr_items;
+
+		// Returns atom or pushes frame of subexpression and returns nullptr
+		NExpression * parse_atom(const bool & chain);
+
+		// Frame steps, each one returns result of the top frame (popping it)
+		// or nullptr if the frame needs one more operand
+		NExpression * next_infix();
+		NExpression * next_list_item();
+		NExpression * next_call_arg();
 
 		// TODO: Add `one_line` parameter that will set if block can be one line
 		NBlock * parse_block();
@@ -115,16 +320,12 @@ class Parser {
 		// Maybe's
 		bool allow_func_call = false;
 		// bool allow_list_access = false; // ????
-		NExpression * maybe_infix(NExpression * left, int prec);
 		NExpression * maybe_call(NExpression * left);
 		NExpression * maybe_list_access(NExpression * left);
 
 		// Value
 		NIdentifier * parse_identifier();
 
-		// List
-		NListAccess * parse_list_access(NExpression * left);
-		
 		// Type
 		NType * parse_type();
 		NListType * parse_list_type();
@@ -141,9 +342,6 @@ class Parser {
 		ArgList parse_arg_declaration_list();
 		NFuncDecl * parse_func_decl();
 
-		// Function call
-		NFuncCall * parse_func_call(NExpression * left);
-
 		// Condition
 		NCondition * parse_condition();
 
@@ -0,0 +1,285 @@
+#include "Resolver.h"
+
+Resolver::Resolver(){
+	offset = 0;
+}
+
+void Resolver::error(const std::string & msg){
+	throw RuntimeError(msg, offset);
+}
+
+std::vector <Symbol> Resolver::resolve(const StatementList & tree){
+	scopes.clear();
+	globals.clear();
+	global_names.clear();
+	offset = 0;
+
+	for(NativeFunc * builtin : builtins()){
+		Global & var = global(builtin->name);
+		var.is_val = true;
+		var.defined = true;
+	}
+
+	// Note: Locals of global scope are globals, so its state is only the depth
+	scopes.push_back(ScopeState{{}, 0});
+	for(NStatement * statement : tree){
+		resolve_statement(statement);
+	}
+	scopes.pop_back();
+
+	return global_names;
+}
+
+///////////////
+// Variables //
+///////////////
+
+bool Resolver::is_global_scope(){
+	return scopes.size() == 1 && scopes.back().depth == 0;
+}
+
+Resolver::Global & Resolver::global(const Symbol & name){
+	auto [it, inserted] = globals.try_emplace(name, Global{static_cast<uint32_t>(global_names.size()), false, false, NO_OFFSET});
+	if(inserted){
+		global_names.push_back(name);
+	}
+	return it->second;
+}
+
+void Resolver::declare(NIdentifier & id, const bool & is_val){
+	id.depth = 0;
+	id.check_defined = false;
+
+	if(is_global_scope()){
+		Global & var = global(id.name);
+		if(var.defined){
+			error("`" + std::string(symbol_str(id.name)) + "` is already defined");
+		}
+		if(is_val && var.assigned != NO_OFFSET){
+			offset = var.assigned;
+			error("Cannot reassign val `" + std::string(symbol_str(id.name)) + "`");
+		}
+		var.defined = true;
+		var.is_val = is_val;
+		id.slot = var.slot;
+		return;
+	}
+
+	ScopeState & scope = scopes.back();
+	for(auto it = scope.locals.rbegin(); it != scope.locals.rend() && it->depth == scope.depth; it++){
+		if(it->name == id.name){
+			error("`" + std::string(symbol_str(id.name)) + "` is already defined");
+		}
+	}
+	scope.locals.push_back(Local{id.name, is_val, scope.depth});
+	id.slot = scope.locals.size() - 1;
+}
+
+void Resolver::resolve_name(NIdentifier & id, const bool & assign){
+	// Note: The first scope is global, its locals are in `globals`
+	for(size_t s = scopes.size(); s-- > 1;){
+		const std::vector <Local> & locals = scopes[s].locals;
+		for(size_t slot = locals.size(); slot-- > 0;){
+			if(locals[slot].name != id.name){
+				continue;
+			}
+			if(assign && locals[slot].is_val){
+				error("Cannot reassign val `" + std::string(symbol_str(id.name)) + "`");
+			}
+			id.depth = scopes.size() - 1 - s;
+			id.slot = slot;
+			id.check_defined = false;
+			return;
+		}
+	}
+
+	Global & var = global(id.name);
+	if(assign){
+		if(var.is_val){
+			error("Cannot reassign val `" + std::string(symbol_str(id.name)) + "`");
+		}
+		if(var.assigned == NO_OFFSET){
+			var.assigned = offset;
+		}
+	}
+	id.depth = scopes.size() - 1;
+	id.slot = var.slot;
+	// Note: Global defined before this point is never undefined again
+	id.check_defined = !var.defined;
+}
+
+////////////////
+// Statements //
+////////////////
+
+void Resolver::resolve_statement(NStatement * statement){
+	if(!statement){
+		return;
+	}
+	offset = statement->offset;
+
+	if(NExpressionStatement * expr_stmt = dynamic_cast<NExpressionStatement*>(statement)){
+		resolve_expression(&expr_stmt->expression);
+	}else if(NVarDecl * var_decl = dynamic_cast<NVarDecl*>(statement)){
+		// Note: Value is resolved before declaration, so `var a = a` refers to outer `a`
+		if(var_decl->assignment_expr){
+			resolve_expression(var_decl->assignment_expr);
+		}
+		offset = var_decl->offset;
+		declare(var_decl->id, var_decl->is_val);
+	}else if(NFuncDecl * func_decl = dynamic_cast<NFuncDecl*>(statement)){
+		resolve_func_decl(*func_decl);
+	}else if(NReturn * ret = dynamic_cast<NReturn*>(statement)){
+		if(ret->right){
+			resolve_expression(ret->right);
+		}
+	}else if(NWhile * loop = dynamic_cast<NWhile*>(statement)){
+		resolve_expression(&loop->condition);
+		resolve_block(loop->block);
+	}else if(NFor * loop = dynamic_cast<NFor*>(statement)){
+		resolve_for(*loop);
+	}else if(NMatch * match = dynamic_cast<NMatch*>(statement)){
+		resolve_expression(&match->expression);
+		for(const MatchCase & Case : match->Cases){
+			for(NExpression * pattern : Case.first){
+				resolve_expression(pattern);
+			}
+			resolve_block(*Case.second);
+		}
+		if(match->Else){
+			resolve_block(*match->Else);
+		}
+	}
+	// Note: Types are not checked at runtime yet, so NTypeDecl has nothing to resolve
+}
+
+void Resolver::resolve_block(NBlock & block, const bool & is_body){
+	if(is_body){
+		block.slot_count = 0;
+		scopes.back().depth++;
+		for(NStatement * statement : block.statements){
+			resolve_statement(statement);
+		}
+		scopes.back().depth--;
+		return;
+	}
+
+	// Note: Block without declarations doesn't need own scope
+	bool has_locals = false;
+	for(NStatement * statement : block.statements){
+		if(dynamic_cast<NVarDecl*>(statement) || dynamic_cast<NFuncDecl*>(statement)){
+			has_locals = true;
+			break;
+		}
+	}
+
+	if(has_locals){
+		scopes.push_back(ScopeState{{}, 0});
+	}else{
+		scopes.back().depth++;
+	}
+	for(NStatement * statement : block.statements){
+		resolve_statement(statement);
+	}
+	if(has_locals){
+		block.slot_count = scopes.back().locals.size();
+		scopes.pop_back();
+	}else{
+		block.slot_count = 0;
+		scopes.back().depth--;
+	}
+}
+
+void Resolver::resolve_func_decl(NFuncDecl & func_decl){
+	// Note: Function is declared before its body is resolved, so it can call itself
+	offset = func_decl.offset;
+	declare(func_decl.id, true);
+
+	scopes.push_back(ScopeState{{}, 0});
+	for(NArgDecl * arg : func_decl.args){
+		// Note: Default value can use previous arguments
+		if(arg->default_value){
+			resolve_expression(arg->default_value);
+		}
+		offset = arg->offset;
+		declare(arg->id, false);
+	}
+	resolve_block(func_decl.block, true);
+	func_decl.slot_count = scopes.back().locals.size();
+	scopes.pop_back();
+}
+
+void Resolver::resolve_for(NFor & loop){
+	resolve_expression(&loop.In);
+
+	// Note: Each iteration has own scope, so closure captures loop variable of its iteration
+	scopes.push_back(ScopeState{{}, 0});
+	offset = loop.offset;
+	declare(loop.For, false);
+	resolve_block(loop.block, true);
+	loop.slot_count = scopes.back().locals.size();
+	scopes.pop_back();
+}
+
+/////////////////
+// Expressions //
+/////////////////
+
+void Resolver::resolve_expression(NExpression * expression){
+	offset = expression->offset;
+
+	if(NIdentifier * node = dynamic_cast<NIdentifier*>(expression)){
+		resolve_name(*node, false);
+	}else if(NInfixOp * node = dynamic_cast<NInfixOp*>(expression)){
+		NIdentifier * target = dynamic_cast<NIdentifier*>(&node->left);
+		if(target && (node->op == OP_ASSIGN || augmented_operator(node->op) != node->op)){
+			resolve_expression(&node->right);
+			offset = node->offset;
+			resolve_name(*target, true);
+		}else{
+			resolve_expression(&node->left);
+			resolve_expression(&node->right);
+		}
+	}else if(NPrefixOp * node = dynamic_cast<NPrefixOp*>(expression)){
+		NIdentifier * target = dynamic_cast<NIdentifier*>(&node->right);
+		if(target && (node->op == OP_INC || node->op == OP_DEC)){
+			offset = node->offset;
+			resolve_name(*target, true);
+		}else{
+			resolve_expression(&node->right);
+		}
+	}else if(NPostfixOp * node = dynamic_cast<NPostfixOp*>(expression)){
+		// Note: Postfix operator on not a variable is an error of tree walker
+		if(NIdentifier * target = dynamic_cast<NIdentifier*>(&node->left)){
+			offset = node->offset;
+			resolve_name(*target, true);
+		}else{
+			resolve_expression(&node->left);
+		}
+	}else if(NFuncCall * node = dynamic_cast<NFuncCall*>(expression)){
+		resolve_expression(&node->left);
+		for(NExpression * arg : node->args){
+			resolve_expression(arg);
+		}
+	}else if(NListAccess * node = dynamic_cast<NListAccess*>(expression)){
+		resolve_expression(&node->left);
+		resolve_expression(&node->access);
+	}else if(NList * node = dynamic_cast<NList*>(expression)){
+		for(NExpression * item : node->expressions){
+			resolve_expression(item);
+		}
+	}else if(NCondition * node = dynamic_cast<NCondition*>(expression)){
+		resolve_expression(node->If.first);
+		resolve_block(*node->If.second);
+		for(const ConditionBlock & Elif : node->Elifs){
+			resolve_expression(Elif.first);
+			resolve_block(*Elif.second);
+		}
+		if(node->Else){
+			resolve_block(*node->Else);
+		}
+	}else if(NBlock * node = dynamic_cast<NBlock*>(expression)){
+		resolve_block(*node);
+	}
+	// Note: Literals and types have nothing to resolve
+}
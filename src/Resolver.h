@@ -0,0 +1,73 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "Node.h"
+
+// Resolver binds variables of AST to slots of scopes for tree walker (see Scope).
+// Runtime scope is created for each function call, `for` iteration and block with declarations,
+// body of function (or `for`) shares the scope with arguments (or loop variable).
+// Declaration gets slot in the current scope and identifier gets depth (count of scopes up) and slot,
+// so evaluation of identifier doesn't look up names.
+// Top-level variables and functions are globals (slots of the global scope), global is created on the first use,
+// so function can use global declared after it, such access is checked at runtime (see `NIdentifier::check_defined`).
+// Note: Variable is visible after its declaration, as in Compiler
+// Errors (e.g. assignment to `val`) are thrown as RuntimeError at offset of node
+class Resolver {
+	public:
+		Resolver();
+		virtual ~Resolver() = default;
+
+		// Returns names of global slots, builtins are the first ones
+		std::vector <Symbol> resolve(const StatementList & tree);
+
+	private:
+		struct Local {
+			Symbol name;
+			bool is_val;
+			// Depth of block in the scope, name can be shadowed in the body of function or `for`
+			uint32_t depth;
+		};
+
+		// Runtime scope, slot of local is its index
+		struct ScopeState {
+			std::vector <Local> locals;
+			uint32_t depth;
+		};
+		std::vector <ScopeState> scopes;
+
+		struct Global {
+			uint32_t slot;
+			bool is_val;
+			bool defined;
+			// Offset of the first assignment, to report assignment to `val` declared after it
+			uint32_t assigned;
+		};
+		std::unordered_map <Symbol, Global> globals;
+		std::vector <Symbol> global_names;
+
+		// Offset of node being resolved
+		uint32_t offset;
+
+		bool is_global_scope();
+		Global & global(const Symbol & name);
+		void declare(NIdentifier & id, const bool & is_val);
+		void resolve_name(NIdentifier & id, const bool & assign);
+
+		// Statements
+		void resolve_statement(NStatement * statement);
+		// Body of function or `for` is resolved in the current scope
+		void resolve_block(NBlock & block, const bool & is_body = false);
+		void resolve_func_decl(NFuncDecl & func_decl);
+		void resolve_for(NFor & loop);
+
+		// Expressions
+		void resolve_expression(NExpression * expression);
+
+		[[noreturn]] void error(const std::string & msg);
+};
+
+#endif
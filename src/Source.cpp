@@ -0,0 +1,155 @@
+#include "Source.h"
+
+#include <limits>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+Source::Source(){
+	begin = nullptr;
+	length = 0;
+	mapped = false;
+
+#ifdef _WIN32
+	file_handle = INVALID_HANDLE_VALUE;
+	mapping_handle = nullptr;
+#endif
+}
+
+Source::~Source(){
+	close();
+}
+
+void Source::borrow(std::string_view code){
+	close();
+
+	if(code.size() > std::numeric_limits<uint32_t>::max()){
+		error("Code is too large (more than 4GB)");
+	}
+
+	begin = code.data();
+	length = static_cast<uint32_t>(code.size());
+}
+
+#ifdef _WIN32
+
+void Source::open(const char * path){
+	close();
+
+	file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+							  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file_handle == INVALID_HANDLE_VALUE){
+		error("Unable to open file `" + std::string(path) + "`");
+	}
+
+	LARGE_INTEGER file_size;
+	if(!GetFileSizeEx(file_handle, &file_size)){
+		error("Unable to get size of file `" + std::string(path) + "`");
+	}
+	if(static_cast<uint64_t>(file_size.QuadPart) > std::numeric_limits<uint32_t>::max()){
+		error("File `" + std::string(path) + "` is too large (more than 4GB)");
+	}
+
+	length = static_cast<uint32_t>(file_size.QuadPart);
+
+	// Note: Empty file cannot be mapped, so it's just empty code
+	if(length == 0){
+		return;
+	}
+
+	mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(!mapping_handle){
+		error("Unable to map file `" + std::string(path) + "`");
+	}
+
+	begin = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	if(!begin){
+		error("Unable to map file `" + std::string(path) + "`");
+	}
+	mapped = true;
+}
+
+void Source::close(){
+	if(mapped){
+		UnmapViewOfFile(begin);
+	}
+	if(mapping_handle){
+		CloseHandle(mapping_handle);
+		mapping_handle = nullptr;
+	}
+	if(file_handle != INVALID_HANDLE_VALUE){
+		CloseHandle(file_handle);
+		file_handle = INVALID_HANDLE_VALUE;
+	}
+
+	begin = nullptr;
+	length = 0;
+	mapped = false;
+}
+
+#else
+
+void Source::open(const char * path){
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0){
+		error("Unable to open file `" + std::string(path) + "`");
+	}
+
+	struct stat file_stat;
+	if(fstat(fd, &file_stat) < 0){
+		::close(fd);
+		error("Unable to get size of file `" + std::string(path) + "`");
+	}
+	if(static_cast<uint64_t>(file_stat.st_size) > std::numeric_limits<uint32_t>::max()){
+		::close(fd);
+		error("File `" + std::string(path) + "` is too large (more than 4GB)");
+	}
+
+	// Note: Empty file cannot be mapped, so it's just empty code
+	if(file_stat.st_size == 0){
+		::close(fd);
+		return;
+	}
+
+	void * addr = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// Note: Mapping stays valid after descriptor closing
+	::close(fd);
+
+	if(addr == MAP_FAILED){
+		error("Unable to map file `" + std::string(path) + "`");
+	}
+
+	// Lexer reads code strictly forward
+	madvise(addr, file_stat.st_size, MADV_SEQUENTIAL);
+
+	begin = static_cast<const char*>(addr);
+	length = static_cast<uint32_t>(file_stat.st_size);
+	mapped = true;
+}
+
+void Source::close(){
+	if(mapped){
+		munmap(const_cast<char*>(begin), length);
+	}
+
+	begin = nullptr;
+	length = 0;
+	mapped = false;
+}
+
+#endif
+
+// Errors
+void Source::error(const std::string & msg){
+	throw Exception("Source [ERROR]: " + msg);
+}
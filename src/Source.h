@@ -0,0 +1,55 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+#include "err.h"
+
+// Source is the read-only code buffer that Lexer scans.
+// It either maps the file into memory or borrows a caller-owned buffer,
+// so the code is never copied on its way to Lexer.
+// Note: Mapped code is not null-terminated, use `size()` for bounds
+
+class Source {
+	public:
+		Source();
+		virtual ~Source();
+
+		Source(const Source &) = delete;
+		Source & operator=(const Source &) = delete;
+
+		// Map file read-only
+		void open(const char * path);
+
+		// Caller must keep `code` alive while Source (and tokens pointing into it) are used
+		void borrow(std::string_view code);
+
+		void close();
+
+		const char * data() const {
+			return begin;
+		}
+		uint32_t size() const {
+			return length;
+		}
+		std::string_view view() const {
+			return std::string_view(begin, length);
+		}
+
+	private:
+		const char * begin;
+		uint32_t length;
+		bool mapped;
+
+#ifdef _WIN32
+		void * file_handle;
+		void * mapping_handle;
+#endif
+
+		// Errors
+		void error(const std::string & msg);
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "StatementSplit.h"
+#include "Parser.h"
+
+static bool is_statement_continuation(const Token & last, const Token & next){
+	if(last.type == T_KW){
+		switch(last.kw()){
+			case KW_BREAK:
+			case KW_CONTINUE:
+			case KW_RETURN:{
+				break;
+			}
+			default: return true;
+		}
+	}
+	if(last.type == T_OP){
+		switch(last.op()){
+			case OP_PAREN_R:
+			case OP_BRACKET_R:
+			case OP_BRACE_R:
+			case OP_SEMICOLON:{
+				break;
+			}
+			default: return true;
+		}
+	}
+
+	if(next.type == T_KW){
+		return next.kw() == KW_ELIF || next.kw() == KW_ELSE;
+	}
+	if(next.type == T_OP){
+		const Operator op = next.op();
+		if(op == OP_BRACE_L){
+			return true;
+		}
+		return OP_INFIX_PREC[op].prec != 0 && OP_PREFIX_PREC[op].prec == 0
+			&& op != OP_PAREN_L && op != OP_BRACKET_L;
+	}
+
+	return false;
+}
+
+StatementSplitter::StatementSplitter(std::vector <uint32_t> & ends) : ends(ends) {
+	index = 0;
+	start = 0;
+	depth = 0;
+	has_last = false;
+	pending = false;
+	needs_body = false;
+}
+
+void StatementSplitter::push(const Token & token){
+	if(pending){
+		pending = false;
+		if(!is_statement_continuation(last, token)){
+			ends.push_back(index);
+			start = index;
+			has_last = false;
+		}
+	}
+
+	if(token.type == T_KW && depth == 0){
+		switch(token.kw()){
+			case KW_FUNC:
+			case KW_IF:
+			case KW_ELIF:
+			case KW_WHILE:
+			case KW_FOR:{
+				needs_body = true;
+				break;
+			}
+			default: break;
+		}
+	}
+
+	if(token.type == T_OP){
+		switch(token.op()){
+			case OP_PAREN_L:
+			case OP_BRACKET_L:
+			case OP_BRACE_L:{
+				if(depth == 0 && token.op() == OP_BRACE_L){
+					needs_body = false;
+				}
+				depth++;
+				break;
+			}
+			case OP_PAREN_R:
+			case OP_BRACKET_R:
+			case OP_BRACE_R:{
+				if(depth > 0){
+					depth--;
+				}
+				break;
+			}
+			default: break;
+		}
+	}
+
+	const bool is_end = token.type == T_ENDL || (token.type == T_OP && token.op() == OP_SEMICOLON);
+	if(depth == 0 && is_end && has_last){
+		// Note: Block without braces is the statement on the next line
+		pending = !(needs_body && token.type == T_ENDL);
+		needs_body = false;
+	}else if(token.type != T_ENDL){
+		last = token;
+		has_last = true;
+	}
+
+	index++;
+}
+
+bool StatementSplitter::is_complete(const Token * next) const {
+	if(index == start){
+		return true;
+	}
+	if(depth != 0){
+		return false;
+	}
+	if(pending){
+		return !next || !is_statement_continuation(last, *next);
+	}
+	// Note: Only `T_ENDL` after the last statement (e.g. after `;` and comment), they belong to it
+	// when it's the end of code, but fresh split puts them at the start of the next statement
+	return false;
+}
+
+bool StatementSplitter::finish(const Token * next){
+	if(index == start){
+		return true;
+	}
+
+	if(depth == 0 && (pending || has_last) && (!next || (pending && !is_statement_continuation(last, *next)))){
+		ends.push_back(index);
+		start = index;
+		return true;
+	}
+
+	// Tokens without statements (e.g. empty lines) are appended to previous statement
+	if(depth == 0 && !has_last && (!ends.empty() || !next)){
+		if(ends.empty()){
+			ends.push_back(index);
+		}else{
+			ends.back() = index;
+		}
+		start = index;
+		return true;
+	}
+
+	return false;
+}
+
+void StatementSplitter::reset(){
+	if(index != start){
+		ends.push_back(index);
+		start = index;
+	}
+	depth = 0;
+	has_last = false;
+	pending = false;
+	needs_body = false;
+}
+
+bool split_statements(std::span <const Token> tokens, const Token * next, std::vector <uint32_t> & ends){
+	StatementSplitter splitter(ends);
+	for(const Token & token : tokens){
+		splitter.push(token);
+	}
+	return splitter.finish(next);
+}
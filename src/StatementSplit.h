@@ -0,0 +1,56 @@
+#ifndef STATEMENTSPLIT_H
+#define STATEMENTSPLIT_H
+
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "Token.h"
+
+// Find boundaries of top-level statements in tokens without parsing.
+// Statement ends after `T_ENDL` or `;` outside of parens, brackets and braces,
+// unless the statement obviously continues on the next line:
+// line ends with operator or keyword (`a +`, `else`), except `return`, `break`, `continue`, or
+// next line starts with `{`, `elif`, `else` or infix-only operator (`.method()`, `|> f`),
+// or line ends head of block without braces (`if a`, `func f()`), then the next line is its body.
+// Note: Unmatched closing brackets are ignored, so broken line doesn't make the rest of code one statement
+
+// StatementSplitter takes tokens one by one, so boundaries can be checked while tokens are lexed.
+// Ends (exclusive) of statements are appended to `ends`
+class StatementSplitter {
+	public:
+		StatementSplitter(std::vector <uint32_t> & ends);
+		virtual ~StatementSplitter() = default;
+
+		void push(const Token & token);
+
+		// Check if pushed tokens are whole statements, `next` is the following token (nullptr at the end of code)
+		bool is_complete(const Token * next) const;
+
+		// Add end of the last statement, returns false if tokens end in the middle of statement
+		bool finish(const Token * next);
+
+		// End statement before the next token whatever it is (e.g. after line with lexing error)
+		void reset();
+
+	private:
+		std::vector <uint32_t> & ends;
+		uint32_t index;
+		uint32_t start;
+		int32_t depth;
+
+		// Last token that is not `T_ENDL` in current statement
+		Token last;
+		bool has_last;
+
+		// Statement end found, but it depends on the next token
+		bool pending;
+
+		// Statement has `func`, `if`, `while`, etc. without block yet
+		bool needs_body;
+};
+
+// Split all tokens at once, returns false if tokens end in the middle of statement
+bool split_statements(std::span <const Token> tokens, const Token * next, std::vector <uint32_t> & ends);
+
+#endif
@@ -2,17 +2,21 @@
 #define TOKEN_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <array>
+#include <cstdint>
+#include <type_traits>
 #include <algorithm>
-#include <variant>
-
-#include <iostream>
 
 #include "err.h"
+#include "Interner.h"
+#include "LineIndex.h"
+#include "NumberLiteral.h"
 
 // TODO: Think about null-safety
 
-enum TokenType {
+enum TokenType : uint8_t {
 	T_INT,
 	T_FLOAT,
 	T_BOOL, // Note: Boolean stored inside BYTE
@@ -65,6 +69,9 @@ enum Operator {
 	OP_IS, OP_NOT_IS
 };
 
+// Note: Count of operators for tables indexed by Operator, update if last operator changes
+const size_t OP_COUNT = OP_NOT_IS + 1;
+
 const std::vector <std::string> operators {
 	"=",
 	"+", "-", "*", "/", "%", "**",
@@ -104,7 +111,7 @@ const std::vector <std::string> operators {
 	"is", "!is"
 };
 
-inline Operator str_operator(const std::string & str){
+inline Operator str_operator(std::string_view str){
 	return static_cast<Operator>(std::distance(operators.begin(), std::find(operators.begin(), operators.end(), str)));
 }
 
@@ -129,10 +136,95 @@ const std::vector <std::string> keywords {
 	"return"
 };
 
-inline Keyword str_to_kw(const std::string & str){
-	return static_cast<Keyword>(std::distance(keywords.begin(), std::find(keywords.begin(), keywords.end(), str)));
+// Words are keywords, bool literals and word operators that look like identifiers.
+// They're recognized by compile-time generated perfect hash (of first, second and last chars and length),
+// so identifier classification is O(1) and doesn't allocate.
+struct Word {
+	std::string_view str;
+	TokenType type;
+	uint32_t val;
+};
+
+constexpr Word words[] {
+	{"var", T_KW, KW_VAR}, {"val", T_KW, KW_VAL}, {"func", T_KW, KW_FUNC}, {"type", T_KW, KW_TYPE},
+	{"if", T_KW, KW_IF}, {"elif", T_KW, KW_ELIF}, {"else", T_KW, KW_ELSE},
+	{"for", T_KW, KW_FOR}, {"while", T_KW, KW_WHILE}, {"repeat", T_KW, KW_REPEAT},
+	{"break", T_KW, KW_BREAK}, {"continue", T_KW, KW_CONTINUE},
+	{"match", T_KW, KW_MATCH},
+	{"return", T_KW, KW_RETURN},
+
+	{"true", T_BOOL, 1}, {"false", T_BOOL, 0},
+
+	{"in", T_OP, OP_IN},
+	{"as", T_OP, OP_AS},
+	{"is", T_OP, OP_IS}
+};
+
+constexpr uint32_t WORD_MIN_LENGTH = 2;
+constexpr uint32_t WORD_MAX_LENGTH = 8;
+constexpr uint32_t WORDS_TABLE_SIZE = 32;
+
+// Note: If words are changed, hash coefficients might need to be changed too (static_assert below will fail)
+constexpr uint32_t word_hash(std::string_view str){
+	return (static_cast<unsigned char>(str[0]) * 3
+		  + static_cast<unsigned char>(str[1]) * 13
+		  + static_cast<unsigned char>(str[str.size() - 1]) * 6
+		  + str.size()) & (WORDS_TABLE_SIZE - 1);
+}
+
+// Index of word in `words` by hash, -1 for empty slot
+constexpr std::array <int8_t, WORDS_TABLE_SIZE> make_words_table(){
+	std::array <int8_t, WORDS_TABLE_SIZE> table{};
+	for(auto & slot : table){
+		slot = -1;
+	}
+	for(uint32_t i = 0; i < std::size(words); i++){
+		table[word_hash(words[i].str)] = i;
+	}
+	return table;
+}
+
+constexpr std::array <int8_t, WORDS_TABLE_SIZE> words_table = make_words_table();
+
+constexpr bool is_words_hash_perfect(){
+	for(uint32_t i = 0; i < std::size(words); i++){
+		if(words_table[word_hash(words[i].str)] != static_cast<int8_t>(i)
+		|| words[i].str.size() < WORD_MIN_LENGTH || words[i].str.size() > WORD_MAX_LENGTH){
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(is_words_hash_perfect(), "Words hash has collisions");
+
+// Returns nullptr if `str` is not a word (just an identifier)
+constexpr const Word * find_word(std::string_view str){
+	if(str.size() < WORD_MIN_LENGTH || str.size() > WORD_MAX_LENGTH){
+		return nullptr;
+	}
+	const int8_t i = words_table[word_hash(str)];
+	if(i < 0 || words[i].str != str){
+		return nullptr;
+	}
+	return &words[i];
+}
+
+inline Keyword str_to_kw(std::string_view str){
+	const Word * word = find_word(str);
+	if(!word){
+		return KW_MAX;
+	}
+	// Note: `true` and `false` are lexed as bool literals, but they're still keywords
+	if(word->type == T_BOOL){
+		return word->val ? KW_TRUE : KW_FALSE;
+	}
+	if(word->type != T_KW){
+		return KW_MAX;
+	}
+	return static_cast<Keyword>(word->val);
 }
-inline bool is_kw(const std::string & str){
+inline bool is_kw(std::string_view str){
 	return str_to_kw(str) < KW_MAX;
 }
 
@@ -147,102 +239,60 @@ inline std::string op_to_str(const Operator & op){
 // For example, in the future std::string will be replaced with std::wstring
 typedef unsigned char BYTE;
 
-// TODO: Add more number type: int, uint, short, double and etc.
-// TODO: Think about std::string vs char*
-// Note: As I tested, char* won't work properly in variant, because of setting by ref
-typedef std::variant<BYTE, int, double, std::string, Operator, Keyword> TokenVal;
-
-typedef struct {
-	uint32_t line;
-	uint32_t column;
-
-	// TODO: Think about containing `index` as index of token in the code
-} Position;
-
+// Token is trivially-copyable 16-byte record, so tokens list is flat and cheap to copy.
+// Token does not own its text, the text is the span [offset, offset + length) of code.
+// Numbers are converted from the span, bools, operators and keywords are stored in `val`,
+// identifiers and strings store interned Symbol of their text in `val`.
+// Note: String token span includes quotes
 struct Token {
-	TokenType type;
-	TokenVal val;
+	TokenType type = T_PROG_END;
+	uint32_t offset = 0;
+	uint32_t length = 0;
+	uint32_t val = 0;
 
-	Position pos;
-
-	Token(const TokenType & t, const std::string & v){
-		type = t;
-
-		// TODO: Add parsing errors catching for std::sto?
-
-		switch(t){
-			case T_ENDL:
-			case T_PROG_END:{
-				val = 0.0;
-				break;
-			}
-			case T_INT:{
-				std::cout << "Convert to int: " << v << std::endl;
-				val = std::stoi(v);
-				break;
-			}
-			case T_FLOAT:{
-				val = std::stod(v);
-				break;
-			}
-			case T_BOOL:{
-				// Note: This `case` might be useless because of parsing true/false keywords below
-				val = static_cast<BYTE>(v == "true");
-				break;
-			}
-			case T_STR:
-			case T_ID:{
-				val = v;
-				break;
-			}
-			case T_KW:{
-				// Check for bool and store it in Real
-				// If I'm right it won't increase complexity
-				if(v == "true" || v == "false"){
-					type = T_BOOL;
-					val = static_cast<BYTE>(v == "true");
-				}else{
-					val = str_to_kw(v);
-				}
-				break;
-			}
-		}
-	}
-	// Setting operator is differert
-	Token(const Operator & op){
-		type = T_OP;
-		val = op;
+	std::string_view text(std::string_view code) const {
+		return code.substr(offset, length);
 	}
 
-	int Int(){
-		return std::get<int>(val);
+	// Note: Number literals are validated by Lexer, so conversion here cannot fail
+	int64_t Int(std::string_view code) const {
+		int64_t value = 0;
+		parse_int_literal(text(code), value);
+		return value;
 	}
-	double Float(){
-		return std::get<double>(val);
+	double Float(std::string_view code) const {
+		double value = 0;
+		parse_float_literal(text(code), value);
+		return value;
 	}
-	bool Bool(){
-		return static_cast<bool>(std::get<BYTE>(val));
+	bool Bool() const {
+		return static_cast<bool>(val);
 	}
-	std::string String(){
-		return std::get<std::string>(val);
+	std::string_view String(std::string_view code) const {
+		if(type == T_STR){
+			// Cut quotes
+			return code.substr(offset + 1, length - 2);
+		}
+		return text(code);
 	}
 
-	Operator op(){
-		return std::get<Operator>(val);
-	}
-	Keyword kw(){
-		return std::get<Keyword>(val);
+	Symbol sym() const {
+		return val;
 	}
 
-	// Errors
-	void error(const std::string & msg){
-		err(msg + " " + to_string(), pos.line, pos.column);
+	Operator op() const {
+		return static_cast<Operator>(val);
+	}
+	Keyword kw() const {
+		return static_cast<Keyword>(val);
 	}
-	void unexpected_error(){
-		error("Unexpected token");
+
+	std::string to_string(std::string_view code, const LineIndex & lines) const {
+		Position pos = lines.position(offset);
+		return to_string(code) + " at " + std::to_string(pos.line) + ":" + std::to_string(pos.column);
 	}
 
-	std::string to_string(const bool & with_pos = false){
+	std::string to_string(std::string_view code) const {
 		std::string token_str;
 		switch (type) {
 			case T_INT: token_str = "int"; break;
@@ -259,17 +309,17 @@ struct Token {
 		token_str += " `";
 		switch (type) {
 			case T_INT:
-				token_str += std::to_string(Int());
+				token_str += std::to_string(Int(code));
 				break;
 			case T_FLOAT:
-				token_str += std::to_string(Float());
+				token_str += std::to_string(Float(code));
 				break;
 			case T_BOOL:
 				token_str += std::to_string(Bool());
 				break;
 			case T_STR:
 			case T_ID:
-				token_str += String();
+				token_str += String(code);
 				break;
 			case T_KW:
 				token_str += kw_to_str(kw());
@@ -280,13 +330,11 @@ struct Token {
 		}
 		token_str += "`";
 
-		if(with_pos){
-			token_str += " at " + std::to_string(pos.line) + ":" + std::to_string(pos.column);
-		}
-		// TODO: Add op and kw to string
-
 		return token_str;
 	}
 };
 
+static_assert(sizeof(Token) == 16, "Token must be 16 bytes");
+static_assert(std::is_trivially_copyable<Token>::value, "Token must be trivially copyable");
+
 #endif
\ No newline at end of file
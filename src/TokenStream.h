@@ -0,0 +1,93 @@
+#ifndef TOKENSTREAM_H
+#define TOKENSTREAM_H
+
+#include <vector>
+#include <array>
+#include <span>
+#include <string_view>
+
+#include "Token.h"
+
+// TokenSource is anything Parser can pull tokens from one by one.
+// After the end it must keep returning `T_PROG_END` token.
+class TokenSource {
+	public:
+		virtual ~TokenSource() = default;
+
+		virtual Token next_token() = 0;
+
+		// Code that tokens point to
+		virtual std::string_view get_code() = 0;
+};
+
+// TokenVector is TokenSource over already lexed tokens (e.g. from Lexer::lex)
+// Note: tokens are borrowed, not copied, so vector must outlive the TokenVector.
+// `base` is added to offsets of tokens, it's used for tokens stored relative to some point of code
+class TokenVector : public TokenSource {
+	public:
+		TokenVector(std::span <const Token> tokens, std::string_view code, const uint32_t & base = 0)
+				   : tokens(tokens), code(code), base(base), index(0) {}
+		virtual ~TokenVector() = default;
+
+		virtual Token next_token() override {
+			if(index < tokens.size()){
+				Token token = tokens[index++];
+				token.offset += base;
+				return token;
+			}
+			return Token{T_PROG_END, static_cast<uint32_t>(code.size()), 0, 0};
+		}
+
+		virtual std::string_view get_code() override {
+			return code;
+		}
+
+	private:
+		std::span <const Token> tokens;
+		std::string_view code;
+		uint32_t base;
+		uint32_t index;
+};
+
+// TokenStream keeps small ring buffer of lookahead tokens pulled from TokenSource on demand,
+// so tokens memory is O(LOOKAHEAD) and not O(file)
+class TokenStream {
+	public:
+		// Note: Must be power of 2
+		static const uint32_t LOOKAHEAD = 4;
+
+		TokenStream() : source(nullptr), head(0), count(0) {}
+		virtual ~TokenStream() = default;
+
+		void reset(TokenSource * source){
+			this->source = source;
+			head = 0;
+			count = 0;
+		}
+
+		// Get token `offset` tokens after current one
+		// Note: offset must be less than LOOKAHEAD
+		Token & peek(const uint32_t & offset = 0){
+			while(count <= offset){
+				ring[(head + count) & (LOOKAHEAD - 1)] = source->next_token();
+				count++;
+			}
+			return ring[(head + offset) & (LOOKAHEAD - 1)];
+		}
+
+		// Drop current token and return the next one
+		Token & advance(){
+			peek();
+			head = (head + 1) & (LOOKAHEAD - 1);
+			count--;
+			return peek();
+		}
+
+	private:
+		TokenSource * source;
+		std::array <Token, LOOKAHEAD> ring;
+		uint32_t head;
+		uint32_t count;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "Trace.h"
+
+#include <mutex>
+
+namespace {
+	std::mutex sink_mutex;
+	std::FILE * sink = stderr;
+
+	// Buffer is flushed when thread exits
+	struct ThreadBuffer {
+		std::string buffer;
+
+		~ThreadBuffer(){
+			if(!buffer.empty()){
+				std::lock_guard <std::mutex> lock(sink_mutex);
+				std::fwrite(buffer.data(), 1, buffer.size(), sink);
+				std::fflush(sink);
+			}
+		}
+	};
+}
+
+void Trace::set_sink(std::FILE * new_sink){
+	flush();
+	std::lock_guard <std::mutex> lock(sink_mutex);
+	sink = new_sink;
+}
+
+std::string & Trace::thread_buffer(){
+	static thread_local ThreadBuffer thread_buffer;
+	return thread_buffer.buffer;
+}
+
+void Trace::flush(){
+	flush(thread_buffer());
+}
+
+void Trace::flush(std::string & buffer){
+	if(buffer.empty()){
+		return;
+	}
+	std::lock_guard <std::mutex> lock(sink_mutex);
+	std::fwrite(buffer.data(), 1, buffer.size(), sink);
+	std::fflush(sink);
+	buffer.clear();
+}
+
+void Trace::append_prefix(std::string & buffer, const TraceLevel & level, const TraceCategory & category){
+	switch(category){
+		case TC_LEXER: buffer += "[Lexer"; break;
+		case TC_PARSER: buffer += "[Parser"; break;
+		case TC_EVAL: buffer += "[Eval"; break;
+		case TC_GC: buffer += "[GC"; break;
+		default: buffer += "[Trace";
+	}
+	switch(level){
+		case TL_ERROR: buffer += " ERROR] "; break;
+		case TL_WARN: buffer += " WARN] "; break;
+		case TL_INFO: buffer += " INFO] "; break;
+		case TL_DEBUG: buffer += " DEBUG] "; break;
+		case TL_VERBOSE: buffer += " VERBOSE] "; break;
+		default: buffer += "] ";
+	}
+}
@@ -0,0 +1,116 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <type_traits>
+
+// Trace is debug output facility for Lexer, Parser and interpreter.
+//
+// Compile-time: Build with `JACY_TRACE=0` to remove all TRACE calls from code (it's default for NDEBUG builds).
+// Runtime: Nothing is written until level and categories are enabled by `Trace::configure`.
+// Disabled TRACE is one branch, enabled TRACE is one append to per-thread buffer
+// that's flushed to sink when it's full, on `Trace::flush` or on thread exit.
+//
+// Usage: TRACE(TL_DEBUG, TC_LEXER, "Skip comment of ", length, " bytes");
+// Note: Arguments are not evaluated if trace is disabled
+
+#ifndef JACY_TRACE
+	#ifdef NDEBUG
+		#define JACY_TRACE 0
+	#else
+		#define JACY_TRACE 1
+	#endif
+#endif
+
+enum TraceLevel : uint8_t {
+	TL_OFF,
+	TL_ERROR,
+	TL_WARN,
+	TL_INFO,
+	TL_DEBUG,
+	TL_VERBOSE
+};
+
+enum TraceCategory : uint32_t {
+	TC_LEXER = 1 << 0,
+	TC_PARSER = 1 << 1,
+	TC_EVAL = 1 << 2,
+	TC_GC = 1 << 3,
+	TC_ALL = 0xFFFFFFFF
+};
+
+class Trace {
+	public:
+		static void configure(const TraceLevel & level, const uint32_t & categories){
+			max_level.store(level, std::memory_order_relaxed);
+			enabled_categories.store(categories, std::memory_order_relaxed);
+		}
+
+		// Note: Sink is not closed by Trace
+		static void set_sink(std::FILE * sink);
+
+		static bool enabled(const TraceLevel & level, const TraceCategory & category){
+			return level <= max_level.load(std::memory_order_relaxed)
+				&& (enabled_categories.load(std::memory_order_relaxed) & category);
+		}
+
+		template <class ...Args>
+		static void write(const TraceLevel & level, const TraceCategory & category, const Args & ...args){
+			std::string & buffer = thread_buffer();
+			append_prefix(buffer, level, category);
+			(append(buffer, args), ...);
+			buffer += '\n';
+			if(buffer.size() >= FLUSH_SIZE){
+				flush(buffer);
+			}
+		}
+
+		// Flush buffer of current thread
+		static void flush();
+
+	private:
+		static const uint32_t FLUSH_SIZE = 64 * 1024;
+
+		static inline std::atomic <uint8_t> max_level = TL_OFF;
+		static inline std::atomic <uint32_t> enabled_categories = 0;
+
+		static std::string & thread_buffer();
+		static void flush(std::string & buffer);
+		static void append_prefix(std::string & buffer, const TraceLevel & level, const TraceCategory & category);
+
+		static void append(std::string & buffer, std::string_view str){
+			buffer += str;
+		}
+		static void append(std::string & buffer, const char * str){
+			buffer += str;
+		}
+		static void append(std::string & buffer, const std::string & str){
+			buffer += str;
+		}
+		static void append(std::string & buffer, const char & c){
+			buffer += c;
+		}
+		static void append(std::string & buffer, const bool & b){
+			buffer += b ? "true" : "false";
+		}
+		template <class T, class = std::enable_if_t<std::is_arithmetic_v<T>>>
+		static void append(std::string & buffer, const T & number){
+			char chars[32];
+			const auto result = std::to_chars(chars, chars + sizeof(chars), number);
+			buffer.append(chars, result.ptr);
+		}
+};
+
+#if JACY_TRACE
+	#define TRACE(level, category, ...) \
+		do{ if(Trace::enabled(level, category)){ Trace::write(level, category, __VA_ARGS__); } }while(0)
+#else
+	#define TRACE(level, category, ...) do{}while(0)
+#endif
+
+#endif
@@ -0,0 +1,542 @@
+#include "VM.h"
+
+#if defined(__GNUC__) && !defined(JACY_VM_SWITCH)
+	#define VM_COMPUTED_GOTO 1
+#else
+	#define VM_COMPUTED_GOTO 0
+#endif
+
+VM::VM(){
+	stack.reset(new Value[STACK_SIZE]);
+	top = stack.get();
+	frames.reset(new Frame[MAX_FRAMES]);
+	frame_top = nullptr;
+	open_upvalues = nullptr;
+	heap().add_roots(this);
+}
+
+VM::~VM(){
+	heap().remove_roots(this);
+}
+
+void VM::trace_roots(Heap & heap){
+	heap.mark(stack.get(), top);
+	heap.mark(globals.data(), globals.data() + globals.size());
+	if(frame_top != nullptr){
+		for(const Frame * frame = frames.get(); frame <= frame_top; frame++){
+			heap.mark(frame->func);
+		}
+	}
+	for(Upvalue * upvalue = open_upvalues; upvalue != nullptr; upvalue = upvalue->next){
+		heap.mark(upvalue);
+	}
+}
+
+Upvalue * VM::capture(Value * slot){
+	Upvalue ** link = &open_upvalues;
+	while(*link != nullptr && (*link)->location > slot){
+		link = &(*link)->next;
+	}
+	if(*link != nullptr && (*link)->location == slot){
+		return *link;
+	}
+	Upvalue * upvalue = heap().make<Upvalue>(slot);
+	upvalue->next = *link;
+	*link = upvalue;
+	return upvalue;
+}
+
+void VM::close_upvalues(const Value * from){
+	while(open_upvalues != nullptr && open_upvalues->location >= from){
+		Upvalue * upvalue = open_upvalues;
+		open_upvalues = upvalue->next;
+		upvalue->close();
+	}
+}
+
+// Note: Division of 64-bit ints is a few times slower than of 32-bit ones on x86,
+// so small ints that fit in 32 bits (mostly all of them) are divided as 32-bit
+static inline int64_t int_div(const int64_t & a, const int64_t & b){
+	if(a == static_cast<int32_t>(a) && b == static_cast<int32_t>(b)){
+		return static_cast<int32_t>(a) / static_cast<int32_t>(b);
+	}
+	return a / b;
+}
+
+static inline int64_t int_mod(const int64_t & a, const int64_t & b){
+	if(a == static_cast<int32_t>(a) && b == static_cast<int32_t>(b)){
+		return static_cast<int32_t>(a) % static_cast<int32_t>(b);
+	}
+	return a % b;
+}
+
+// Note: GCC merges same tails of handlers into one dispatch jump, it's worse predicted than a jump per handler
+#if VM_COMPUTED_GOTO && !defined(__clang__)
+	#pragma GCC push_options
+	#pragma GCC optimize("no-crossjumping")
+#endif
+void VM::run(const Program & program){
+	const std::vector <NativeFunc*> & builtin_funcs = builtins();
+	globals.assign(program.globals.size(), Value::undefined());
+	for(size_t i = 0; i < builtin_funcs.size(); i++){
+		globals[i] = Value::object(builtin_funcs[i]);
+	}
+
+	const Value true_value = Value::boolean(true);
+	const Value false_value = Value::boolean(false);
+
+	Value * const stack_end = stack.get() + STACK_SIZE;
+	const Frame * const last_frame = frames.get() + MAX_FRAMES - 1;
+	top = stack.get();
+	frame_top = nullptr;
+	open_upvalues = nullptr;
+
+	// Registers of current frame
+	Frame * frame;
+	const uint32_t * code;
+	const uint32_t * ip;
+	const Value * constants;
+	Upvalue ** upvalues;
+	Value * locals;
+	Value * sp;
+	uint32_t instruction;
+
+	Heap & gc = heap();
+	// Note: Globals are not added after start, so their data is kept in register
+	Value * const global_values = globals.data();
+
+// Note: Frame is entered by macro, not lambda, because lambda takes registers by reference
+// and compiler keeps them in memory in the whole loop
+#define VM_ENTER(callee_frame, callee, callee_upvalues, callee_base, callee_args) do{ \
+		frame = callee_frame; \
+		*frame = Frame{callee, callee_upvalues, nullptr, callee_base, callee_args}; \
+		code = (callee)->chunk.code.data(); \
+		ip = code; \
+		constants = (callee)->chunk.constants.data(); \
+		upvalues = callee_upvalues; \
+		locals = callee_base; \
+		for(uint32_t i = callee_args; i < (callee)->local_count; i++){ \
+			locals[i] = Value::null(); \
+		} \
+		sp = locals + (callee)->local_count; \
+	}while(0)
+
+	VM_ENTER(frames.get(), program.main, nullptr, stack.get(), 0);
+
+// Offset in source code of current instruction
+#define VM_OFFSET() (frame->func->chunk.offsets[ip - 1 - code])
+#define VM_ARG() instruction_arg(instruction)
+// Note: Stack above `top` is not traced, so collection is done only where stack is consistent
+// Note: Globals are `undefined` until `DEFINE_GLOBAL`
+#define VM_NOT_DEFINED(slot) throw RuntimeError("`" + std::string(symbol_str(program.globals[slot])) + "` is not defined", VM_OFFSET())
+#define VM_SAFEPOINT() do{ if(gc.is_collection_requested()){ top = sp; frame_top = frame; gc.collect(); } }while(0)
+
+#if VM_COMPUTED_GOTO
+	// Note: Table is not static, so addresses of labels are not relocated at load time
+	void * const labels[BC_COUNT] = {
+	#define VM_LABEL(name) &&op_##name,
+		BYTECODE_OPCODES(VM_LABEL)
+	#undef VM_LABEL
+	};
+	#define VM_CASE(name) op_##name:
+	#define VM_NEXT() do{ instruction = *ip++; goto *labels[instruction_op(instruction)]; }while(0)
+
+	VM_NEXT();
+#else
+	#define VM_CASE(name) case BC_##name:
+	#define VM_NEXT() continue
+
+	while(true){
+		instruction = *ip++;
+		switch(instruction_op(instruction)){
+#endif
+
+	VM_CASE(CONST){
+		*sp++ = constants[VM_ARG()];
+		VM_NEXT();
+	}
+	VM_CASE(LOAD_NULL){
+		*sp++ = Value::null();
+		VM_NEXT();
+	}
+	VM_CASE(LOAD_TRUE){
+		*sp++ = true_value;
+		VM_NEXT();
+	}
+	VM_CASE(LOAD_FALSE){
+		*sp++ = false_value;
+		VM_NEXT();
+	}
+	VM_CASE(POP){
+		sp--;
+		VM_NEXT();
+	}
+	VM_CASE(DUP){
+		sp[0] = sp[-1];
+		sp++;
+		VM_NEXT();
+	}
+	VM_CASE(DUP2){
+		sp[0] = sp[-2];
+		sp[1] = sp[-1];
+		sp += 2;
+		VM_NEXT();
+	}
+	VM_CASE(SWAP){
+		std::swap(sp[-1], sp[-2]);
+		VM_NEXT();
+	}
+	VM_CASE(LOAD_LOCAL){
+		*sp++ = locals[VM_ARG()];
+		VM_NEXT();
+	}
+	VM_CASE(LOAD_LOCAL2){
+		sp[0] = locals[pair_first(VM_ARG())];
+		sp[1] = locals[pair_second(VM_ARG())];
+		sp += 2;
+		VM_NEXT();
+	}
+	VM_CASE(STORE_LOCAL){
+		locals[VM_ARG()] = sp[-1];
+		VM_NEXT();
+	}
+	VM_CASE(SET_LOCAL){
+		locals[VM_ARG()] = *--sp;
+		VM_NEXT();
+	}
+	VM_CASE(LOAD_GLOBAL){
+		const Value value = global_values[VM_ARG()];
+		if(value.is_undefined()){
+			VM_NOT_DEFINED(VM_ARG());
+		}
+		*sp++ = value;
+		VM_NEXT();
+	}
+	VM_CASE(STORE_GLOBAL){
+		Value & global = global_values[VM_ARG()];
+		if(global.is_undefined()){
+			VM_NOT_DEFINED(VM_ARG());
+		}
+		global = sp[-1];
+		VM_NEXT();
+	}
+	VM_CASE(SET_GLOBAL){
+		Value & global = global_values[VM_ARG()];
+		if(global.is_undefined()){
+			VM_NOT_DEFINED(VM_ARG());
+		}
+		global = *--sp;
+		VM_NEXT();
+	}
+	// Note: Increment is mostly a counter of loop, it's done in place on small ints like `ADD`
+#define VM_INCREMENT(name, variable) \
+	VM_CASE(name){ \
+		Value & target = variable; \
+		const Value step = constants[pair_second(VM_ARG())]; \
+		if(target.is_small_int() && step.is_small_int()){ \
+			target = Value::integer(target.as_small_int() + step.as_small_int()); \
+		}else{ \
+			target = call_infix(target, OP_ADD, step, VM_OFFSET()); \
+		} \
+		VM_NEXT(); \
+	}
+	VM_INCREMENT(INC_LOCAL, locals[pair_first(VM_ARG())])
+	VM_INCREMENT(INC_GLOBAL, global_values[pair_first(VM_ARG())])
+#undef VM_INCREMENT
+	VM_CASE(DEFINE_GLOBAL){
+		global_values[VM_ARG()] = *--sp;
+		VM_NEXT();
+	}
+	VM_CASE(LOAD_UPVALUE){
+		*sp++ = *upvalues[VM_ARG()]->location;
+		VM_NEXT();
+	}
+	VM_CASE(STORE_UPVALUE){
+		upvalues[VM_ARG()]->set(sp[-1]);
+		VM_NEXT();
+	}
+	VM_CASE(SET_UPVALUE){
+		upvalues[VM_ARG()]->set(*--sp);
+		VM_NEXT();
+	}
+
+	// Note: Operators on small ints are done in place (without allocation), others are operator functions.
+	// Operands are 48-bit, so only multiplication can overflow (it wraps around as int operator function),
+	// division by zero is left to the operator function.
+	// Left operand is on the stack (and result replaces it) or it's variable and result is pushed (`push` is `sp++`).
+	// Result is mostly assigned to variable, so `SET_LOCAL` or `SET_GLOBAL` after it is done here like jump after comparison
+#define VM_INT_ARITHMETIC(name, left_operand, right_operand, push, op, expr, guard) \
+	VM_CASE(name){ \
+		const Value right = right_operand; \
+		const Value left = left_operand; \
+		push; \
+		if(left.is_small_int() && right.is_small_int()){ \
+			const int64_t a = left.as_small_int(); \
+			const int64_t b = right.as_small_int(); \
+			if(guard){ \
+				const Value result = Value::integer(expr); \
+				const uint32_t next = *ip; \
+				if(instruction_op(next) == BC_SET_LOCAL){ \
+					locals[instruction_arg(next)] = result; \
+					sp--; \
+					ip++; \
+					VM_NEXT(); \
+				} \
+				if(instruction_op(next) == BC_SET_GLOBAL && !global_values[instruction_arg(next)].is_undefined()){ \
+					global_values[instruction_arg(next)] = result; \
+					sp--; \
+					ip++; \
+					VM_NEXT(); \
+				} \
+				sp[-1] = result; \
+				VM_NEXT(); \
+			} \
+		} \
+		sp[-1] = call_infix(left, op, right, VM_OFFSET()); \
+		VM_NEXT(); \
+	}
+	// Note: Comparison is mostly a condition, so the conditional jump after it is done here,
+	// without push of bool and dispatch of the jump (jump can be a jump target itself, so it stays in code)
+#define VM_INT_COMPARISON(name, left_operand, right_operand, push, op, cmp) \
+	VM_CASE(name){ \
+		const Value right = right_operand; \
+		const Value left = left_operand; \
+		push; \
+		if(left.is_small_int() && right.is_small_int()){ \
+			const bool result = left.as_small_int() cmp right.as_small_int(); \
+			const uint32_t next = *ip; \
+			if(instruction_op(next) == BC_JUMP_IF_TRUE || instruction_op(next) == BC_JUMP_IF_FALSE){ \
+				sp--; \
+				ip++; \
+				if(result == (instruction_op(next) == BC_JUMP_IF_TRUE)){ \
+					ip = code + instruction_arg(next); \
+					VM_SAFEPOINT(); \
+				} \
+				VM_NEXT(); \
+			} \
+			sp[-1] = result ? true_value : false_value; \
+		}else{ \
+			sp[-1] = call_infix(left, op, right, VM_OFFSET()); \
+		} \
+		VM_NEXT(); \
+	}
+#define VM_INT_OPERATORS(suffix, left_operand, right_operand, push) \
+	VM_INT_ARITHMETIC(ADD##suffix, left_operand, right_operand, push, OP_ADD, a + b, true) \
+	VM_INT_ARITHMETIC(SUB##suffix, left_operand, right_operand, push, OP_SUB, a - b, true) \
+	VM_INT_ARITHMETIC(MUL##suffix, left_operand, right_operand, push, OP_MUL, \
+					  static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b)), true) \
+	VM_INT_ARITHMETIC(DIV##suffix, left_operand, right_operand, push, OP_DIV, int_div(a, b), b > 0) \
+	VM_INT_ARITHMETIC(MOD##suffix, left_operand, right_operand, push, OP_MOD, int_mod(a, b), b > 0) \
+	VM_INT_COMPARISON(LESS##suffix, left_operand, right_operand, push, OP_LESS, <) \
+	VM_INT_COMPARISON(LESS_EQUAL##suffix, left_operand, right_operand, push, OP_LESS_EQUAL, <=) \
+	VM_INT_COMPARISON(GREATER##suffix, left_operand, right_operand, push, OP_GREATER, >) \
+	VM_INT_COMPARISON(GREATER_EQUAL##suffix, left_operand, right_operand, push, OP_GREATER_EQUAL, >=) \
+	VM_INT_COMPARISON(EQUAL##suffix, left_operand, right_operand, push, OP_EQUAL, ==) \
+	VM_INT_COMPARISON(NOT_EQUAL##suffix, left_operand, right_operand, push, OP_NOT_EQUAL, !=)
+
+	VM_INT_OPERATORS(, sp[-1], *--sp, )
+	VM_INT_OPERATORS(_CONST, sp[-1], constants[VM_ARG()], )
+	VM_INT_OPERATORS(_LOCAL, sp[-1], locals[VM_ARG()], )
+	VM_INT_OPERATORS(_LOCAL_CONST, locals[pair_first(VM_ARG())], constants[pair_second(VM_ARG())], sp++)
+	VM_INT_OPERATORS(_LOCAL_LOCAL, locals[pair_first(VM_ARG())], locals[pair_second(VM_ARG())], sp++)
+	VM_INT_OPERATORS(_GLOBAL_CONST, global_values[pair_first(VM_ARG())], constants[pair_second(VM_ARG())], sp++)
+
+#undef VM_INT_ARITHMETIC
+#undef VM_INT_OPERATORS
+#undef VM_INT_COMPARISON
+
+	VM_CASE(INFIX){
+		const Value right = *--sp;
+		sp[-1] = call_infix(sp[-1], static_cast<Operator>(VM_ARG()), right, VM_OFFSET());
+		VM_NEXT();
+	}
+	VM_CASE(PREFIX){
+		sp[-1] = call_prefix(static_cast<Operator>(VM_ARG()), sp[-1], VM_OFFSET());
+		VM_NEXT();
+	}
+	VM_CASE(JUMP){
+		ip = code + VM_ARG();
+		VM_SAFEPOINT();
+		VM_NEXT();
+	}
+	VM_CASE(JUMP_IF_FALSE){
+		const Value value = *--sp;
+		if(value != true_value && (value == false_value || !value.to_bool())){
+			ip = code + VM_ARG();
+		}
+		VM_NEXT();
+	}
+	VM_CASE(JUMP_IF_TRUE){
+		const Value value = *--sp;
+		if(value == true_value || (value != false_value && value.to_bool())){
+			ip = code + VM_ARG();
+		}
+		VM_SAFEPOINT();
+		VM_NEXT();
+	}
+	VM_CASE(JUMP_IF_NOT_NULL){
+		if(!sp[-1].is_null()){
+			ip = code + VM_ARG();
+		}else{
+			sp--;
+		}
+		VM_NEXT();
+	}
+	VM_CASE(LIST){
+		const uint32_t count = VM_ARG();
+		std::vector <Value> items(sp - count, sp);
+		sp -= count;
+		*sp++ = Value::object(heap().make<List>(std::move(items)));
+		VM_NEXT();
+	}
+	VM_CASE(GET_ITEM){
+		const Value index = *--sp;
+		sp[-1] = get_item(sp[-1], index, VM_OFFSET());
+		VM_NEXT();
+	}
+	VM_CASE(SET_ITEM){
+		const Value value = *--sp;
+		const Value index = *--sp;
+		sp[-1] = set_item(sp[-1], index, value, VM_OFFSET());
+		VM_NEXT();
+	}
+	VM_CASE(ITER){
+		const Value iterable = *--sp;
+		if(!iterable.is(OT_LIST) && !iterable.is(OT_STRING)){
+			throw RuntimeError("Object of type " + type_name(iterable) + " is not iterable", VM_OFFSET());
+		}
+		locals[VM_ARG()] = iterable;
+		locals[VM_ARG() + 1] = Value::integer(0);
+		VM_NEXT();
+	}
+	VM_CASE(FOR_NEXT){
+		Object * iterable = locals[VM_ARG()].as_object();
+		const uint64_t index = locals[VM_ARG() + 1].as_small_int();
+		// Note: List can be changed by the loop, so size is checked on each iteration
+		if(iterable->type == OT_LIST){
+			const std::vector <Value> & items = static_cast<List*>(iterable)->items;
+			if(index < items.size()){
+				*sp++ = items[index];
+				locals[VM_ARG() + 1] = Value::integer(index + 1);
+				ip++;
+			}
+		}else{
+			const std::string & str = static_cast<String*>(iterable)->value;
+			if(index < str.size()){
+				*sp++ = Value::object(char_string(str[index]));
+				locals[VM_ARG() + 1] = Value::integer(index + 1);
+				ip++;
+			}
+		}
+		VM_NEXT();
+	}
+	VM_CASE(CALL){
+		const uint32_t arg_count = VM_ARG();
+		const Value callee = sp[-static_cast<int32_t>(arg_count) - 1];
+		// Note: Type of callee is read once, not by each `is`
+		const ObjectType callee_type = callee.is_object() ? callee.as_object()->type : OT_NULL;
+		if(callee_type == OT_COMPILED_FUNC || callee_type == OT_CLOSURE){
+			CompiledFunc * func;
+			Upvalue ** func_upvalues = nullptr;
+			if(callee_type == OT_CLOSURE){
+				Closure * closure = static_cast<Closure*>(callee.as_object());
+				func = closure->func;
+				func_upvalues = closure->upvalues.data();
+			}else{
+				func = static_cast<CompiledFunc*>(callee.as_object());
+			}
+			if(arg_count > func->arg_names.size()){
+				throw RuntimeError("Too many arguments for " + func->to_string(), VM_OFFSET());
+			}
+			if(arg_count < func->required_args){
+				throw RuntimeError("Missing argument `" + std::string(symbol_str(func->arg_names[arg_count]))
+								   + "` of " + func->to_string(), VM_OFFSET());
+			}
+			Value * base = sp - arg_count;
+			if(frame == last_frame || base + func->local_count + func->max_stack > stack_end){
+				throw RuntimeError("Stack overflow", VM_OFFSET());
+			}
+			frame->ip = ip;
+			VM_ENTER(frame + 1, func, func_upvalues, base, arg_count);
+			VM_SAFEPOINT();
+			VM_NEXT();
+		}
+		if(callee_type == OT_NATIVE_FUNC){
+			Value result;
+			try{
+				result = static_cast<NativeFunc*>(callee.as_object())->function(std::span <Value>(sp - arg_count, arg_count));
+			}catch(RuntimeError & e){
+				e.offset = VM_OFFSET();
+				throw;
+			}
+			sp -= arg_count;
+			sp[-1] = result;
+			VM_NEXT();
+		}
+		throw RuntimeError("Object of type " + type_name(callee) + " is not callable", VM_OFFSET());
+	}
+	VM_CASE(CLOSURE){
+		CompiledFunc * func = static_cast<CompiledFunc*>(constants[VM_ARG()].as_object());
+		Closure * closure = heap().make<Closure>(func);
+		for(size_t i = 0; i < func->upvalues.size(); i++){
+			const UpvalueDesc & upvalue = func->upvalues[i];
+			closure->upvalues[i] = upvalue.is_local ? capture(locals + upvalue.index) : upvalues[upvalue.index];
+		}
+		*sp++ = Value::object(closure);
+		VM_NEXT();
+	}
+	VM_CASE(CLOSE_UPVALUES){
+		close_upvalues(locals + VM_ARG());
+		VM_NEXT();
+	}
+	VM_CASE(ARG_DEFAULT){
+		if(frame->arg_count <= VM_ARG()){
+			ip++;
+		}
+		VM_NEXT();
+	}
+#define VM_RETURN(name, result_value) \
+	VM_CASE(name){ \
+		const Value result = result_value; \
+		Value * base = frame->base; \
+		if(open_upvalues != nullptr){ \
+			close_upvalues(base); \
+		} \
+		if(frame == frames.get()){ \
+			frame_top = nullptr; \
+			return; \
+		} \
+		frame--; \
+		code = frame->func->chunk.code.data(); \
+		ip = frame->ip; \
+		constants = frame->func->chunk.constants.data(); \
+		upvalues = frame->upvalues; \
+		locals = frame->base; \
+		/* Note: Result replaces callee object */ \
+		sp = base; \
+		sp[-1] = result; \
+		VM_NEXT(); \
+	}
+	VM_RETURN(RETURN, sp[-1])
+	VM_RETURN(RETURN_LOCAL, locals[VM_ARG()])
+#undef VM_RETURN
+
+#if !VM_COMPUTED_GOTO
+			default:{
+				throw RuntimeError("Invalid instruction " + std::to_string(instruction_op(instruction)), VM_OFFSET());
+			}
+		}
+	}
+#endif
+
+#undef VM_ENTER
+#undef VM_CASE
+#undef VM_NEXT
+#undef VM_OFFSET
+#undef VM_ARG
+#undef VM_SAFEPOINT
+#undef VM_NOT_DEFINED
+}
+#if VM_COMPUTED_GOTO && !defined(__clang__)
+	#pragma GCC pop_options
+#endif
@@ -0,0 +1,61 @@
+#ifndef VM_H
+#define VM_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "Bytecode.h"
+
+// VM runs bytecode of Compiler on the stack of values.
+// Frame of function is its locals (arguments first) followed by operand stack,
+// callee object is kept right below the frame and result of call replaces it.
+// Upvalues of locals captured by closures are open while their slots are alive,
+// they're closed by `CLOSE_UPVALUES` at the end of block and by return.
+// Dispatch is threaded (computed goto) when compiler supports labels as values,
+// otherwise it's switch in loop (also with `JACY_VM_SWITCH`).
+// Note: VM is about 10x faster than tree walker (bench/VmSpeedup.cpp, 9.7-11.5x on globals, locals and calls),
+// common sequences of loads, operators and stores are merged into one instruction by Compiler
+// Errors are thrown as RuntimeError at offset of instruction.
+// VM is the root of Heap for its stack, globals and functions of frames,
+// collection is done on backward jumps and calls (see `VM_SAFEPOINT`).
+class VM : public RootProvider {
+	public:
+		VM();
+		virtual ~VM();
+
+		void run(const Program & program);
+
+		virtual void trace_roots(Heap & heap) override;
+
+	private:
+		static const uint32_t STACK_SIZE = 1 << 20;
+		static const uint32_t MAX_FRAMES = 10000;
+
+		struct Frame {
+			CompiledFunc * func;
+			// Upvalues of closure (callee object keeps them alive)
+			Upvalue ** upvalues;
+			const uint32_t * ip;
+			Value * base;
+			uint32_t arg_count;
+		};
+
+		std::unique_ptr <Value[]> stack;
+		// Top of stack at safepoint, the stack pointer itself is a register of `run`
+		Value * top;
+		std::unique_ptr <Frame[]> frames;
+		// Current frame at safepoint (null if none is running), the frame pointer itself is a register of `run`
+		Frame * frame_top;
+
+		// Open upvalues ordered by slot from top of stack, so closing of scope takes them from the head
+		Upvalue * open_upvalues;
+		Upvalue * capture(Value * slot);
+		void close_upvalues(const Value * from);
+
+		// Note: Globals are defined by `DEFINE_GLOBAL` at runtime, access before it is an error,
+		// not defined global is `undefined` (it is never a value of program)
+		std::vector <Value> globals;
+};
+
+#endif
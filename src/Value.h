@@ -0,0 +1,161 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+class Object;
+
+// Note: Tag is checked instead of dynamic_cast in hot paths (e.g. int arithmetic in VM)
+// null, bool and float are never objects, int is an object only if it doesn't fit in Value (see `Value::integer`)
+enum ObjectType : uint8_t {
+	OT_NULL,
+	OT_INT,
+	OT_FLOAT,
+	OT_BOOL,
+	OT_STRING,
+	OT_LIST,
+	OT_FUNC,
+	OT_NATIVE_FUNC,
+	OT_COMPILED_FUNC,
+	OT_CLOSURE
+};
+
+/**
+ * Value is 64-bit NaN-boxed runtime value, it's passed by value.
+ *
+ * Float is stored as double as is. Other values are quiet NaNs that cannot be produced by arithmetic
+ * (NaN result is stored as canonical NaN), they're marked by QNAN bits:
+ *  object:  1 | QNAN | 48-bit pointer
+ *  int:     0 | QNAN | TAG_INT | 48-bit signed int
+ *  special: 0 | QNAN | TAG_SPECIAL | null, false, true or undefined
+ *
+ * Int that doesn't fit in 48 bits is heap Int object, so arithmetic on small ints doesn't allocate.
+ * `undefined` is never a value of program, it marks missing result (e.g. operator is not supported).
+ */
+class Value {
+	public:
+		// Note: Default Value is null
+		Value() : bits(NULL_BITS) {}
+
+		static Value null(){
+			return from_bits(NULL_BITS);
+		}
+		static Value undefined(){
+			return from_bits(UNDEFINED_BITS);
+		}
+		static Value boolean(const bool & value){
+			return from_bits(value ? TRUE_BITS : FALSE_BITS);
+		}
+		static Value number(const double & value){
+			if(value != value){
+				return from_bits(CANONICAL_NAN);
+			}
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return from_bits(bits);
+		}
+		static Value integer(const int64_t & value){
+			if(value < SMALL_INT_MIN || value > SMALL_INT_MAX){
+				return big_integer(value);
+			}
+			return from_bits(QNAN | TAG_INT | (static_cast<uint64_t>(value) & PAYLOAD_MASK));
+		}
+		// Note: nullptr is null
+		static Value object(Object * object){
+			if(!object){
+				return null();
+			}
+			return from_bits(SIGN_BIT | QNAN | reinterpret_cast<uintptr_t>(object));
+		}
+
+		bool is_null() const {
+			return bits == NULL_BITS;
+		}
+		bool is_undefined() const {
+			return bits == UNDEFINED_BITS;
+		}
+		bool is_bool() const {
+			return bits == TRUE_BITS || bits == FALSE_BITS;
+		}
+		bool is_float() const {
+			return (bits & QNAN) != QNAN;
+		}
+		bool is_small_int() const {
+			return (bits & (SIGN_BIT | QNAN | TAG_MASK)) == (QNAN | TAG_INT);
+		}
+		bool is_object() const {
+			return (bits & (SIGN_BIT | QNAN)) == (SIGN_BIT | QNAN);
+		}
+		// Small int or Int object
+		bool is_int() const;
+		bool is_number() const {
+			return is_float() || is_int();
+		}
+		bool is(const ObjectType & type) const;
+
+		bool as_bool() const {
+			return bits == TRUE_BITS;
+		}
+		double as_float() const {
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+		int64_t as_small_int() const {
+			// Note: Sign of 48-bit payload is extended by arithmetic shift
+			return static_cast<int64_t>(bits << 16) >> 16;
+		}
+		int64_t as_int() const;
+		// Int or float as double
+		double as_number() const {
+			return is_float() ? as_float() : static_cast<double>(as_int());
+		}
+		Object * as_object() const {
+			return reinterpret_cast<Object*>(static_cast<uintptr_t>(bits & PAYLOAD_MASK));
+		}
+
+		ObjectType type() const;
+
+		bool to_bool() const;
+		std::string to_string() const;
+
+		// Identity, numbers equal by value are compared by `==` operator
+		bool operator==(const Value & other) const {
+			return bits == other.bits;
+		}
+		bool operator!=(const Value & other) const {
+			return bits != other.bits;
+		}
+
+	private:
+		static constexpr uint64_t SIGN_BIT = 0x8000000000000000;
+		static constexpr uint64_t QNAN = 0x7ffc000000000000;
+		static constexpr uint64_t CANONICAL_NAN = 0x7ff8000000000000;
+		static constexpr uint64_t TAG_MASK = 0x0003000000000000;
+		static constexpr uint64_t TAG_SPECIAL = 0x0000000000000000;
+		static constexpr uint64_t TAG_INT = 0x0001000000000000;
+		static constexpr uint64_t PAYLOAD_MASK = 0x0000ffffffffffff;
+
+		static constexpr uint64_t NULL_BITS = QNAN | TAG_SPECIAL | 1;
+		static constexpr uint64_t FALSE_BITS = QNAN | TAG_SPECIAL | 2;
+		static constexpr uint64_t TRUE_BITS = QNAN | TAG_SPECIAL | 3;
+		static constexpr uint64_t UNDEFINED_BITS = QNAN | TAG_SPECIAL | 4;
+
+		static constexpr int64_t SMALL_INT_MIN = -(int64_t(1) << 47);
+		static constexpr int64_t SMALL_INT_MAX = (int64_t(1) << 47) - 1;
+
+		static Value from_bits(const uint64_t & bits){
+			Value value;
+			value.bits = bits;
+			return value;
+		}
+
+		// Int object for value out of small int range
+		static Value big_integer(const int64_t & value);
+
+		uint64_t bits;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define ERROR_H
 
 #include <sstream>
+#include <cstdint>
 
 // TODO: Think about CursorErrorHandler class as Lexer, Token, Parser parent
 // It will contain line, column
@@ -18,11 +19,37 @@ struct Exception : std::exception {
     }
 };
 
-inline void err(const std::string & msg, uint32_t line, uint32_t column){
+inline std::string error_str(const std::string & msg, uint32_t line, uint32_t column){
 	std::stringstream output;
 	output << "\e[0;31m" << msg << " at " << line << ":" << column;
+	return output.str();
+}
+
+// Error of running code (Compiler or VM or tree walker), position is the byte offset in code,
+// it's converted to line:column by the caller that has the code
+// Note: Errors thrown by objects do not know offset, it's set by the evaluated node or instruction
+const uint32_t NO_OFFSET = UINT32_MAX;
+
+struct RuntimeError : Exception {
+	uint32_t offset;
+
+	RuntimeError(const std::string & msg, const uint32_t & offset = NO_OFFSET) : Exception(msg), offset(offset) {}
+};
 
-	throw Exception(output.str());
+inline void err(const std::string & msg, uint32_t line, uint32_t column){
+	throw Exception(error_str(msg, line, column));
 }
 
+// Error that was recorded without throwing (e.g. by Parser in recovery mode)
+struct Diagnostic {
+	std::string msg;
+	uint32_t offset;
+	uint32_t line;
+	uint32_t column;
+
+	std::string to_string() const {
+		return error_str(msg, line, column);
+	}
+};
+
 #endif
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 #include "Token.h"
 #include "Object.h"
+#include "FlatTree.h"
 
 struct NStatement;
 struct NExpression;
@@ -25,22 +26,37 @@ typedef std::vector<NTypeDecl*> TypeList;
 // Base nodes //
 ////////////////
 
+// Note: Nodes are allocated in Parser arena and never deleted by pointer,
+// destructor is not virtual, so nodes without lists are trivially destructible
+// and arena frees them without destructor calls
 struct Node {
 	Node(){}
-	virtual ~Node() = default;
+	~Node() = default;
 
-	// For errors in Node, sometimes position is the position of the last Token in statement or expression
-	Position pos;
+	// For errors in Node, sometimes offset is the offset of the last Token in statement or expression
+	// Note: Only byte offset in code is stored, it's converted to line:column by LineIndex on error
+	uint32_t offset;
 
-	virtual void error(const std::string msg){
-		err(msg + " at " + pos.line + ":" + pos.column);
+	// Node is shared by identical subtrees (see HashCons), so it must not be modified
+	// Note: Offset of shared node is the offset of its first occurrence
+	bool shared = false;
+
+	virtual void error(const std::string msg, const LineIndex & lines){
+		Position pos = lines.position(offset);
+		err(msg, pos.line, pos.column);
 	}
 
 	virtual std::string to_string(){
 		return "[NODE]";
 	}
 
-	virtual Object * eval(Scope * scope);
+	virtual Value eval(Scope * scope);
+
+	// Append node to flat encoding of tree, returns its index
+	virtual NodeIndex flatten(FlatTree & tree);
+
+	// Append direct children of node, so tree can be walked without recursion
+	virtual void get_children(std::vector <Node*> &) {}
 };
 
 struct NExpression : Node {
@@ -48,7 +64,7 @@ struct NExpression : Node {
 		return "[NExpression]";
 	}
 
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
 };
 
 inline std::string expression_list_to_string(const ExpressionList & expression_list, const std::string & sep){
@@ -69,7 +85,7 @@ struct NStatement : Node {
 		return "[NStatement]";
 	}
 
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
 };
 
 inline std::string statement_list_to_string(const StatementList & statements){
@@ -85,14 +101,16 @@ inline std::string statement_list_to_string(const StatementList & statements){
 struct NExpressionStatement : NStatement {
 	NExpression & expression;
 
-	NExpressionStatement(NExpression & expr, const Position & pos)
-						: expression(expr), pos(pos) {}
+	NExpressionStatement(NExpression & expr, const uint32_t & offset)
+						: expression(expr), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return expression.to_string();
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 /////////////////
@@ -100,48 +118,53 @@ struct NExpressionStatement : NStatement {
 /////////////////
 
 struct NInt : NExpression {
-	int value;
-	NInt(const int & value, const Position & pos) : value(value), pos(pos) {}
+	int64_t value;
+	NInt(const int64_t & value, const uint32_t & offset) : value(value), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return std::to_string(value);
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
 };
 
 // Note: NFloat contains 64-bit precision number like double does
 struct NFloat : NExpression {
 	double value;
-	NFloat(const double & value, const Position & pos) : value(value), pos(pos) {}
+	NFloat(const double & value, const uint32_t & offset) : value(value), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return std::to_string(value);
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
 };
 
 struct NBool : NExpression {
 	bool value;
-	NBool(const bool & value, const Position & pos) : value(value), pos(pos) {}
+	NBool(const bool & value, const uint32_t & offset) : value(value), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return (value ? "true" : "false");
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
 };
 
+// Note: String value is interned
 struct NString : NExpression {
-	std::string value;
-	NString(const std::string & value, const Position & pos) : value(value), pos(pos) {}
+	Symbol value;
+	NString(const Symbol & value, const uint32_t & offset) : value(value), offset(offset) {}
 
 	virtual std::string to_string() override {
-		return "'" + value + "'";
+		return "'" + std::string(symbol_str(value)) + "'";
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
 };
 
 //////////////////
@@ -149,33 +172,48 @@ struct NString : NExpression {
 //////////////////
 
 struct NIdentifier : NExpression {
-	std::string name;
+	Symbol name;
 
-	NIdentifier(const std::string & name, const Position & pos){
+	// Variable of identifier (or declared by it) set by Resolver:
+	// count of scopes up from the current one and slot in that scope
+	uint32_t depth = 0;
+	uint32_t slot = 0;
+	// Identifier refers to global that may be not defined yet when it's evaluated
+	bool check_defined = false;
+
+	NIdentifier(const Symbol & name, const uint32_t & offset){
 		this->name = name;
+		this->offset = offset;
 	}
 
 	virtual std::string to_string() override {
-		return "[NIdentifier] " + name;
+		return "[NIdentifier] " + std::string(symbol_str(name));
 	}
 
 	virtual bool compare(const NIdentifier & id){
 		return name == id.name;
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
 };
 
 struct NBlock : NExpression {
 	StatementList statements;
 
-	NBlock(const Position & pos) : pos(pos) {}
+	// Count of slots of block scope set by Resolver,
+	// block without own scope (no declarations or body of function or `for`) has 0
+	uint32_t slot_count = 0;
+
+	NBlock(const uint32_t & offset) : offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "[NBlock] " + statement_list_to_string(statements);
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 ////////////////////
@@ -186,43 +224,53 @@ struct NInfixOp : NExpression {
 	NExpression & left;
 	Operator op;
 	NExpression & right;
+	// Note: Operator function of type is cached by node (see OperatorCache)
+	OperatorCache cache;
 
-	NInfixOp(NExpression & left, const Operator & op, NExpression & right, const Position & pos)
-			: left(left), op(op), right(right), pos(pos) {}
+	NInfixOp(NExpression & left, const Operator & op, NExpression & right, const uint32_t & offset)
+			: left(left), op(op), right(right), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "[NInfixOp] " + left.to_string() + " " + op_to_str(op) + " " + right.to_string();
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 struct NPrefixOp : NExpression {
 	Operator op;
 	NExpression & right;
+	OperatorCache cache;
 
-	NPrefixOp(const Operator & op, NExpression & right, const Position & pos)
-			 : op(op), right(right), pos(pos) {}
+	NPrefixOp(const Operator & op, NExpression & right, const uint32_t & offset)
+			 : op(op), right(right), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "[NPrefixOp] " + op_to_str(op) + " " + right.to_string();
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 struct NPostfixOp : NExpression {
 	NExpression & left;
 	Operator op;
+	OperatorCache cache;
 
-	NPostfixOp(NExpression & left, const Operator & op, const Position & pos)
-			  : left(left), op(op), pos(pos) {}
+	NPostfixOp(NExpression & left, const Operator & op, const uint32_t & offset)
+			  : left(left), op(op), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "[NPostfixOp] " + left.to_string() + " " + op_to_str(op);
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 // NType contains special type syntax
@@ -232,52 +280,68 @@ struct NPostfixOp : NExpression {
 struct NType : NExpression {
 	bool nullable = false;
 
-	NType(const Position & pos) : pos(pos) {}
+	NType(const uint32_t & offset) : offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "[NType]";
 	}
 
-	virtual bool compare(NType * type) {
+	// Note: Shared types are unique, so they're compared by pointer
+	bool compare(NType * type){
+		if(this == type){
+			return true;
+		}
+		if(shared && type->shared){
+			return false;
+		}
+		return compare_structure(type);
+	}
+
+	virtual bool compare_structure(NType * type){
 		return type->nullable == nullable;
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
 };
 
 struct NIdentifierType : NType {
 	NIdentifier & id;
 
-	NIdentifierType(NIdentifier & id, const Position & pos) : id(id), pos(pos) {}
+	NIdentifierType(NIdentifier & id, const uint32_t & offset) : id(id), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return id.to_string() + (nullable ? "?" : "");
 	}
 
-	virtual bool compare(NType * type) override {
+	virtual bool compare_structure(NType * type) override {
 		NIdentifierType * id_type = dynamic_cast<NIdentifierType*>(type);
-		return id_type && NType::compare(type) && id.compare(id_type->id);
+		return id_type && NType::compare_structure(type) && id.compare(id_type->id);
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 struct NListType : NType {
 	NType & wrapped_type;
 	
-	NListType(NType & wrapped_type, const Position & pos)
-			 : wrapped_type(wrapped_type), pos(pos) {}
+	NListType(NType & wrapped_type, const uint32_t & offset)
+			 : wrapped_type(wrapped_type), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "[" + wrapped_type.to_string() + "]" + (nullable ? "?" : "");
 	}
 
-	virtual bool compare(NType * type) override {
+	virtual bool compare_structure(NType * type) override {
 		NListType * list_type = dynamic_cast<NListType*>(type);
-		return list_type && NType::compare(type) && wrapped_type.compare(&list_type->wrapped_type);
+		return list_type && NType::compare_structure(type) && wrapped_type.compare(&list_type->wrapped_type);
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 struct NTupleType : NType {
@@ -285,8 +349,8 @@ struct NTupleType : NType {
 
 	// TODO: Add default values
 
-	NTupleType(const std::vector <NType*> types, const Position & pos)
-			  : types(types), pos(pos) {}
+	NTupleType(const std::vector <NType*> types, const uint32_t & offset)
+			  : types(types), offset(offset) {}
 
 	virtual std::string to_string() override {
 		std::string str = "(";
@@ -296,28 +360,27 @@ struct NTupleType : NType {
 				str += ", ";
 			}
 		}
-		return str + ")";
+		return str + ")" + (nullable ? "?" : "");
 	}
 
-	virtual bool compare(NType * type) override {
+	virtual bool compare_structure(NType * type) override {
 		NTupleType * tuple_type = dynamic_cast<NTupleType*>(type);
+		if(!tuple_type || !NType::compare_structure(type) || types.size() != tuple_type->types.size()){
+			return false;
+		}
 
-		bool types_comparison = true;
-		if(types.size() != tuple_type->types.size()){
-			types_comparison = false;
-		}else{
-			for(int i = 0; i < types.size(); i++){
-				if(types[i]->compare(tuple_type->types[i])){
-					types_comparison = false;
-					break;
-				}
+		for(size_t i = 0; i < types.size(); i++){
+			if(!types[i]->compare(tuple_type->types[i])){
+				return false;
 			}
 		}
 
-		return tuple_type && NType::compare(type) && types_comparison; 
+		return true;
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 // In type declaration there cannot be any case when it's declared but not defined
@@ -327,14 +390,16 @@ struct NTypeDecl : NStatement {
 	NIdentifier & id;
 	NType & type;
 
-	NTypeDecl(NIdentifier & id, NType & type, const Position & pos)
-			 : id(id), type(type), pos(pos) {}
+	NTypeDecl(NIdentifier & id, NType & type, const uint32_t & offset)
+			 : id(id), type(type), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "type "+ id.to_string() +" = "+ type.to_string();
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 struct NVarDecl : NStatement {
@@ -348,9 +413,9 @@ struct NVarDecl : NStatement {
 			 NIdentifier & id,
 			 NType * type,
 			 NExpression * assignment_expr,
-			 const Position & pos)
+			 const uint32_t & offset)
 			: is_val(is_val), id(id), type(type),
-			  assignment_expr(assignment_expr), pos(pos) {}
+			  assignment_expr(assignment_expr), offset(offset) {}
 
 
 	virtual std::string to_string() override {
@@ -359,7 +424,9 @@ struct NVarDecl : NStatement {
 			   (assignment_expr ? " = " + assignment_expr->to_string() : "");
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 inline std::string var_list_to_string(const VarList & var_list){
@@ -377,8 +444,8 @@ struct NArgDecl : NStatement {
 	NType * type;
 	NExpression * default_value;
 
-	NArgDecl(NIdentifier & id, NType * type, NExpression * default_value, const Position & pos)
-			: id(id), type(type), default_value(default_value), pos(pos) {}
+	NArgDecl(NIdentifier & id, NType * type, NExpression * default_value, const uint32_t & offset)
+			: id(id), type(type), default_value(default_value), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return id.to_string() + 
@@ -386,7 +453,9 @@ struct NArgDecl : NStatement {
 			   (default_value != nullptr ? " = " + default_value->to_string() : "");
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 inline std::string arg_list_to_string(const ArgList & arg_list){
@@ -401,26 +470,30 @@ struct NFuncCall : NExpression {
 	NExpression & left;
 	ExpressionList args;
 
-	NFuncCall(NExpression & left, const ExpressionList & args, const Position & pos)
-			: left(left), args(args), pos(pos) {}
+	NFuncCall(NExpression & left, const ExpressionList & args, const uint32_t & offset)
+			: left(left), args(args), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "[NFuncCall] " + left.to_string() + "(" + expression_list_to_string(args, ", ") + ")";
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 struct NReturn : NStatement {
 	NExpression * right;
 
-	NReturn(NExpression * right, const Position & pos) : right(right), pos(pos) {}
+	NReturn(NExpression * right, const uint32_t & offset) : right(right), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "return " + (right ? right->to_string() : "");
 	}
 
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 struct NFuncDecl : NStatement {
@@ -429,12 +502,15 @@ struct NFuncDecl : NStatement {
 	NType * return_type;
 	NBlock & block;
 
+	// Count of slots of function scope (arguments and locals of body) set by Resolver
+	uint32_t slot_count = 0;
+
 	NFuncDecl(NIdentifier & id,
 			  const ArgList & args,
 			  NType * return_type,
 			  NBlock & block,
-			  const Position & pos)
-			: id(id), args(args), return_type(return_type), block(block), pos(pos) {}
+			  const uint32_t & offset)
+			: id(id), args(args), return_type(return_type), block(block), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return  "func " + id.to_string() + "(" + arg_list_to_string(args) + ")" +
@@ -442,7 +518,9 @@ struct NFuncDecl : NStatement {
 				"{\n" + block.to_string() + "\n}";
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 
@@ -454,22 +532,24 @@ struct NListAccess : NExpression {
 	NExpression & left;
 	NExpression & access;
 
-	NListAccess(NExpression & left, NExpression & access, const Position & pos)
-			   : left(left), access(access), pos(pos) {}
+	NListAccess(NExpression & left, NExpression & access, const uint32_t & offset)
+			   : left(left), access(access), offset(offset) {}
 
 
 	virtual std::string to_string() override {
 		return "[NListAccess] " + left.to_string() + "[" + access.to_string() + "]";
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 struct NList : NExpression {
 	ExpressionList expressions;
 
-	NList(const ExpressionList & expressions, const Position & pos)
-		 : expressions(expressions), pos(pos) {}
+	NList(const ExpressionList & expressions, const uint32_t & offset)
+		 : expressions(expressions), offset(offset) {}
 
 	virtual std::string to_string() override {
 		std::string str = "[";
@@ -482,7 +562,9 @@ struct NList : NExpression {
 		return str + "]";
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 // Note: !Important! `if` is an expression
@@ -495,8 +577,8 @@ struct NCondition : NExpression {
 	NCondition(ConditionBlock & If,
 			   const std::vector <ConditionBlock> & Elifs,
 			   NBlock * Else,
-			   const Position & pos)
-			  : If(If), Elifs(Elifs), Else(Else), pos(pos) {}
+			   const uint32_t & offset)
+			  : If(If), Elifs(Elifs), Else(Else), offset(offset) {}
 
 	virtual std::string to_string() override {
 		std::string elifs_str;
@@ -507,21 +589,25 @@ struct NCondition : NExpression {
 			   elifs_str + "else{" + (Else != nullptr ? Else->to_string() : "") + "}";
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 struct NWhile : NStatement {
 	NExpression & condition;
 	NBlock & block;
 
-	NWhile(NExpression & condition, NBlock & block, const Position & pos)
-		  : condition(condition), block(block), pos(pos) {}
+	NWhile(NExpression & condition, NBlock & block, const uint32_t & offset)
+		  : condition(condition), block(block), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "while("+ condition.to_string() +"){\n"+ block.to_string() +"\n}";
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 // TODO: Think about for `For`
@@ -531,14 +617,19 @@ struct NFor : NStatement {
 	NExpression & In;
 	NBlock & block;
 
-	NFor(NIdentifier & For, NExpression & In, NBlock & block, const Position & pos)
-		: For(For), In(In), block(block), pos(pos) {}
+	// Count of slots of iteration scope (loop variable and locals of body) set by Resolver
+	uint32_t slot_count = 0;
+
+	NFor(NIdentifier & For, NExpression & In, NBlock & block, const uint32_t & offset)
+		: For(For), In(In), block(block), offset(offset) {}
 
 	virtual std::string to_string() override {
 		return "for("+ For.to_string() +" in "+ In.to_string() +"){\n"+ block.to_string() +"\n}";
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
 };
 
 typedef std::pair<ExpressionList, NBlock*> MatchCase;
@@ -551,8 +642,8 @@ struct NMatch : NStatement {
 	NMatch(NExpression & expression,
 		   const std::vector <MatchCase> Cases,
 		   NBlock * Else,
-		   const Position & pos)
-		 : expression(expression), Cases(Cases), Else(Else), pos(pos) {}
+		   const uint32_t & offset)
+		 : expression(expression), Cases(Cases), Else(Else), offset(offset) {}
 
 	virtual std::string to_string() override {
 		std::string cases_string;
@@ -562,7 +653,30 @@ struct NMatch : NStatement {
 		return "match("+ expression.to_string() +"){\n" + cases_string + "else => " + (Else ? Else->to_string() : "") +"}";
 	}
 	
-	virtual Object * eval(Scope * scope) override;
+	virtual Value eval(Scope * scope) override;
+	virtual NodeIndex flatten(FlatTree & tree) override;
+	virtual void get_children(std::vector <Node*> & children) override;
+};
+
+////////////////
+// Error node //
+////////////////
+
+// NError stands for the part of code that Parser could not parse in recovery mode,
+// the error itself is in Parser diagnostics.
+// Note: NError is NType, so it can replace both expression and type
+struct NError : NType {
+	NError(const uint32_t & offset) : offset(offset) {}
+
+	virtual std::string to_string() override {
+		return "[NError]";
+	}
+
+	virtual bool compare_structure(NType *) override {
+		return false;
+	}
+
+	virtual NodeIndex flatten(FlatTree & tree) override;
 };
 
 #endif // NODE_H
\ No newline at end of file
@@ -0,0 +1,115 @@
+/**
+ * AstCache must load the tree it stored and must miss (not crash) on truncated file
+ * and on header with counts that don't match the file, including counts that wrap around in 32 bits.
+ *
+ * Build: g++ -std=c++20 -O2 -Isrc test/AstCacheTest.cpp src/AstCache.cpp src/FlatTree.cpp src/Parser.cpp \
+ *        src/Lexer.cpp src/Node.cpp src/Object.cpp src/Heap.cpp src/Source.cpp src/Interner.cpp src/LineIndex.cpp \
+ *        src/Trace.cpp src/Arena.cpp src/HashCons.cpp -o ast_cache_test
+ * Returns non-zero if some check failed.
+ */
+
+#include "AstCache.h"
+#include "Lexer.h"
+#include "Parser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+static uint32_t failed = 0;
+
+static void check(const bool & ok, const std::string & name){
+	if(!ok){
+		std::cout << "FAILED: " << name << std::endl;
+		failed++;
+	}
+}
+
+// Offsets of header fields in cache file (see `AstCache::Header`)
+static const size_t NODES_FIELD = 20;
+static const size_t EXTRA_FIELD = 24;
+static const size_t CHARS_FIELD = 36;
+
+// Note: Symbols are interned by this process, so loaded tree has the same symbols as stored one
+static bool same_tree(const FlatTree & a, const FlatTree & b){
+	if(a.size() != b.size() || !std::equal(a.get_roots().begin(), a.get_roots().end(), b.get_roots().begin(), b.get_roots().end())){
+		return false;
+	}
+	for(NodeIndex node = 0; node < a.size(); node++){
+		if(a.get_kind(node) != b.get_kind(node) || a.get_flags(node) != b.get_flags(node) || a.get_offset(node) != b.get_offset(node)
+		|| a.get_lhs(node) != b.get_lhs(node) || a.get_rhs(node) != b.get_rhs(node)){
+			return false;
+		}
+	}
+	return true;
+}
+
+static std::string read_file(const std::string & path){
+	std::ifstream file(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator <char>(file), std::istreambuf_iterator <char>());
+}
+
+static void write_file(const std::string & path, const std::string & data){
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(data.data(), data.size());
+}
+
+static uint32_t get_field(const std::string & data, const size_t & offset){
+	uint32_t value;
+	std::memcpy(&value, data.data() + offset, sizeof(value));
+	return value;
+}
+
+static void set_field(std::string & data, const size_t & offset, const uint32_t & value){
+	std::memcpy(data.data() + offset, &value, sizeof(value));
+}
+
+int main(){
+	const std::string script = (std::filesystem::temp_directory_path() / "jacy_ast_cache_test.jc").string();
+	const std::string cache_file = script + ".astc";
+	const std::string code = "var alpha = 1\nval beta = alpha + 2\nfunc gamma(delta){ return delta * beta }\nprint(gamma(3))\n";
+
+	Lexer lexer;
+	Parser parser;
+	lexer.open(code);
+	const FlatTree tree = parser.parse_flat(lexer);
+
+	AstCache cache;
+	check(cache.store(script.c_str(), code, tree), "store");
+	const std::string stored = read_file(cache_file);
+
+	FlatTree loaded;
+	check(cache.load(script.c_str(), code, loaded), "load of stored cache");
+	check(same_tree(loaded, tree), "loaded tree");
+
+	write_file(cache_file, stored.substr(0, stored.size() - 1));
+	check(!cache.load(script.c_str(), code, loaded), "truncated file is a miss");
+
+	std::string inflated = stored;
+	set_field(inflated, NODES_FIELD, get_field(stored, NODES_FIELD) + 1);
+	write_file(cache_file, inflated);
+	check(!cache.load(script.c_str(), code, loaded), "inflated count of nodes is a miss");
+
+	// Note: Counts are moved between nodes, extra and chars, so their sum computed in 32 bits
+	// (nodes * 3 + extra wraps around) gives the size of file, only wider sum sees the difference.
+	// Moved count is even, so padding of node kinds and flags grows exactly by 2 bytes per node
+	const uint32_t moved = (get_field(stored, EXTRA_FIELD) / 3 + 2) & ~1u;
+	check(get_field(stored, CHARS_FIELD) >= moved * 2, "code has enough chars for wrapped header");
+	std::string wrapped = stored;
+	set_field(wrapped, NODES_FIELD, get_field(stored, NODES_FIELD) + moved);
+	set_field(wrapped, EXTRA_FIELD, get_field(stored, EXTRA_FIELD) - moved * 3);
+	set_field(wrapped, CHARS_FIELD, get_field(stored, CHARS_FIELD) - moved * 2);
+	write_file(cache_file, wrapped);
+	check(!cache.load(script.c_str(), code, loaded), "header with counts wrapping around is a miss");
+
+	std::filesystem::remove(cache_file);
+
+	if(failed){
+		std::cout << failed << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,263 @@
+/**
+ * IncrementalParser must give the same segments, tokens, tree (with node offsets) and errors
+ * as fresh parsing of edited code, and edit followed by its undo must give the state before edit.
+ *
+ * Build: g++ -std=c++20 -O2 -Isrc test/IncrementalParserTest.cpp src/IncrementalParser.cpp src/StatementSplit.cpp \
+ *        src/Parser.cpp src/Lexer.cpp src/Node.cpp src/Object.cpp src/Heap.cpp src/Source.cpp src/Interner.cpp \
+ *        src/LineIndex.cpp src/Trace.cpp src/Arena.cpp src/HashCons.cpp src/FlatTree.cpp -o incremental_parser_test
+ * Returns non-zero if some check failed.
+ */
+
+#include "IncrementalParser.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <chrono>
+
+static uint32_t failed = 0;
+
+static void check(const bool & ok, const std::string & name){
+	if(!ok){
+		std::cout << "FAILED: " << name << std::endl;
+		failed++;
+	}
+}
+
+// Tokens with absolute offsets, statements with absolute offsets of all their nodes and errors
+static std::string dump(const IncrementalParser & parser){
+	std::string str;
+	for(const IncrementalParser::Segment & segment : parser.get_segments()){
+		std::vector <Token> tokens;
+		IncrementalParser::get_tokens(segment, segment.begin, tokens);
+		for(const Token & token : tokens){
+			str += std::to_string(token.type) + ":" + std::to_string(token.offset) + ":"
+				 + std::to_string(token.length) + ":" + std::to_string(token.val) + " ";
+		}
+		str += "|\n";
+		for(NStatement * statement : segment.statements){
+			str += statement->to_string() + "\n";
+		}
+		IncrementalParser::walk(segment, segment.begin, [&str](Node *, const uint32_t & offset){
+			str += std::to_string(offset) + " ";
+		});
+		str += "\n" + segment.error + "\n";
+	}
+	return str;
+}
+
+static std::string fresh_dump(std::string_view code){
+	IncrementalParser parser;
+	parser.parse(code);
+	return dump(parser);
+}
+
+static void test_undo_after_semicolon(){
+	IncrementalParser parser;
+	parser.parse("x = 1;\n// c\nq = 1\n");
+	const std::string before = dump(parser);
+
+	parser.edit(8, 0, "+");
+	check(dump(parser) == fresh_dump(parser.get_code()), "edit after `;` and comment");
+	parser.edit(8, 1, "");
+	check(dump(parser) == before, "undo of edit after `;` and comment");
+	check(parser.get_tree().size() == 2, "statements after undo");
+}
+
+static void test_block_splice(){
+	std::string code = "func f(a) {\n";
+	for(uint32_t i = 0; i < 100; i++){
+		code += "\tval x" + std::to_string(i) + " = a + " + std::to_string(i) + "\n";
+	}
+	code += "\tif(a){\n\t\treturn 1\n\t}\n\treturn a\n}\nprint(f(1))\n";
+
+	IncrementalParser parser;
+	parser.parse(code);
+	const std::string before = dump(parser);
+
+	const uint32_t offset = code.find("x50 = a") + 7;
+	parser.edit(offset, 0, " * 2");
+	check(parser.spliced_blocks() == 1 && parser.reparsed_segments() == 0, "statement of function body is spliced");
+	check(dump(parser) == fresh_dump(parser.get_code()), "spliced statement");
+	parser.edit(offset, 4, "");
+	check(dump(parser) == before, "undo of spliced statement");
+
+	// Note: New statement is inserted, nested block is changed
+	parser.edit(code.find("val x10 ="), 0, "print(a)\n\t");
+	check(parser.spliced_blocks() == 1, "inserted statement is spliced");
+	check(dump(parser) == fresh_dump(parser.get_code()), "inserted statement");
+	parser.edit(parser.get_code().find("return 1") + 7, 1, "2");
+	check(parser.spliced_blocks() == 1, "statement of nested block is spliced");
+	check(dump(parser) == fresh_dump(parser.get_code()), "statement of nested block");
+
+	// Note: Brackets are changed, so the whole function is parsed
+	parser.edit(parser.get_code().find("x20 ="), 0, "{");
+	check(parser.spliced_blocks() == 0, "unbalanced edit is not spliced");
+	check(dump(parser) == fresh_dump(parser.get_code()), "unbalanced edit");
+}
+
+static void test_random_edits(const uint32_t & seed, const uint32_t & nested_tokens){
+	const std::string code =
+		"val a = 1\n"
+		"func f(x, y = 2) {\n"
+		"\tvar s = 0\n"
+		"\tfor(i in range(x)){\n"
+		"\t\ts += i * y; s -= 1\n"
+		"\t}\n"
+		"\tif(s > 10){ return s }\n"
+		"\telif(s < 0){\n"
+		"\t\treturn -s\n"
+		"\t}\n"
+		"\telse { return 0 }\n"
+		"}\n"
+		"// comment\n"
+		"val l = [1, 2, [3]]\n"
+		"while(a < 10){ a++ }\n"
+		"print(f(a) + l[0]);\n"
+		"/* block\n comment */ print(\"s\")\n";
+	const char * snippets[] = {
+		" ", "\n", "x", "1", " + 2", "(", ")", "{", "}", "[", "]", "// ", "/*", "*/",
+		"\"", ";", ".", "-", "e5", "val q = 3\n", "func g() {\n", "\n}\n", "if(a){ b = 1 }\n"
+	};
+
+	std::mt19937 rng(seed);
+	IncrementalParser parser(nested_tokens);
+	parser.parse(code);
+	for(uint32_t i = 0; i < 2000; i++){
+		const std::string before_code(parser.get_code());
+		const std::string before = dump(parser);
+
+		const uint32_t offset = rng() % (before_code.size() + 1);
+		uint32_t removed = 0;
+		std::string inserted;
+		if(rng() % 3 == 0){
+			removed = std::min <uint32_t>(rng() % 8, before_code.size() - offset);
+		}else{
+			inserted = snippets[rng() % std::size(snippets)];
+		}
+
+		parser.edit(offset, removed, inserted);
+		if(dump(parser) != fresh_dump(parser.get_code())){
+			check(false, "random edit " + std::to_string(i) + " of seed " + std::to_string(seed)
+				  + " with nested blocks of " + std::to_string(nested_tokens) + " tokens");
+			return;
+		}
+		if(rng() % 2){
+			parser.edit(offset, inserted.size(), before_code.substr(offset, removed));
+			if(parser.get_code() != before_code || dump(parser) != before){
+				check(false, "undo of random edit " + std::to_string(i) + " of seed " + std::to_string(seed)
+					  + " with nested blocks of " + std::to_string(nested_tokens) + " tokens");
+				return;
+			}
+		}
+	}
+}
+
+// Edits inside of function with nested blocks, mostly they keep brackets, so they're spliced into blocks
+static void test_random_block_edits(const uint32_t & seed, const uint32_t & nested_tokens){
+	std::string code = "val a = 1\nfunc f(x) {\n";
+	for(uint32_t i = 0; i < 30; i++){
+		code += "\tval v" + std::to_string(i) + " = x * " + std::to_string(i) + "\n";
+		if(i % 5 == 0){
+			code += "\tif(x > " + std::to_string(i) + "){\n\t\tx = x - 1\n\t\tfor(i in range(x)){ a += i }\n\t}\n";
+		}
+		if(i % 7 == 3){
+			code += "\twhile(x < 10){\n\t\tx += 1\n\t}\n\telse_part(x); x = 2\n";
+		}
+	}
+	code += "\treturn x\n}\nprint(f(a))\n";
+	const char * snippets[] = {
+		" ", "\n", "\t", "x", "1", " + 2", ".", ";", "// c\n", "val q = 3\n", "if(a){ b = 1 }\n", "elif(b){ c }\n", "{ d }", "(e)"
+	};
+
+	std::mt19937 rng(seed);
+	IncrementalParser parser(nested_tokens);
+	parser.parse(code);
+	uint32_t spliced = 0;
+	const uint32_t edits = 1000;
+	for(uint32_t i = 0; i < edits; i++){
+		const std::string before_code(parser.get_code());
+		const std::string before = dump(parser);
+
+		// Note: Edits are inside of function body
+		const uint32_t body = before_code.find('{') + 1;
+		const uint32_t offset = body + rng() % (before_code.rfind('}') - body);
+		uint32_t removed = 0;
+		std::string inserted;
+		if(rng() % 4 == 0){
+			removed = std::min <uint32_t>(rng() % 3 + 1, before_code.size() - offset);
+		}else{
+			inserted = snippets[rng() % std::size(snippets)];
+		}
+
+		parser.edit(offset, removed, inserted);
+		spliced += parser.spliced_blocks();
+		const std::string name = " of seed " + std::to_string(seed) + " with nested blocks of " + std::to_string(nested_tokens) + " tokens";
+		if(dump(parser) != fresh_dump(parser.get_code())){
+			check(false, "random block edit " + std::to_string(i) + name);
+			return;
+		}
+		parser.edit(offset, inserted.size(), before_code.substr(offset, removed));
+		spliced += parser.spliced_blocks();
+		if(parser.get_code() != before_code || dump(parser) != before){
+			check(false, "undo of random block edit " + std::to_string(i) + name);
+			return;
+		}
+	}
+	check(spliced > edits / 2, "random block edits are spliced");
+}
+
+// Keystrokes in body of 50k-line function must take less than a millisecond,
+// they're spliced into its block without lexing or moving the rest of it
+static void test_large_function(){
+	std::string code = "func f(a) {\n";
+	for(uint32_t i = 0; i < 50000; i++){
+		if(i % 10 == 5){
+			code += "\tif(a > " + std::to_string(i) + "){\n\t\ta = a - 1\n\t}\n";
+		}else{
+			code += "\tval x" + std::to_string(i) + " = a + " + std::to_string(i) + "\n";
+		}
+	}
+	code += "\treturn a\n}\nprint(f(1))\n";
+
+	IncrementalParser parser;
+	parser.parse(code);
+	std::mt19937 rng(1);
+	const uint32_t edits = 200;
+	double total = 0;
+	uint32_t relexed = 0;
+	bool spliced = true;
+	for(uint32_t i = 0; i < edits; i++){
+		// Note: Digit is inserted and then removed in random `val` statement
+		const uint32_t offset = code.find(" = a + ", rng() % (code.size() - 100)) + 7;
+		for(const bool & undo : {false, true}){
+			const auto start = std::chrono::steady_clock::now();
+			parser.edit(offset, undo ? 1 : 0, undo ? "" : "1");
+			total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			relexed = std::max(relexed, parser.relexed_tokens());
+			spliced = spliced && parser.spliced_blocks() == 1 && parser.reparsed_segments() == 0;
+		}
+	}
+	check(spliced, "edits of large function are spliced");
+	check(relexed < 32, "edits of large function relex only edited statements");
+	check(total / (edits * 2) < 1, "average edit of large function takes less than 1ms");
+
+	parser.edit(code.find("x25000 =") + 8, 0, " 2 *");
+	check(dump(parser) == fresh_dump(parser.get_code()), "edit of large function");
+}
+
+int main(){
+	test_undo_after_semicolon();
+	test_block_splice();
+	for(uint32_t seed = 1; seed <= 5; seed++){
+		test_random_edits(seed, 256);
+		// Note: Every block is nested then
+		test_random_edits(seed, 0);
+		test_random_block_edits(seed, 0);
+		test_random_block_edits(seed, 16);
+	}
+	test_large_function();
+
+	std::cout << (failed ? "Failed checks: " + std::to_string(failed) : std::string("All checks passed")) << std::endl;
+	return failed ? 1 : 0;
+}